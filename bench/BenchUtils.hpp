@@ -0,0 +1,126 @@
+#pragma once
+
+#include "../src/cad/LogicBlock.hpp"
+#include "../src/cad/Router.hpp"
+#include "../src/fabric/Fabric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace vfpga::bench {
+
+// Swallows std::cout/std::cerr for its lifetime (the CAD stages log progress)
+class ScopedSilence {
+public:
+  ScopedSilence()
+      : saved_out(std::cout.rdbuf(&null_buffer)),
+        saved_err(std::cerr.rdbuf(&null_buffer)) {}
+  ~ScopedSilence() {
+    std::cout.rdbuf(saved_out);
+    std::cerr.rdbuf(saved_err);
+  }
+
+private:
+  struct NullBuffer : std::streambuf {
+    int overflow(int c) override { return c; }
+  } null_buffer;
+  std::streambuf *saved_out;
+  std::streambuf *saved_err;
+};
+
+// Resident set size in bytes: the current value, or the high-water mark
+// since the last reset_peak_rss(). Returns 0 where /proc is unavailable.
+inline size_t rss_bytes(bool peak = false) {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  const std::string field = peak ? "VmHWM:" : "VmRSS:";
+  while (std::getline(status, line))
+    if (line.compare(0, field.size(), field) == 0)
+      return std::stoull(line.substr(field.size())) * 1024; // Reported in kB
+  return 0;
+}
+
+// Reset the RSS high-water mark (Linux >= 4.0), so peak memory can be
+// attributed to a single benchmark. Freed heap is returned to the OS first,
+// or later allocations would reuse it without raising the mark.
+inline void reset_peak_rss() {
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+}
+
+// Smallest square fabric with enough CLB tiles for n blocks
+inline int fabric_side_for(size_t n) {
+  int side = static_cast<int>(std::ceil(std::sqrt(n * 1.3))) + 2;
+  return std::max(side, 8);
+}
+
+// Random DAG of CLB blocks: block i drives net i and reads up to
+// 'fanin' nets driven by earlier blocks.
+inline std::vector<LogicBlock> make_blocks(size_t n, int fanin = 3,
+                                           uint32_t seed = 1) {
+  std::mt19937 rng(seed);
+  std::vector<LogicBlock> blocks;
+  blocks.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    blocks.emplace_back(static_cast<int>(i), "blk" + std::to_string(i));
+    LogicBlock &b = blocks.back();
+    b.use_lut = true;
+    b.output_net = static_cast<NetId>(i);
+    for (int k = 0; k < fanin && i > 0; ++k) {
+      std::uniform_int_distribution<size_t> pick(0, i - 1);
+      b.input_nets.push_back(static_cast<NetId>(pick(rng)));
+    }
+  }
+  return blocks;
+}
+
+// Legal random placement without running the annealer
+inline std::map<int, std::pair<int, int>>
+random_placement(const Fabric &fabric, const std::vector<LogicBlock> &blocks,
+                 uint32_t seed = 1) {
+  std::vector<std::pair<int, int>> clb_tiles;
+  for (const auto &tile : fabric.grid)
+    if (tile.type == TileType::CLB)
+      clb_tiles.push_back({tile.x, tile.y});
+  std::mt19937 rng(seed);
+  std::shuffle(clb_tiles.begin(), clb_tiles.end(), rng);
+
+  std::map<int, std::pair<int, int>> placement;
+  for (size_t i = 0; i < blocks.size(); ++i)
+    placement[blocks[i].id] = clb_tiles.at(i);
+  return placement;
+}
+
+// Source -> sinks connectivity of a placed design, as the router reports it
+inline std::vector<Router::Net>
+make_nets(const std::vector<LogicBlock> &blocks,
+          const std::map<int, std::pair<int, int>> &placement) {
+  std::map<NetId, Router::Net> by_id;
+  for (const auto &b : blocks) {
+    auto [x, y] = placement.at(b.id);
+    if (b.output_net != NO_NET)
+      by_id[b.output_net].source = {x, y};
+    for (NetId net : b.input_nets)
+      by_id[net].sinks.push_back({x, y});
+  }
+  std::vector<Router::Net> nets;
+  for (auto &[id, net] : by_id)
+    if (!net.sinks.empty())
+      nets.push_back(net);
+  return nets;
+}
+
+} // namespace vfpga::bench
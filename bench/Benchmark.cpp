@@ -0,0 +1,181 @@
+#include "Benchmark.hpp"
+#include "../src/utils/json.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+using json = nlohmann::json;
+
+namespace vfpga::bench {
+
+std::vector<Benchmark *> &registry() {
+  static std::vector<Benchmark *> benchmarks;
+  return benchmarks;
+}
+
+Benchmark *register_benchmark(const std::string &name, Benchmark::Function fn) {
+  // Registrations live for the whole program
+  static std::vector<std::unique_ptr<Benchmark>> storage;
+  storage.push_back(std::make_unique<Benchmark>(name, std::move(fn)));
+  registry().push_back(storage.back().get());
+  return storage.back().get();
+}
+
+namespace {
+
+constexpr int64_t MAX_ITERATIONS = 1'000'000'000;
+
+std::string run_name(const Benchmark &b, const std::vector<int64_t> &args) {
+  std::string name = b.name;
+  for (int64_t a : args)
+    name += "/" + std::to_string(a);
+  return name;
+}
+
+// Grow the iteration count until a run takes at least min_time seconds,
+// the same strategy Google Benchmark uses.
+State run_one(const Benchmark &b, const std::vector<int64_t> &args,
+              double min_time) {
+  int64_t iters = 1;
+  while (true) {
+    State state(args, iters);
+    b.fn(state);
+    double seconds = state.real_ns / 1e9;
+    if (seconds >= min_time || iters >= MAX_ITERATIONS)
+      return state;
+
+    double multiplier = seconds > 1e-9 ? min_time * 1.4 / seconds : 10.0;
+    multiplier = std::clamp(multiplier, 2.0, 10.0);
+    iters = std::min<int64_t>(MAX_ITERATIONS,
+                              static_cast<int64_t>(iters * multiplier));
+  }
+}
+
+std::string format_time(double ns) {
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(ns < 10 ? 2 : 0) << ns << " ns";
+  return os.str();
+}
+
+} // namespace
+
+int run_benchmarks(int argc, char **argv) {
+  std::string filter = ".";
+  std::string out_path;
+  double min_time = 0.5;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value = [&](const std::string &flag) -> std::optional<std::string> {
+      if (arg.rfind(flag + "=", 0) == 0)
+        return arg.substr(flag.size() + 1);
+      return std::nullopt;
+    };
+    if (auto v = value("--benchmark_filter")) {
+      filter = *v;
+    } else if (auto v = value("--benchmark_out")) {
+      out_path = *v;
+    } else if (auto v = value("--benchmark_min_time")) {
+      min_time = std::stod(*v);
+    } else if (arg == "--benchmark_list_tests") {
+      for (const Benchmark *b : registry())
+        for (const auto &args : b->arg_sets.empty()
+                                    ? std::vector<std::vector<int64_t>>{{}}
+                                    : b->arg_sets)
+          std::cout << run_name(*b, args) << std::endl;
+      return 0;
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      std::cerr << "Usage: vfpga_bench [--benchmark_filter=<regex>] "
+                   "[--benchmark_min_time=<sec>] [--benchmark_out=<file>] "
+                   "[--benchmark_list_tests]"
+                << std::endl;
+      return 2;
+    }
+  }
+
+  std::regex pattern(filter);
+
+  json results = json::array();
+  std::cout << std::left << std::setw(48) << "Benchmark" << std::right
+            << std::setw(16) << "Time" << std::setw(16) << "CPU"
+            << std::setw(14) << "Iterations" << std::endl;
+  std::cout << std::string(94, '-') << std::endl;
+
+  for (const Benchmark *b : registry()) {
+    std::vector<std::vector<int64_t>> arg_sets = b->arg_sets;
+    if (arg_sets.empty())
+      arg_sets.push_back({});
+
+    for (const auto &args : arg_sets) {
+      std::string name = run_name(*b, args);
+      if (!std::regex_search(name, pattern))
+        continue;
+
+      State state = run_one(*b, args, b->min_time >= 0 ? b->min_time : min_time);
+      double real_per_iter = state.real_ns / state.iterations();
+      double cpu_per_iter = state.cpu_ns / state.iterations();
+
+      std::cout << std::left << std::setw(48) << name << std::right
+                << std::setw(16) << format_time(real_per_iter) << std::setw(16)
+                << format_time(cpu_per_iter) << std::setw(14)
+                << state.iterations();
+      if (!state.label.empty())
+        std::cout << " " << state.label;
+      std::cout << std::endl;
+
+      json entry;
+      entry["name"] = name;
+      entry["run_name"] = name;
+      entry["run_type"] = "iteration";
+      entry["iterations"] = state.iterations();
+      entry["real_time"] = real_per_iter;
+      entry["cpu_time"] = cpu_per_iter;
+      entry["time_unit"] = "ns";
+      if (state.items_processed > 0 && state.real_ns > 0)
+        entry["items_per_second"] = state.items_processed * 1e9 / state.real_ns;
+      if (!state.label.empty())
+        entry["label"] = state.label;
+      for (const auto &[key, val] : state.counters)
+        entry[key] = val;
+      results.push_back(entry);
+    }
+  }
+
+  if (!out_path.empty()) {
+    std::time_t now = std::time(nullptr);
+    char date[64];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    json report;
+    report["context"] = {
+        {"date", date},
+        {"executable", argc > 0 ? argv[0] : "vfpga_bench"},
+        {"num_cpus", std::thread::hardware_concurrency()},
+#ifdef NDEBUG
+        {"library_build_type", "release"},
+#else
+        {"library_build_type", "debug"},
+#endif
+    };
+    report["benchmarks"] = results;
+
+    std::ofstream out(out_path);
+    if (!out.is_open()) {
+      std::cerr << "Error: could not write " << out_path << std::endl;
+      return 1;
+    }
+    out << report.dump(2) << std::endl;
+  }
+
+  return 0;
+}
+
+} // namespace vfpga::bench
@@ -0,0 +1,155 @@
+#pragma once
+
+// Minimal Google-Benchmark style harness.
+// Benchmarks are plain functions taking a State&, registered with
+// VFPGA_BENCHMARK(fn)->Arg(..)/Range(..). Results are printed as a table and
+// optionally written as Google Benchmark compatible JSON
+// (--benchmark_out=<file>), so existing tooling can compare releases.
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace vfpga::bench {
+
+class State {
+public:
+  State(std::vector<int64_t> args, int64_t iterations)
+      : args(std::move(args)), max_iterations(iterations) {}
+
+  int64_t range(size_t i = 0) const { return args.at(i); }
+  int64_t iterations() const { return max_iterations; }
+
+  // Range-for support: for (auto _ : state) { ... }
+  // Value has a user-provided destructor so '_' is not flagged as unused.
+  struct Value {
+    ~Value() {}
+  };
+  struct Iterator {
+    State *state;
+    int64_t remaining;
+    bool operator!=(const Iterator &) const {
+      if (remaining > 0)
+        return true;
+      state->stop_timer();
+      return false;
+    }
+    Iterator &operator++() {
+      --remaining;
+      return *this;
+    }
+    Value operator*() const { return {}; }
+  };
+  Iterator begin() {
+    start_timer();
+    return {this, max_iterations};
+  }
+  Iterator end() { return {this, 0}; }
+
+  // Exclude setup work inside the loop from the measurement
+  void PauseTiming() { stop_timer(); }
+  void ResumeTiming() { start_timer(); }
+
+  void SetItemsProcessed(int64_t n) { items_processed = n; }
+  void SetLabel(const std::string &l) { label = l; }
+
+  // User counters are reported verbatim in the JSON output
+  std::map<std::string, double> counters;
+
+  // Results (filled in by the runner)
+  double real_ns = 0.0;
+  double cpu_ns = 0.0;
+  int64_t items_processed = 0;
+  std::string label;
+
+private:
+  std::vector<int64_t> args;
+  int64_t max_iterations;
+  bool running = false;
+  std::chrono::steady_clock::time_point real_start;
+  std::clock_t cpu_start = 0;
+
+  void start_timer() {
+    if (running)
+      return;
+    running = true;
+    real_start = std::chrono::steady_clock::now();
+    cpu_start = std::clock();
+  }
+  void stop_timer() {
+    if (!running)
+      return;
+    running = false;
+    real_ns += std::chrono::duration<double, std::nano>(
+                   std::chrono::steady_clock::now() - real_start)
+                   .count();
+    cpu_ns += 1e9 * double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+  }
+};
+
+class Benchmark {
+public:
+  using Function = std::function<void(State &)>;
+
+  Benchmark(std::string name, Function fn)
+      : name(std::move(name)), fn(std::move(fn)) {}
+
+  Benchmark *Arg(int64_t a) {
+    arg_sets.push_back({a});
+    return this;
+  }
+  Benchmark *Args(std::vector<int64_t> a) {
+    arg_sets.push_back(std::move(a));
+    return this;
+  }
+  Benchmark *RangeMultiplier(int m) {
+    multiplier = m;
+    return this;
+  }
+  // Powers of the range multiplier from lo to hi (inclusive of both ends)
+  Benchmark *Range(int64_t lo, int64_t hi) {
+    for (int64_t v = lo; v < hi; v *= multiplier)
+      arg_sets.push_back({v});
+    arg_sets.push_back({hi});
+    return this;
+  }
+  Benchmark *MinTime(double seconds) {
+    min_time = seconds;
+    return this;
+  }
+
+  std::string name;
+  Function fn;
+  std::vector<std::vector<int64_t>> arg_sets;
+  int multiplier = 8;
+  double min_time = -1.0; // < 0: use the global --benchmark_min_time
+};
+
+std::vector<Benchmark *> &registry();
+Benchmark *register_benchmark(const std::string &name, Benchmark::Function fn);
+
+// Run all registered benchmarks, honouring --benchmark_filter,
+// --benchmark_min_time and --benchmark_out. Returns the process exit code.
+int run_benchmarks(int argc, char **argv);
+
+// Prevent the compiler from optimizing away a computed value
+template <typename T> inline void DoNotOptimize(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const T *sink;
+  sink = &value;
+#endif
+}
+
+} // namespace vfpga::bench
+
+#define VFPGA_BENCH_CONCAT2(a, b) a##b
+#define VFPGA_BENCH_CONCAT(a, b) VFPGA_BENCH_CONCAT2(a, b)
+#define VFPGA_BENCHMARK(fn)                                                    \
+  static ::vfpga::bench::Benchmark *VFPGA_BENCH_CONCAT(bench_reg_, __LINE__) = \
+      ::vfpga::bench::register_benchmark(#fn, fn)
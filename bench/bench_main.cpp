@@ -0,0 +1,5 @@
+#include "Benchmark.hpp"
+
+int main(int argc, char **argv) {
+  return vfpga::bench::run_benchmarks(argc, argv);
+}
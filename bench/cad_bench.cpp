@@ -0,0 +1,405 @@
+#include "../src/analysis/TimingAnalyzer.hpp"
+#include "../src/cad/Optimizer.hpp"
+#include "../src/cad/Packer.hpp"
+#include "../src/cad/Parser.hpp"
+#include "../src/cad/Placer.hpp"
+#include "../src/cad/Router.hpp"
+#include "../src/cad/TechMapper.hpp"
+#include "../src/flow/FlowCache.hpp"
+#include "../src/gen/DesignGenerator.hpp"
+#include "../src/utils/json.hpp"
+#include "BenchUtils.hpp"
+#include "Benchmark.hpp"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+using namespace vfpga;
+using namespace vfpga::bench;
+
+namespace {
+
+// Random range(0)-cell design written to a temp file (removed by the caller)
+std::string write_design(size_t cells) {
+  std::string path = (std::filesystem::temp_directory_path() /
+                      ("vfpga_bench_" + std::to_string(cells) + ".json"))
+                         .string();
+  GeneratorOptions options;
+  options.num_cells = cells;
+  std::ofstream out(path);
+  DesignGenerator::random(out, options);
+  return path;
+}
+
+// The same design as BLIF: LUTs as minterm covers, DFFs as latches and
+// everything else as subcircuits
+std::string write_blif_design(size_t cells) {
+  std::string json_path = write_design(cells);
+  auto netlist = Parser::from_json(json_path);
+  std::filesystem::remove(json_path);
+  std::string path = json_path.substr(0, json_path.size() - 4) + "blif";
+
+  std::ofstream out(path);
+  auto signal = [&](std::ostream &os, NetId net) -> std::ostream & {
+    if (is_wire(net))
+      return os << 'n' << netlist->net_bit(net);
+    return os << (net == CONST0_NET   ? "$false"
+                   : net == CONST1_NET ? "$true"
+                                       : "$undef");
+  };
+  auto port_net = [&](CellId c, std::string_view port) {
+    auto pin = netlist->find_pin(c, port);
+    return pin ? netlist->net_of(*pin) : NO_NET;
+  };
+
+  out << ".model top\n.names $false\n.names $true\n1\n.names $undef\n";
+  for (CellId c = 0; c < static_cast<CellId>(netlist->num_cells()); ++c) {
+    std::string_view type = netlist->cell_type(c);
+    if (type == "$lut") {
+      out << ".names";
+      auto a = netlist->find_pin(c, "A");
+      size_t k = a ? netlist->nets_of(*a).size() : 0;
+      if (a)
+        for (NetId net : netlist->nets_of(*a))
+          signal(out << ' ', net);
+      signal(out << ' ', port_net(c, "Y")) << '\n';
+      const std::string &mask = *netlist->param(c, "LUT");
+      for (size_t i = 0; i < mask.size(); ++i) {
+        if (mask[mask.size() - 1 - i] != '1')
+          continue;
+        for (size_t b = 0; b < k; ++b)
+          out << ((i >> b) & 1 ? '1' : '0');
+        out << (k ? " 1\n" : "1\n");
+      }
+    } else if (type == "DFF") {
+      signal(out << ".latch ", port_net(c, "D"));
+      signal(out << ' ', port_net(c, "Q"));
+      signal(out << " re ", port_net(c, "C")) << " 2\n";
+    } else {
+      out << ".subckt " << type;
+      for (PinId p = netlist->first_pin(c); p < netlist->end_pin(c); ++p) {
+        auto nets = netlist->nets_of(p);
+        for (size_t i = 0; i < nets.size(); ++i)
+          signal(out << ' ' << netlist->pin_name(p) << '[' << i << "]=",
+                 nets[i]);
+      }
+      out << '\n';
+    }
+  }
+  out << ".end\n";
+  return path;
+}
+
+// Parse a generated netlist from disk. peak_rss_mb is the memory high-water
+// mark above the RSS before parsing, i.e. the Netlist plus parser overhead.
+void BM_Parser_FromJson(State &state) {
+  std::string path = write_design(state.range(0));
+  size_t cells = 0, netlist_bytes = 0;
+  double peak = 0;
+  for (auto _ : state) {
+    reset_peak_rss();
+    size_t before = rss_bytes();
+    auto netlist = Parser::from_json(path);
+    peak = std::max(peak, double(rss_bytes(true) - before));
+    cells = netlist ? netlist->num_cells() : 0;
+    netlist_bytes = netlist ? netlist->bytes() : 0;
+  }
+  state.counters["cells"] = static_cast<double>(cells);
+  state.counters["netlist_mb"] = netlist_bytes / 1048576.0;
+  state.counters["file_mb"] = std::filesystem::file_size(path) / 1048576.0;
+  state.counters["peak_rss_mb"] = peak / 1048576.0;
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  std::filesystem::remove(path);
+}
+
+void BM_Parser_FromBlif(State &state) {
+  std::string path = write_blif_design(state.range(0));
+  size_t cells = 0;
+  double peak = 0;
+  for (auto _ : state) {
+    reset_peak_rss();
+    size_t before = rss_bytes();
+    auto netlist = Parser::from_blif(path);
+    peak = std::max(peak, double(rss_bytes(true) - before));
+    cells = netlist ? netlist->num_cells() : 0;
+  }
+  state.counters["cells"] = static_cast<double>(cells);
+  state.counters["file_mb"] = std::filesystem::file_size(path) / 1048576.0;
+  state.counters["peak_rss_mb"] = peak / 1048576.0;
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  std::filesystem::remove(path);
+}
+
+// Loading the binary image FlowCache keeps of a parsed netlist, which
+// replaces parsing on later runs of the flow
+void BM_FlowCache_LoadNetlist(State &state) {
+  std::string path = write_design(state.range(0));
+  auto parsed = Parser::from_json(path);
+  std::filesystem::remove(path);
+  std::string dir = path + ".cache";
+  FlowCache cache(dir);
+  cache.store_netlist(1, *parsed);
+  size_t bytes = parsed->bytes();
+  parsed.reset();
+
+  size_t cells = 0;
+  for (auto _ : state) {
+    auto netlist = cache.load_netlist(1);
+    cells = netlist ? netlist->num_cells() : 0;
+  }
+  size_t image_bytes = 0;
+  for (const auto &entry : std::filesystem::directory_iterator(dir))
+    image_bytes += entry.file_size();
+  state.counters["cells"] = static_cast<double>(cells);
+  state.counters["netlist_mb"] = bytes / 1048576.0;
+  state.counters["image_mb"] = image_bytes / 1048576.0;
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  std::filesystem::remove_all(dir);
+}
+
+// The optimization passes the flow runs between parsing and packing, on a
+// generated design (random masks, so mostly the sweep and pruning fire)
+void BM_Optimizer_Optimize(State &state) {
+  std::string path = write_design(state.range(0));
+  auto parsed = Parser::from_json(path);
+  std::filesystem::remove(path);
+
+  OptimizerStats stats;
+  for (auto _ : state) {
+    Netlist optimized = Optimizer::optimize(*parsed, {}, &stats);
+    DoNotOptimize(optimized);
+  }
+  state.counters["cells"] = static_cast<double>(stats.cells_before);
+  state.counters["cells_removed"] = static_cast<double>(stats.cells_removed());
+  state.counters["inputs_pruned"] = static_cast<double>(stats.pruned_inputs);
+  state.counters["luts_merged"] = static_cast<double>(stats.merged_luts);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Random gate-level network of range(0) two- and three-input gates, each
+// reading signals from the previous 256, with the last 256 as outputs.
+// 'depth' is set to the number of gate levels.
+Netlist gate_design(size_t gates, int &depth) {
+  static const char *TYPES[] = {"$_AND_", "$_OR_", "$_XOR_", "$_NAND_",
+                                "$_MUX_"};
+  std::mt19937 rng(1);
+  Netlist n;
+  std::vector<int> inputs(64);
+  for (size_t i = 0; i < inputs.size(); ++i)
+    inputs[i] = static_cast<int>(i) + 2;
+  n.add_port("in", PortDirection::INPUT, inputs);
+  int next = static_cast<int>(inputs.size()) + 2;
+  std::vector<int> level(next + gates, 0);
+  depth = 0;
+  for (size_t g = 0; g < gates; ++g) {
+    const char *type = TYPES[rng() % 5];
+    CellId c = n.add_cell("g" + std::to_string(g), type);
+    for (const char *pin : {"A", "B", "S"}) {
+      if (*pin == 'S' && type[2] != 'M')
+        break;
+      int bit = std::max(2, next - 1 - static_cast<int>(rng() % 256));
+      n.add_pin(c, pin, PortDirection::INPUT, std::span<const int>(&bit, 1));
+      level[next] = std::max(level[next], level[bit] + 1);
+    }
+    depth = std::max(depth, level[next]);
+    int y = next++;
+    n.add_pin(c, "Y", PortDirection::OUTPUT, std::span<const int>(&y, 1));
+  }
+  std::vector<int> outputs;
+  for (int bit = std::max(2, next - 256); bit < next; ++bit)
+    outputs.push_back(bit);
+  n.add_port("out", PortDirection::OUTPUT, outputs);
+  return n;
+}
+
+void BM_TechMapper_Map(State &state) {
+  int gate_depth = 0;
+  Netlist gates = gate_design(state.range(0), gate_depth);
+  MapperStats stats;
+  for (auto _ : state) {
+    Netlist mapped = TechMapper::map(gates, {}, &stats);
+    DoNotOptimize(mapped);
+  }
+  state.counters["gates"] = static_cast<double>(stats.nodes);
+  state.counters["luts"] = static_cast<double>(stats.luts);
+  state.counters["depth"] = stats.depth;
+  state.counters["gate_depth"] = gate_depth;
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Reference point: the cost of only building an nlohmann DOM of the same
+// file, which the parser used to do before walking it
+void BM_Parser_JsonDom(State &state) {
+  std::string path = write_design(state.range(0));
+  double peak = 0;
+  for (auto _ : state) {
+    reset_peak_rss();
+    size_t before = rss_bytes();
+    std::ifstream in(path);
+    nlohmann::json j = nlohmann::json::parse(in);
+    peak = std::max(peak, double(rss_bytes(true) - before));
+    DoNotOptimize(j.size());
+  }
+  state.counters["file_mb"] = std::filesystem::file_size(path) / 1048576.0;
+  state.counters["peak_rss_mb"] = peak / 1048576.0;
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  std::filesystem::remove(path);
+}
+
+void BM_Placer_Place(State &state) {
+  auto blocks = make_blocks(state.range(0));
+  int side = fabric_side_for(blocks.size());
+  Fabric fabric(side, side);
+  ScopedSilence quiet;
+
+  double hpwl = 0, path_ps = 0;
+  for (auto _ : state) {
+    auto placement = Placer::place(fabric, blocks, 1);
+    hpwl = Placer::calculate_cost(blocks, placement);
+    path_ps = Placer::critical_path_ps(blocks, placement);
+  }
+  state.counters["hpwl"] = hpwl;
+  state.counters["path_ps"] = path_ps;
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Packing a generated design: LUT+DFF fusion, then timing-driven
+// clustering into CLB sites; 'clusters' is what the placer anneals instead
+// of the blocks, 'path_gain' the estimated critical path it saves
+void BM_Packer_Cluster(State &state) {
+  std::string path = write_design(state.range(0));
+  auto parsed = Parser::from_json(path);
+  std::filesystem::remove(path);
+  ScopedSilence quiet;
+
+  size_t blocks = 0;
+  ClusterStats stats;
+  for (auto _ : state) {
+    auto packed = Packer::pack(*parsed);
+    auto grouped = Packer::cluster(packed, {}, &stats);
+    blocks = packed.size();
+    DoNotOptimize(grouped);
+  }
+  state.counters["cells"] = static_cast<double>(parsed->num_cells());
+  state.counters["blocks"] = static_cast<double>(blocks);
+  state.counters["clusters"] = static_cast<double>(stats.clusters);
+  state.counters["path_gain"] = stats.path_gain();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// BM_Placer_Place with the annealer moving clusters of blocks
+void BM_Placer_PlaceClustered(State &state) {
+  auto blocks = make_blocks(state.range(0));
+  int side = fabric_side_for(blocks.size());
+  Fabric fabric(side, side);
+  auto clusters = Packer::cluster(blocks);
+  ScopedSilence quiet;
+
+  double hpwl = 0, path_ps = 0;
+  for (auto _ : state) {
+    auto placement = Placer::place(fabric, blocks, 1, clusters);
+    hpwl = Placer::calculate_cost(blocks, placement);
+    path_ps = Placer::critical_path_ps(blocks, placement);
+  }
+  state.counters["hpwl"] = hpwl;
+  state.counters["path_ps"] = path_ps;
+  state.counters["clusters"] = static_cast<double>(clusters.size());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// BM_Placer_Place on a grid of range(1) regions annealed by all cores;
+// the placement does not depend on the number of cores
+void BM_Placer_PlaceParallel(State &state) {
+  auto blocks = make_blocks(state.range(0));
+  int side = fabric_side_for(blocks.size());
+  Fabric fabric(side, side);
+  PlacerOptions options;
+  options.regions = static_cast<int>(state.range(1));
+  ScopedSilence quiet;
+
+  double hpwl = 0;
+  for (auto _ : state) {
+    auto placement = Placer::place(fabric, blocks, 1, {}, options);
+    hpwl = Placer::calculate_cost(blocks, placement);
+  }
+  state.counters["hpwl"] = hpwl;
+  state.counters["threads"] = std::thread::hardware_concurrency();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// BM_Placer_Place keeping the best of range(1) seeds placed on all cores
+void BM_Placer_PlaceSeeds(State &state) {
+  auto blocks = make_blocks(state.range(0));
+  int side = fabric_side_for(blocks.size());
+  Fabric fabric(side, side);
+  PlacerOptions options;
+  options.seeds = static_cast<int>(state.range(1));
+  ScopedSilence quiet;
+
+  double hpwl = 0, path_ps = 0;
+  for (auto _ : state) {
+    auto placement = Placer::place(fabric, blocks, 1, {}, options);
+    hpwl = Placer::calculate_cost(blocks, placement);
+    path_ps = Placer::critical_path_ps(blocks, placement);
+  }
+  state.counters["hpwl"] = hpwl;
+  state.counters["path_ps"] = path_ps;
+  state.counters["threads"] = std::thread::hardware_concurrency();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Router_Route(State &state) {
+  auto blocks = make_blocks(state.range(0));
+  int side = fabric_side_for(blocks.size());
+  Fabric fabric(side, side);
+  auto placement = random_placement(fabric, blocks);
+  ScopedSilence quiet;
+
+  int iterations = 0;
+  for (auto _ : state) {
+    Router router;
+    router.route(fabric, blocks, placement);
+    iterations = router.iterations;
+  }
+  state.counters["routing_iterations"] = iterations;
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_TimingAnalyzer_Analyze(State &state) {
+  auto blocks = make_blocks(state.range(0));
+  int side = fabric_side_for(blocks.size());
+  Fabric fabric(side, side);
+  auto placement = random_placement(fabric, blocks);
+
+  Router router;
+  router.nets = make_nets(blocks, placement);
+
+  double fmax = 0;
+  for (auto _ : state) {
+    TimingAnalyzer analyzer(fabric, router);
+    fmax = analyzer.analyze().fmax_mhz;
+  }
+  state.counters["fmax_mhz"] = fmax;
+  state.SetItemsProcessed(state.iterations() * router.nets.size());
+}
+
+} // namespace
+
+VFPGA_BENCHMARK(BM_Parser_FromJson)->Range(1 << 14, 1 << 20);
+VFPGA_BENCHMARK(BM_Parser_FromBlif)->Range(1 << 14, 1 << 20);
+VFPGA_BENCHMARK(BM_FlowCache_LoadNetlist)->Range(1 << 14, 1 << 20);
+VFPGA_BENCHMARK(BM_Optimizer_Optimize)->Range(1 << 14, 1 << 20);
+VFPGA_BENCHMARK(BM_TechMapper_Map)->Range(1 << 12, 1 << 20);
+VFPGA_BENCHMARK(BM_Parser_JsonDom)->Range(1 << 14, 1 << 17);
+VFPGA_BENCHMARK(BM_Placer_Place)->RangeMultiplier(4)->Range(16, 4096);
+VFPGA_BENCHMARK(BM_Packer_Cluster)->Range(1 << 14, 1 << 20);
+VFPGA_BENCHMARK(BM_Placer_PlaceClustered)->RangeMultiplier(4)->Range(16, 4096);
+VFPGA_BENCHMARK(BM_Placer_PlaceParallel)
+    ->Args({4096, 4})
+    ->Args({4096, 16})
+    ->Args({16384, 16})
+    ->Args({16384, 64});
+VFPGA_BENCHMARK(BM_Placer_PlaceSeeds)->Args({1024, 1})->Args({1024, 4});
+VFPGA_BENCHMARK(BM_Router_Route)->RangeMultiplier(4)->Range(16, 256);
+VFPGA_BENCHMARK(BM_TimingAnalyzer_Analyze)->RangeMultiplier(4)->Range(16, 1024);
@@ -0,0 +1,86 @@
+#include "../src/core/LogicVal.hpp"
+#include "../src/core/Signal.hpp"
+#include "../src/primitives/LUT.hpp"
+#include "Benchmark.hpp"
+#include <random>
+#include <vector>
+
+using namespace vfpga;
+using namespace vfpga::bench;
+
+namespace {
+
+std::vector<LogicVal> random_values(size_t n, bool allow_xz = true,
+                                    uint32_t seed = 1) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> d(0, allow_xz ? 3 : 1);
+  std::vector<LogicVal> values(n);
+  for (auto &v : values)
+    v = LogicVal(static_cast<LogicState>(d(rng)));
+  return values;
+}
+
+template <typename Op> void logic_val_binary(State &state, Op op) {
+  auto a = random_values(state.range(0), true, 1);
+  auto b = random_values(state.range(0), true, 2);
+  std::vector<LogicVal> out(a.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < a.size(); ++i)
+      out[i] = op(a[i], b[i]);
+    DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_LogicVal_And(State &state) {
+  logic_val_binary(state, [](LogicVal x, LogicVal y) { return x & y; });
+}
+void BM_LogicVal_Or(State &state) {
+  logic_val_binary(state, [](LogicVal x, LogicVal y) { return x | y; });
+}
+void BM_LogicVal_Xor(State &state) {
+  logic_val_binary(state, [](LogicVal x, LogicVal y) { return x ^ y; });
+}
+void BM_LogicVal_Not(State &state) {
+  logic_val_binary(state, [](LogicVal x, LogicVal) { return ~x; });
+}
+
+// Resolution of a net with range(0) drivers (all agree: worst case scan)
+void BM_Signal_Resolve(State &state) {
+  std::vector<LogicVal> drivers(state.range(0), LogicVal(LogicState::L1));
+  Signal s;
+  for (auto _ : state) {
+    s.resolve(drivers);
+    DoNotOptimize(s);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <size_t K> void BM_LUT_Evaluate(State &state) {
+  LUT<K> lut;
+  lut.configure(random_values(size_t{1} << K, false, 3));
+
+  // Pre-generate input vectors so the loop measures evaluate() only
+  constexpr size_t NUM_VECTORS = 256;
+  auto bits = random_values(NUM_VECTORS * K, false, 4);
+  std::vector<std::vector<LogicVal>> inputs(NUM_VECTORS);
+  for (size_t i = 0; i < NUM_VECTORS; ++i)
+    inputs[i].assign(bits.begin() + i * K, bits.begin() + (i + 1) * K);
+
+  for (auto _ : state) {
+    for (const auto &in : inputs)
+      DoNotOptimize(lut.evaluate(in));
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_VECTORS);
+}
+
+} // namespace
+
+VFPGA_BENCHMARK(BM_LogicVal_And)->Range(1 << 10, 1 << 16);
+VFPGA_BENCHMARK(BM_LogicVal_Or)->Range(1 << 10, 1 << 16);
+VFPGA_BENCHMARK(BM_LogicVal_Xor)->Range(1 << 10, 1 << 16);
+VFPGA_BENCHMARK(BM_LogicVal_Not)->Range(1 << 10, 1 << 16);
+VFPGA_BENCHMARK(BM_Signal_Resolve)->Range(1, 64);
+VFPGA_BENCHMARK(BM_LUT_Evaluate<2>);
+VFPGA_BENCHMARK(BM_LUT_Evaluate<4>);
+VFPGA_BENCHMARK(BM_LUT_Evaluate<6>);
@@ -0,0 +1,133 @@
+#include "../src/fabric/BitstreamDiff.hpp"
+#include "../src/fabric/BitstreamLoader.hpp"
+#include "../src/fabric/Fabric.hpp"
+#include "Benchmark.hpp"
+#include <filesystem>
+#include <random>
+
+using namespace vfpga;
+using namespace vfpga::bench;
+
+namespace {
+
+// One clock cycle on a range(0) x range(0) fabric where every tile drives a
+// nearby tile (10^2 .. 10^4 tiles).
+void BM_Fabric_Step(State &state) {
+  int side = static_cast<int>(state.range(0));
+  Fabric fabric(side, side);
+
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> offset(-2, 2);
+  for (int y = 0; y < side; ++y) {
+    for (int x = 0; x < side; ++x) {
+      Fabric::Connectivity net;
+      net.source = {x, y};
+      int sx = std::clamp(x + offset(rng), 0, side - 1);
+      int sy = std::clamp(y + offset(rng), 0, side - 1);
+      net.sinks.push_back({sx, sy});
+      fabric.nets.push_back(net);
+    }
+  }
+  fabric.reset();
+
+  for (auto _ : state) {
+    fabric.step();
+  }
+  state.SetItemsProcessed(state.iterations() * fabric.size());
+  state.counters["tiles"] = static_cast<double>(fabric.size());
+}
+
+// Configure a range(0) x range(0) fabric from a bitstream file. With
+// range(1) = 0 the checksum is skipped, which is the pure mmap cost.
+void BM_Bitstream_Load(State &state) {
+  int side = static_cast<int>(state.range(0));
+  bool verify = state.range(1) != 0;
+  std::string path = (std::filesystem::temp_directory_path() /
+                      ("vfpga_bench_" + std::to_string(side) + ".bit"))
+                         .string();
+  Fabric fabric(side, side);
+  BitstreamLoader::save(path, fabric);
+
+  for (auto _ : state) {
+    DoNotOptimize(BitstreamLoader::load(path, fabric, verify));
+  }
+  state.SetItemsProcessed(state.iterations() * fabric.size());
+  state.counters["bytes"] =
+      static_cast<double>(fabric.config_layout().total_bytes);
+  std::filesystem::remove(path);
+}
+
+// Decode a compressed bitstream of an empty range(0) x range(0) fabric, the
+// best case for sparse configurations
+void BM_Bitstream_LoadCompressed(State &state) {
+  int side = static_cast<int>(state.range(0));
+  std::string path = (std::filesystem::temp_directory_path() /
+                      ("vfpga_bench_" + std::to_string(side) + ".cbit"))
+                         .string();
+  Fabric fabric(side, side);
+  BitstreamLoader::save(path, fabric, true);
+
+  for (auto _ : state) {
+    DoNotOptimize(BitstreamLoader::load(path, fabric));
+  }
+  state.SetItemsProcessed(state.iterations() * fabric.size());
+  state.counters["file_bytes"] =
+      static_cast<double>(std::filesystem::file_size(path));
+  std::filesystem::remove(path);
+}
+
+// Swap one column of a range(0) x range(0) fabric and run a cycle, which
+// includes recompiling that column's part of the schedule.
+void BM_Bitstream_ApplyPartial(State &state) {
+  int side = static_cast<int>(state.range(0));
+  std::string path = (std::filesystem::temp_directory_path() /
+                      ("vfpga_bench_" + std::to_string(side) + ".pbit"))
+                         .string();
+  Fabric fabric(side, side);
+  fabric.reset();
+  BitstreamLoader::save_partial(path, fabric, {side / 2});
+
+  for (auto _ : state) {
+    DoNotOptimize(BitstreamLoader::apply_partial(path, fabric));
+    fabric.step();
+  }
+  state.SetItemsProcessed(state.iterations());
+  std::filesystem::remove(path);
+}
+
+// Diff two range(0) x range(0) configurations that differ in one frame.
+// Built straight from images, since large Fabrics are slow to construct.
+void BM_Bitstream_Diff(State &state) {
+  int side = static_cast<int>(state.range(0));
+  auto make = [side] {
+    ConfigSnapshot snap;
+    snap.width = snap.height = side;
+    size_t bytes = Fabric::layout_for(side, side).total_bytes;
+    auto image = std::make_shared<std::byte[]>(bytes);
+    Fabric::init_image(image.get(), side, side);
+    snap.image = image.get();
+    snap.owner = image;
+    return snap;
+  };
+  ConfigSnapshot a = make(), b = make();
+  b.frame(side / 2).lut_masks[0] = 0;
+
+  for (auto _ : state) {
+    DoNotOptimize(BitstreamDiff::compare(a, b).frames_different);
+  }
+  size_t bytes = Fabric::layout_for(side, side).total_bytes;
+  state.SetItemsProcessed(state.iterations() * 2 * bytes);
+  state.counters["image_bytes"] = static_cast<double>(bytes);
+}
+
+} // namespace
+
+VFPGA_BENCHMARK(BM_Fabric_Step)->Arg(10)->Arg(32)->Arg(100);
+VFPGA_BENCHMARK(BM_Bitstream_Load)
+    ->Args({32, 0})
+    ->Args({32, 1})
+    ->Args({100, 0})
+    ->Args({100, 1});
+VFPGA_BENCHMARK(BM_Bitstream_LoadCompressed)->Arg(32)->Arg(100);
+VFPGA_BENCHMARK(BM_Bitstream_ApplyPartial)->Arg(32)->Arg(100);
+VFPGA_BENCHMARK(BM_Bitstream_Diff)->Arg(100)->Arg(1000);
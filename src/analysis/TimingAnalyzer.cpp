@@ -59,7 +59,7 @@ TimingResult TimingAnalyzer::analyze() {
         int dst_y = sink.y;
 
         int dist = std::abs(src_x - dst_x) + std::abs(src_y - dst_y);
-        double route_delay = dist * 50.0; // 50ps per hop
+        double route_delay = dist * Fabric::HOP_DELAY_PS;
 
         // Destination Logic Delay
         double logic_delay = 0;
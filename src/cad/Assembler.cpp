@@ -0,0 +1,53 @@
+#include "Assembler.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace vfpga {
+
+uint16_t Assembler::encode_mask(const std::vector<LogicVal> &lut_mask) {
+  if (lut_mask.empty())
+    return Fabric::LUT_PASSTHROUGH;
+
+  uint16_t mask = 0;
+  for (size_t i = 0; i < (size_t{1} << Fabric::LUT_INPUTS); ++i)
+    if (lut_mask[i % lut_mask.size()].is_1())
+      mask |= static_cast<uint16_t>(1u << i);
+  return mask;
+}
+
+void Assembler::assemble(Fabric &fabric, const std::vector<LogicBlock> &blocks,
+                         const std::map<int, std::pair<int, int>> &placement) {
+  // Where is each net driven from? (config index + 1, MUX_OPEN if nowhere)
+  std::vector<int32_t> driver_select;
+  for (const auto &block : blocks) {
+    auto it = placement.find(block.id);
+    if (it == placement.end() || block.output_net == NO_NET)
+      continue;
+    if (driver_select.size() <= static_cast<size_t>(block.output_net))
+      driver_select.resize(block.output_net + 1, Fabric::MUX_OPEN);
+    driver_select[block.output_net] = static_cast<int32_t>(
+        fabric.config_index(it->second.first, it->second.second) + 1);
+  }
+
+  for (const auto &block : blocks) {
+    auto it = placement.find(block.id);
+    if (it == placement.end())
+      continue;
+    size_t index = fabric.config_index(it->second.first, it->second.second);
+
+    fabric.lut_masks[index] =
+        block.use_lut ? block.lut_mask : Fabric::LUT_PASSTHROUGH;
+
+    int32_t *selects = &fabric.mux_selects[index * Fabric::LUT_INPUTS];
+    std::fill(selects, selects + Fabric::LUT_INPUTS, Fabric::MUX_OPEN);
+    size_t pins = std::min<size_t>(block.input_nets.size(), Fabric::LUT_INPUTS);
+    for (size_t pin = 0; pin < pins; ++pin) {
+      NetId net = block.input_nets[pin];
+      if (net != NO_NET && static_cast<size_t>(net) < driver_select.size())
+        selects[pin] = driver_select[net];
+    }
+  }
+  fabric.invalidate_schedule();
+}
+
+} // namespace vfpga
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../fabric/Fabric.hpp"
+#include "LogicBlock.hpp"
+#include <map>
+#include <vector>
+
+namespace vfpga {
+
+class Assembler {
+public:
+  // Write a placed design into the fabric's configuration planes:
+  // - LUT masks from each block's lut_mask (passthrough without a LUT)
+  // - Input muxes selecting the tile that drives each input net
+  // Inputs driven from outside the design (or unplaced blocks) stay open.
+  static void assemble(Fabric &fabric, const std::vector<LogicBlock> &blocks,
+                       const std::map<int, std::pair<int, int>> &placement);
+
+  // Expand a LogicVal truth table to a LUT_INPUTS-wide mask. Narrower tables
+  // are repeated so that the unused high inputs don't matter; X bits read 0.
+  static uint16_t encode_mask(const std::vector<LogicVal> &lut_mask);
+};
+
+} // namespace vfpga
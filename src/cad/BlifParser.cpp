@@ -0,0 +1,505 @@
+#include "Hierarchy.hpp"
+#include "Parser.hpp"
+#include "../utils/MappedFile.hpp"
+#include "../utils/StringInterner.hpp"
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace vfpga {
+
+namespace {
+
+// Largest .names cover converted to a LUT (a 64K-entry truth table)
+constexpr int MAX_NAMES_INPUTS = 16;
+
+// Truth tables of inputs 0..5 over one 64-minterm word
+constexpr uint64_t VAR_MASKS[6] = {
+    0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+    0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull};
+
+// --- Tokenizer ---
+
+// Splits BLIF text into logical lines of whitespace-separated tokens.
+// Tokens are views into the text, so nothing is copied. Comments ('#' to
+// the end of the line) are dropped and a backslash before a newline joins
+// two lines.
+class BlifLexer {
+public:
+  explicit BlifLexer(std::string_view text, int first_line = 1)
+      : p(text.data()), end(text.data() + text.size()), line_no(first_line) {}
+
+  // Next non-empty logical line, false at the end of the text. With
+  // 'directives_only', lines not starting with '.' are skipped without
+  // being tokenized.
+  bool next(std::vector<std::string_view> &tokens,
+            bool directives_only = false) {
+    tokens.clear();
+    while (p < end) {
+      start_line = line_no;
+      while (p < end) {
+        char c = *p;
+        if (c == '\n') {
+          ++p;
+          ++line_no;
+          break;
+        }
+        if (is_space(c)) {
+          ++p;
+        } else if (c == '#') {
+          const void *nl = std::memchr(p, '\n', end - p);
+          p = nl ? static_cast<const char *>(nl) : end;
+        } else if (c == '\\' && at_continuation()) {
+          p += p[1] == '\n' ? 2 : 3;
+          ++line_no;
+        } else if (directives_only && tokens.empty() && c != '.') {
+          skip_line();
+          break;
+        } else {
+          const char *begin = p;
+          while (p < end && !is_space(*p) && *p != '\n' && *p != '#' &&
+                 !(*p == '\\' && at_continuation()))
+            ++p;
+          tokens.emplace_back(begin, p - begin);
+        }
+      }
+      if (!tokens.empty())
+        return true;
+    }
+    return false;
+  }
+
+  // First line of the last logical line returned
+  int line() const { return start_line; }
+  // Line the lexer is on, and its position
+  int next_line() const { return line_no; }
+  const char *position() const { return p; }
+
+private:
+  const char *p, *end;
+  int line_no, start_line = 0;
+
+  static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f';
+  }
+
+  bool at_continuation() const {
+    return (p + 1 < end && p[1] == '\n') ||
+           (p + 2 < end && p[1] == '\r' && p[2] == '\n');
+  }
+
+  // Skip the rest of a logical line
+  void skip_line() {
+    for (;;) {
+      const char *nl = static_cast<const char *>(std::memchr(p, '\n', end - p));
+      if (!nl) {
+        p = end;
+        return;
+      }
+      const char *last = nl > p && nl[-1] == '\r' ? nl - 1 : nl;
+      bool joined = last > p && last[-1] == '\\' &&
+                    !std::memchr(p, '#', last - p);
+      p = nl + 1;
+      ++line_no;
+      if (!joined)
+        return;
+    }
+  }
+};
+
+// Splits a bus bit name such as "A[3]" into its port and index; any other
+// name is a one-bit port (index -1)
+std::pair<std::string_view, int> split_bus(std::string_view name) {
+  constexpr int MAX_INDEX = 1 << 16;
+  size_t open = name.rfind('[');
+  if (open == std::string_view::npos || open == 0 || name.back() != ']')
+    return {name, -1};
+  const char *last = name.data() + name.size() - 1;
+  int index = 0;
+  auto [ptr, ec] = std::from_chars(name.data() + open + 1, last, index);
+  if (ec != std::errc() || ptr != last || index < 0 || index >= MAX_INDEX)
+    return {name, -1};
+  return {name.substr(0, open), index};
+}
+
+// --- Locating models ---
+
+// One .model found by the scan
+struct ModelInfo {
+  std::string_view name;
+  std::string_view body; // Text between the .model line and .end
+  int first_line = 1;    // Line number where 'body' starts
+  bool blackbox = false;
+  std::unordered_map<std::string_view, PortDirection> ports; // By port
+};
+
+// Splits the text into models and collects their port declarations, so
+// that subcircuit pins get directions whatever order models appear in.
+// Only directive lines are tokenized.
+bool scan_models(std::string_view text, std::vector<ModelInfo> &models,
+                 std::string &error) {
+  BlifLexer lexer(text);
+  std::vector<std::string_view> tokens;
+  ModelInfo *model = nullptr;
+  auto close = [&](const char *at) {
+    if (model)
+      model->body = std::string_view(
+          model->body.data(), static_cast<size_t>(at - model->body.data()));
+    model = nullptr;
+  };
+
+  while (lexer.next(tokens, true)) {
+    std::string_view directive = tokens[0];
+    if (directive == ".model") {
+      close(tokens[0].data());
+      if (tokens.size() != 2) {
+        error = "Error: BLIF line " + std::to_string(lexer.line()) +
+                ": .model needs exactly one name";
+        return false;
+      }
+      model = &models.emplace_back();
+      model->name = tokens[1];
+      model->body = std::string_view(lexer.position(), 0);
+      model->first_line = lexer.next_line();
+    } else if (!model) {
+      continue; // E.g. .search, which is not supported
+    } else if (directive == ".end") {
+      close(tokens[0].data());
+    } else if (directive == ".inputs" || directive == ".outputs") {
+      PortDirection dir = directive == ".inputs" ? PortDirection::INPUT
+                                                 : PortDirection::OUTPUT;
+      for (size_t i = 1; i < tokens.size(); ++i)
+        model->ports.try_emplace(split_bus(tokens[i]).first, dir);
+    } else if (directive == ".blackbox") {
+      model->blackbox = true;
+    }
+  }
+  close(text.data() + text.size());
+  return true;
+}
+
+// --- Parsing one model ---
+
+// Builds the ModuleTemplate of one model. Signals are numbered in order of
+// first use from bit 2 (bits 0 and 1 are the constants, which BLIF
+// expresses as constant .names instead). Each cell is held back until the
+// next directive so that a following .cname or .param still applies.
+class ModelParser {
+public:
+  using ModelIndex = std::unordered_map<std::string_view, const ModelInfo *>;
+
+  ModelParser(const ModelInfo &info, const ModelIndex &models,
+              ModuleTemplate &module)
+      : info(info), models(models), module(module),
+        lexer(info.body, info.first_line) {}
+
+  bool parse() {
+    module.name = std::string(info.name);
+    bool have = lexer.next(tokens);
+    while (have) {
+      std::string_view directive = tokens[0];
+      if (directive[0] != '.')
+        return fail("unexpected line outside a .names cover");
+
+      if (directive == ".cname") {
+        if (tokens.size() == 2 && pending)
+          pending_name = tokens[1];
+      } else if (directive == ".param") {
+        if (tokens.size() == 3 && pending)
+          pending_params.emplace_back(tokens[1], std::string(tokens[2]));
+      } else if (directive == ".attr") {
+        // Attributes are not used
+      } else {
+        flush();
+        if (directive == ".names") {
+          if (!parse_names())
+            return false;
+          have = !tokens.empty(); // The directive that ended the cover
+          continue;
+        }
+        bool ok = true;
+        if (directive == ".inputs")
+          add_ports(PortDirection::INPUT);
+        else if (directive == ".outputs")
+          add_ports(PortDirection::OUTPUT);
+        else if (directive == ".latch")
+          ok = parse_latch();
+        else if (directive == ".subckt" || directive == ".gate")
+          ok = parse_subckt();
+        // Anything else (.clock, timing and area annotations) is ignored
+        if (!ok)
+          return false;
+      }
+      have = lexer.next(tokens);
+    }
+    flush();
+    for (const auto &port : module.ports)
+      module.body.add_port(port.name, port.direction, port.bits);
+    module.max_bit = 1 + static_cast<int>(signals.size());
+    return true;
+  }
+
+private:
+  struct PendingPin {
+    std::string_view port;
+    PortDirection direction;
+    std::vector<int> bits;
+  };
+
+  const ModelInfo &info;
+  const ModelIndex &models;
+  ModuleTemplate &module;
+  BlifLexer lexer;
+  std::vector<std::string_view> tokens;
+  StringInterner signals;
+  std::unordered_map<std::string_view, size_t> port_index;
+  std::vector<uint64_t> words; // Truth table being built
+  size_t instances = 0;
+
+  // The held-back cell. Pin bit vectors are reused between cells.
+  bool pending = false;
+  std::string pending_name;
+  std::string_view pending_type;
+  std::vector<std::pair<std::string_view, std::string>> pending_params;
+  std::vector<PendingPin> pending_pins;
+  size_t num_pending_pins = 0;
+
+  bool fail(const std::string &message) {
+    module.error = "Error: BLIF line " + std::to_string(lexer.line()) + ": " +
+                   message;
+    return false;
+  }
+
+  int bit(std::string_view signal) { return 2 + signals.intern(signal); }
+
+  void begin_cell(std::string_view name, std::string_view type) {
+    pending = true;
+    pending_name = name;
+    pending_type = type;
+  }
+
+  PendingPin &add_pin(std::string_view port, PortDirection direction) {
+    if (num_pending_pins == pending_pins.size())
+      pending_pins.emplace_back();
+    PendingPin &pin = pending_pins[num_pending_pins++];
+    pin.port = port;
+    pin.direction = direction;
+    pin.bits.clear();
+    return pin;
+  }
+
+  // Set bit 'index' of a bus, padding skipped bits as undefined
+  static void set_bit(std::vector<int> &bits, int index, int value) {
+    size_t at = index < 0 ? 0 : static_cast<size_t>(index);
+    if (bits.size() <= at)
+      bits.resize(at + 1, UNDEFINED_BIT);
+    bits[at] = value;
+  }
+
+  void flush() {
+    if (!pending)
+      return;
+    Netlist &body = module.body;
+    CellId c = body.add_cell(pending_name, pending_type);
+    for (auto &[key, value] : pending_params)
+      body.add_param(c, key, std::move(value));
+    for (size_t i = 0; i < num_pending_pins; ++i) {
+      const PendingPin &pin = pending_pins[i];
+      body.add_pin(c, pin.port, pin.direction, pin.bits);
+    }
+    pending = false;
+    pending_params.clear();
+    num_pending_pins = 0;
+  }
+
+  void add_ports(PortDirection dir) {
+    for (size_t i = 1; i < tokens.size(); ++i) {
+      auto [port, index] = split_bus(tokens[i]);
+      auto [it, inserted] = port_index.try_emplace(port, module.ports.size());
+      if (inserted)
+        module.ports.push_back({std::string(port), dir, {}});
+      set_bit(module.ports[it->second].bits, index, bit(tokens[i]));
+    }
+  }
+
+  // .names in... out, then the cover rows. The single-output cover is
+  // evaluated 64 minterms at a time into the $lut mask; rows with output 0
+  // describe the off-set, so the mask is complemented.
+  bool parse_names() {
+    if (tokens.size() < 2)
+      return fail(".names needs an output");
+    int k = static_cast<int>(tokens.size()) - 2;
+    if (k > MAX_NAMES_INPUTS)
+      return fail(".names has more than " +
+                  std::to_string(MAX_NAMES_INPUTS) + " inputs");
+
+    begin_cell(tokens.back(), "$lut");
+    if (k > 0) {
+      PendingPin &a = add_pin("A", PortDirection::INPUT);
+      for (int i = 0; i < k; ++i)
+        a.bits.push_back(bit(tokens[1 + i]));
+    }
+    add_pin("Y", PortDirection::OUTPUT).bits.push_back(bit(tokens.back()));
+
+    words.assign(k <= 6 ? 1 : size_t{1} << (k - 6), 0);
+    bool on_set = false, off_set = false;
+    while (lexer.next(tokens) && tokens[0][0] != '.') {
+      std::string_view cube = k > 0 ? tokens[0] : std::string_view();
+      std::string_view out = tokens.back();
+      if (tokens.size() != (k > 0 ? 2u : 1u) ||
+          cube.size() != static_cast<size_t>(k) || out.size() != 1 ||
+          (out[0] != '0' && out[0] != '1'))
+        return fail("malformed cover row");
+      if (cube.find_first_not_of("01-") != std::string_view::npos)
+        return fail("cover rows may only contain 0, 1 and -");
+      (out[0] == '1' ? on_set : off_set) = true;
+      add_cube(cube);
+    }
+    if (on_set && off_set)
+      return fail("cover mixes on-set and off-set rows");
+
+    size_t size = size_t{1} << k;
+    std::string mask(size, '0');
+    for (size_t i = 0; i < size; ++i)
+      if (((words[i >> 6] >> (i & 63)) & 1) != off_set)
+        mask[size - 1 - i] = '1';
+    pending_params.emplace_back("WIDTH", std::to_string(k));
+    pending_params.emplace_back("LUT", std::move(mask));
+    return true; // 'tokens' holds the next directive, or nothing at the end
+  }
+
+  void add_cube(std::string_view cube) {
+    for (size_t w = 0; w < words.size(); ++w) {
+      uint64_t m = ~uint64_t{0};
+      for (size_t i = 0; i < cube.size(); ++i) {
+        if (cube[i] == '-')
+          continue;
+        uint64_t v = i < 6 ? VAR_MASKS[i]
+                           : ((w >> (i - 6)) & 1 ? ~uint64_t{0} : 0);
+        m &= cube[i] == '1' ? v : ~v;
+      }
+      words[w] |= m;
+    }
+  }
+
+  // .latch in out [type control] [init]. The fabric's flip-flops are
+  // rising edge, so the latch type is checked but not kept.
+  bool parse_latch() {
+    size_t n = tokens.size();
+    if (n < 3 || n > 6)
+      return fail("malformed .latch");
+    std::string_view type, control, init;
+    if (n >= 5) {
+      type = tokens[3];
+      control = tokens[4];
+      if (type != "re" && type != "fe" && type != "ah" && type != "al" &&
+          type != "as")
+        return fail("unknown latch type " + std::string(type));
+    }
+    if (n == 4 || n == 6)
+      init = tokens[n - 1];
+
+    begin_cell(tokens[2], "DFF");
+    if (!control.empty() && control != "NIL")
+      add_pin("C", PortDirection::INPUT).bits.push_back(bit(control));
+    add_pin("D", PortDirection::INPUT).bits.push_back(bit(tokens[1]));
+    add_pin("Q", PortDirection::OUTPUT).bits.push_back(bit(tokens[2]));
+    if (init == "0" || init == "1")
+      pending_params.emplace_back("INIT", std::string(init));
+    return true;
+  }
+
+  // .subckt model formal=actual... Pins take their direction from the
+  // model's declaration; pins of unknown models are inout.
+  bool parse_subckt() {
+    if (tokens.size() < 2)
+      return fail(std::string(tokens[0]) + " needs a model name");
+    std::string_view type = tokens[1];
+    auto model = models.find(type);
+
+    begin_cell(std::string(type) + "_" + std::to_string(instances++), type);
+    for (size_t i = 2; i < tokens.size(); ++i) {
+      size_t eq = tokens[i].find('=');
+      if (eq == std::string_view::npos)
+        return fail("expected formal=actual, got " + std::string(tokens[i]));
+      auto [port, index] = split_bus(tokens[i].substr(0, eq));
+
+      PendingPin *pin = nullptr;
+      for (size_t p = 0; p < num_pending_pins && !pin; ++p)
+        if (pending_pins[p].port == port)
+          pin = &pending_pins[p];
+      if (!pin) {
+        PortDirection dir = PortDirection::INOUT;
+        if (model != models.end()) {
+          auto decl = model->second->ports.find(port);
+          if (decl != model->second->ports.end())
+            dir = decl->second;
+        }
+        pin = &add_pin(port, dir);
+      }
+      set_bit(pin->bits, index, bit(tokens[i].substr(eq + 1)));
+    }
+    return true;
+  }
+};
+
+} // namespace
+
+std::optional<Netlist> Parser::from_blif(const std::string &filename,
+                                         ThreadPool *pool) {
+  std::unique_ptr<MappedFile> file;
+  try {
+    file = std::make_unique<MappedFile>(filename);
+  } catch (const std::runtime_error &) {
+    std::cerr << "Error: Could not open file " << filename << std::endl;
+    return std::nullopt;
+  }
+  const char *text = reinterpret_cast<const char *>(file->data());
+  return from_blif_text(std::string_view(text, file->size()), pool);
+}
+
+std::optional<Netlist> Parser::from_blif_text(std::string_view text,
+                                              ThreadPool *pool) {
+  std::vector<ModelInfo> infos;
+  std::string error;
+  if (!scan_models(text, infos, error)) {
+    std::cerr << error << std::endl;
+    return std::nullopt;
+  }
+
+  // Black boxes only declare the ports of primitive subcircuits
+  ModelParser::ModelIndex index;
+  std::vector<const ModelInfo *> defined;
+  for (const auto &info : infos) {
+    if (!index.emplace(info.name, &info).second) {
+      std::cerr << "Error: Duplicate BLIF model " << info.name << std::endl;
+      return std::nullopt;
+    }
+    if (!info.blackbox)
+      defined.push_back(&info);
+  }
+  if (defined.empty()) {
+    std::cerr << "Error: No models found in BLIF" << std::endl;
+    return std::nullopt;
+  }
+
+  std::vector<ModuleTemplate> modules(defined.size());
+  Hierarchy::parse_modules(defined.size(), pool, [&](size_t i) {
+    ModelParser(*defined[i], index, modules[i]).parse();
+  });
+  for (const auto &m : modules) {
+    if (!m.error.empty()) {
+      std::cerr << m.error << " (model " << m.name << ")" << std::endl;
+      return std::nullopt;
+    }
+  }
+
+  modules[0].top = true; // The first model is the design
+  return Hierarchy::flatten(modules);
+}
+
+} // namespace vfpga
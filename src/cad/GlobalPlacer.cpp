@@ -0,0 +1,262 @@
+#include "GlobalPlacer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+namespace vfpga {
+
+namespace {
+
+// Distances below one tile do not raise bound-to-bound weights further
+const double MIN_DISTANCE = 1.0;
+
+// Symmetric positive definite system A x = b for one axis, A in CSR without
+// its diagonal, assembled from two-pin connections and anchors
+class AxisSystem {
+public:
+  explicit AxisSystem(size_t n) : diag(n, 0.0), rhs(n, 0.0) {}
+
+  void connect(int a, int b, double w) {
+    diag[a] += w;
+    diag[b] += w;
+    terms.emplace_back(a, b, -w);
+    terms.emplace_back(b, a, -w);
+  }
+
+  void anchor(int a, double target, double w) {
+    diag[a] += w;
+    rhs[a] += w * target;
+  }
+
+  // Preconditioned (Jacobi) conjugate gradient from the current 'x'
+  void solve(std::vector<double> &x, int max_iterations, double tolerance) {
+    compress();
+    size_t n = x.size();
+    std::vector<double> r(n), z(n), p(n), ap(n);
+    multiply(x, ap);
+    double rhs_norm = 0, rz = 0;
+    for (size_t i = 0; i < n; ++i) {
+      r[i] = rhs[i] - ap[i];
+      z[i] = r[i] / diag[i];
+      p[i] = z[i];
+      rz += r[i] * z[i];
+      rhs_norm += rhs[i] * rhs[i];
+    }
+    double limit = tolerance * tolerance * std::max(rhs_norm, 1e-30);
+    for (int it = 0; it < max_iterations; ++it) {
+      double r_norm = 0;
+      for (size_t i = 0; i < n; ++i)
+        r_norm += r[i] * r[i];
+      if (r_norm <= limit)
+        break;
+      multiply(p, ap);
+      double pap = 0;
+      for (size_t i = 0; i < n; ++i)
+        pap += p[i] * ap[i];
+      if (pap <= 0)
+        break;
+      double alpha = rz / pap, rz_next = 0;
+      for (size_t i = 0; i < n; ++i) {
+        x[i] += alpha * p[i];
+        r[i] -= alpha * ap[i];
+        z[i] = r[i] / diag[i];
+        rz_next += r[i] * z[i];
+      }
+      double beta = rz_next / rz;
+      rz = rz_next;
+      for (size_t i = 0; i < n; ++i)
+        p[i] = z[i] + beta * p[i];
+    }
+  }
+
+private:
+  std::vector<double> diag, rhs;
+  std::vector<std::tuple<int, int, double>> terms;
+  std::vector<uint32_t> first;
+  std::vector<int> cols;
+  std::vector<double> vals;
+
+  // Terms to CSR, merging repeated connections
+  void compress() {
+    std::sort(terms.begin(), terms.end(), [](const auto &a, const auto &b) {
+      return std::tie(std::get<0>(a), std::get<1>(a)) <
+             std::tie(std::get<0>(b), std::get<1>(b));
+    });
+    first.assign(diag.size() + 1, 0);
+    for (size_t k = 0; k < terms.size(); ++k) {
+      auto [row, col, w] = terms[k];
+      if (k > 0 && std::get<0>(terms[k - 1]) == row &&
+          std::get<1>(terms[k - 1]) == col) {
+        vals.back() += w;
+        continue;
+      }
+      cols.push_back(col);
+      vals.push_back(w);
+      ++first[row + 1];
+    }
+    for (size_t i = 0; i < diag.size(); ++i)
+      first[i + 1] += first[i];
+  }
+
+  void multiply(const std::vector<double> &x, std::vector<double> &y) const {
+    for (size_t i = 0; i < diag.size(); ++i) {
+      double sum = diag[i] * x[i];
+      for (uint32_t k = first[i]; k < first[i + 1]; ++k)
+        sum += vals[k] * x[cols[k]];
+      y[i] = sum;
+    }
+  }
+};
+
+} // namespace
+
+double GlobalPlacer::hpwl(const std::vector<uint32_t> &net_first,
+                          const std::vector<int> &net_cells,
+                          const std::vector<Point> &pos) {
+  double total = 0;
+  for (size_t n = 0; n + 1 < net_first.size(); ++n) {
+    if (net_first[n + 1] - net_first[n] < 2)
+      continue;
+    double min_x = std::numeric_limits<double>::max(), max_x = -min_x;
+    double min_y = min_x, max_y = max_x;
+    for (uint32_t k = net_first[n]; k < net_first[n + 1]; ++k) {
+      auto [x, y] = pos[net_cells[k]];
+      min_x = std::min(min_x, x);
+      max_x = std::max(max_x, x);
+      min_y = std::min(min_y, y);
+      max_y = std::max(max_y, y);
+    }
+    total += (max_x - min_x) + (max_y - min_y);
+  }
+  return total;
+}
+
+std::vector<GlobalPlacer::Point>
+GlobalPlacer::place(const std::vector<Point> &start,
+                    const std::vector<uint32_t> &net_first,
+                    const std::vector<int> &net_cells, const Spread &spread,
+                    const GlobalPlacerOptions &options) {
+  size_t num_cells = start.size();
+  // Distinct cells of each net
+  std::vector<uint32_t> first{0};
+  std::vector<int> cells;
+  std::vector<size_t> seen(num_cells, 0);
+  for (size_t n = 0; n + 1 < net_first.size(); ++n) {
+    size_t size = cells.size();
+    for (uint32_t k = net_first[n]; k < net_first[n + 1]; ++k) {
+      int c = net_cells[k];
+      if (seen[c] != n + 1) {
+        seen[c] = n + 1;
+        cells.push_back(c);
+      }
+    }
+    if (cells.size() - size < 2)
+      cells.resize(size);
+    else
+      first.push_back(static_cast<uint32_t>(cells.size()));
+  }
+
+  std::vector<double> x(num_cells), y(num_cells);
+  for (size_t c = 0; c < num_cells; ++c)
+    std::tie(x[c], y[c]) = start[c];
+  std::vector<Point> anchors = start;
+  std::vector<Point> best;
+  double best_hpwl = std::numeric_limits<double>::max();
+
+  // One axis of the bound-to-bound system at the current positions, each
+  // cell tied to 'anchor' by a spring of 'pull'
+  auto solve = [&](std::vector<double> &v, const std::vector<double> &anchor,
+                   double pull) {
+    AxisSystem system(num_cells);
+    for (size_t n = 0; n + 1 < first.size(); ++n) {
+      uint32_t begin = first[n], end = first[n + 1];
+      uint32_t lo = begin, hi = begin;
+      for (uint32_t k = begin; k < end; ++k) {
+        if (v[cells[k]] < v[cells[lo]])
+          lo = k;
+        if (v[cells[k]] >= v[cells[hi]])
+          hi = k;
+      }
+      if (lo == hi)
+        hi = lo == begin ? begin + 1 : begin;
+      double scale = 2.0 / (end - begin - 1);
+      auto tie = [&](uint32_t a, uint32_t b) {
+        double d = std::abs(v[cells[a]] - v[cells[b]]);
+        system.connect(cells[a], cells[b], scale / std::max(d, MIN_DISTANCE));
+      };
+      tie(lo, hi);
+      for (uint32_t k = begin; k < end; ++k)
+        if (k != lo && k != hi) {
+          tie(k, lo);
+          tie(k, hi);
+        }
+    }
+    for (size_t c = 0; c < num_cells; ++c)
+      system.anchor(static_cast<int>(c), anchor[c], pull);
+    system.solve(v, options.cg_iterations, options.cg_tolerance);
+  };
+
+  // Spectral start: inverse iteration with the nets, each solve barely
+  // held to the last positions, which are then stretched back to the
+  // start's mean and spread (y kept uncorrelated with x). The positions
+  // tend to the smoothest embeddings of the nets, so the first spread
+  // sees an order set by the nets rather than by the start.
+  auto moments = [](const std::vector<double> &v) {
+    double mean = 0, var = 0;
+    for (double a : v)
+      mean += a;
+    mean /= std::max<size_t>(v.size(), 1);
+    for (double a : v)
+      var += (a - mean) * (a - mean);
+    return std::pair{mean, std::sqrt(var / std::max<size_t>(v.size(), 1))};
+  };
+  auto [mean_x, spread_x] = moments(x);
+  auto [mean_y, spread_y] = moments(y);
+  auto stretch = [&](std::vector<double> &v, double mean, double spread) {
+    auto [m, sd] = moments(v);
+    for (double &a : v)
+      a = mean + (sd > 0 ? (a - m) * spread / sd : 0.0);
+  };
+  for (int it = 0; it < options.spectral_iterations; ++it) {
+    std::vector<double> last_x = x, last_y = y;
+    solve(x, last_x, 1e-3);
+    solve(y, last_y, 1e-3);
+    stretch(x, 0.0, 1.0);
+    stretch(y, 0.0, 1.0);
+    double dot = 0;
+    for (size_t c = 0; c < num_cells; ++c)
+      dot += x[c] * y[c];
+    dot /= std::max<size_t>(num_cells, 1);
+    for (size_t c = 0; c < num_cells; ++c)
+      y[c] -= dot * x[c];
+    stretch(x, mean_x, spread_x);
+    stretch(y, mean_y, spread_y);
+  }
+
+  for (int round = 0; round < options.rounds; ++round) {
+    if (round > 0) {
+      std::vector<double> anchor_x(num_cells), anchor_y(num_cells);
+      for (size_t c = 0; c < num_cells; ++c)
+        std::tie(anchor_x[c], anchor_y[c]) = anchors[c];
+      solve(x, anchor_x, options.anchor_weight * round);
+      solve(y, anchor_y, options.anchor_weight * round);
+    }
+
+    std::vector<Point> solved(num_cells);
+    for (size_t c = 0; c < num_cells; ++c)
+      solved[c] = {x[c], y[c]};
+    double lower = hpwl(first, cells, solved);
+    anchors = spread(solved);
+    double upper = hpwl(first, cells, anchors);
+    if (upper < best_hpwl) {
+      best_hpwl = upper;
+      best = anchors;
+    }
+    if (lower >= options.stop_gap * upper)
+      break;
+  }
+  return best;
+}
+
+} // namespace vfpga
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace vfpga {
+
+struct GlobalPlacerOptions {
+  int spectral_iterations = 4; // Inverse iterations before the first spread
+  int rounds = 24;             // Solve-and-spread rounds at most
+  double anchor_weight = 0.02; // Pull towards the spread positions, per round
+  int cg_iterations = 200;     // Conjugate gradient steps per solve
+  double cg_tolerance = 1e-5;  // Relative residual that ends a solve
+  double stop_gap = 0.9;       // Stop once solved HPWL >= this * spread HPWL
+};
+
+// Analytical global placement, SimPL style. Cells are points connected by
+// nets; each axis minimises the bound-to-bound quadratic wirelength (every
+// pin of a net tied to the net's two extreme pins, weighted 2 / ((p - 1) *
+// distance) so that the quadratic matches the HPWL at the last positions),
+// solved by conjugate gradient. Each round 'spread' maps the solution to
+// overlap-free positions (a legalizer), and the next solve ties every cell
+// to its spread position by a spring of anchor_weight * round, until the
+// solved wirelength (a lower bound) nears the spread one.
+class GlobalPlacer {
+public:
+  using Point = std::pair<double, double>;
+  using Spread = std::function<std::vector<Point>(const std::vector<Point> &)>;
+
+  // The cells of net n are net_cells[net_first[n] .. net_first[n + 1]);
+  // nets on fewer than two distinct cells are ignored. Cells start at
+  // 'start' (a random legal placement will do), and the spread positions
+  // of least HPWL are returned.
+  static std::vector<Point> place(const std::vector<Point> &start,
+                                  const std::vector<uint32_t> &net_first,
+                                  const std::vector<int> &net_cells,
+                                  const Spread &spread,
+                                  const GlobalPlacerOptions &options = {});
+
+  // Half-perimeter wirelength of the nets at 'pos'
+  static double hpwl(const std::vector<uint32_t> &net_first,
+                     const std::vector<int> &net_cells,
+                     const std::vector<Point> &pos);
+};
+
+} // namespace vfpga
@@ -0,0 +1,175 @@
+#include "Hierarchy.hpp"
+#include "../utils/ThreadPool.hpp"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+
+namespace vfpga {
+
+namespace {
+
+class Flattener {
+public:
+  Flattener(const std::vector<ModuleTemplate> &modules, Netlist &out)
+      : modules(modules), out(out) {
+    for (size_t i = 0; i < modules.size(); ++i)
+      index.emplace(modules[i].name, static_cast<int>(i));
+  }
+
+  std::string error;
+
+  // Module instantiated by a cell of 'module', or -1 for a primitive
+  int instance_of(const ModuleTemplate &module, CellId c) const {
+    auto it = index.find(module.body.cell_type(c));
+    return it == index.end() ? -1 : it->second;
+  }
+
+  bool has_instances(const ModuleTemplate &module) const {
+    for (CellId c = 0; c < static_cast<CellId>(module.body.num_cells()); ++c)
+      if (instance_of(module, c) >= 0)
+        return true;
+    return false;
+  }
+
+  // The module marked "top", else the first one no other module
+  // instantiates, else the first one
+  size_t find_top() const {
+    for (size_t i = 0; i < modules.size(); ++i)
+      if (modules[i].top)
+        return i;
+    std::vector<bool> instantiated(modules.size(), false);
+    for (const auto &m : modules)
+      for (CellId c = 0; c < static_cast<CellId>(m.body.num_cells()); ++c)
+        if (int child = instance_of(m, c); child >= 0)
+          instantiated[child] = true;
+    for (size_t i = 0; i < modules.size(); ++i)
+      if (!instantiated[i])
+        return i;
+    return 0;
+  }
+
+  // Flatten 'top' into 'out'. Bits of the top module keep their numbers;
+  // internal bits of every instance get fresh numbers above them.
+  bool flatten(size_t top) {
+    const ModuleTemplate &m = modules[top];
+    for (const auto &port : m.ports)
+      out.add_port(port.name, port.direction, port.bits);
+    next_bit = m.max_bit + 1;
+    path.assign(1, static_cast<int>(top));
+    return expand(m, "", nullptr);
+  }
+
+private:
+  // Local bit -> global bit of one instance
+  using BitMap = std::unordered_map<int, int>;
+
+  const std::vector<ModuleTemplate> &modules;
+  Netlist &out;
+  std::unordered_map<std::string_view, int> index;
+  std::vector<int> path; // Modules being expanded, to catch recursion
+  int next_bit = 2;
+
+  static int local_bit(const Netlist &body, NetId net) {
+    return net == CONST0_NET   ? 0
+           : net == CONST1_NET ? 1
+           : is_wire(net)      ? body.net_bit(net)
+                               : UNDEFINED_BIT;
+  }
+
+  // 'map' is null for the top module, whose bits map to themselves
+  int global_bit(BitMap *map, int bit) {
+    if (!map || bit < 2)
+      return bit;
+    auto [it, inserted] = map->try_emplace(bit, next_bit);
+    if (inserted)
+      ++next_bit;
+    return it->second;
+  }
+
+  bool expand(const ModuleTemplate &m, const std::string &prefix,
+              BitMap *map) {
+    const Netlist &body = m.body;
+    std::vector<int> bits;
+    for (CellId c = 0; c < static_cast<CellId>(body.num_cells()); ++c) {
+      std::string name = prefix + std::string(body.cell_name(c));
+      int child = instance_of(m, c);
+
+      if (child < 0) {
+        CellId cell = out.add_cell(name, body.cell_type(c));
+        for (const auto &param : body.params(c))
+          out.add_param(cell, body.name(param.key), param.value);
+        for (PinId p = body.first_pin(c); p < body.end_pin(c); ++p) {
+          bits.clear();
+          for (NetId net : body.nets_of(p))
+            bits.push_back(global_bit(map, local_bit(body, net)));
+          out.add_pin(cell, body.pin_name(p), body.pin(p).direction, bits);
+        }
+        continue;
+      }
+
+      if (std::find(path.begin(), path.end(), child) != path.end()) {
+        error = "Error: Module " + modules[child].name +
+                " instantiates itself (via " + name + ")";
+        return false;
+      }
+
+      // Bind the child's port bits to the nets of this instance's
+      // connections; all other child bits become fresh nets
+      const ModuleTemplate &sub = modules[child];
+      BitMap child_map;
+      for (const auto &port : sub.ports) {
+        auto pin = body.find_pin(c, port.name);
+        if (!pin)
+          continue;
+        auto nets = body.nets_of(*pin);
+        for (size_t i = 0; i < port.bits.size() && i < nets.size(); ++i)
+          if (port.bits[i] >= 2)
+            child_map.emplace(port.bits[i],
+                              global_bit(map, local_bit(body, nets[i])));
+      }
+
+      path.push_back(child);
+      if (!expand(sub, name + ".", &child_map))
+        return false;
+      path.pop_back();
+    }
+    return true;
+  }
+};
+
+} // namespace
+
+void Hierarchy::parse_modules(size_t count, ThreadPool *pool,
+                              const std::function<void(size_t)> &parse) {
+  if (count == 1) {
+    parse(0);
+    return;
+  }
+  std::unique_ptr<ThreadPool> local_pool;
+  if (!pool) {
+    size_t threads = std::min<size_t>(
+        count, std::max(1u, std::thread::hardware_concurrency()));
+    local_pool = std::make_unique<ThreadPool>(threads);
+    pool = local_pool.get();
+  }
+  pool->parallel_for(0, count, parse);
+}
+
+std::optional<Netlist>
+Hierarchy::flatten(std::vector<ModuleTemplate> &modules) {
+  Netlist netlist;
+  Flattener flattener(modules, netlist);
+  size_t top = flattener.find_top();
+  if (!flattener.has_instances(modules[top]))
+    return std::move(modules[top].body); // Already flat
+
+  if (!flattener.flatten(top)) {
+    std::cerr << flattener.error << std::endl;
+    return std::nullopt;
+  }
+  return netlist;
+}
+
+} // namespace vfpga
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Netlist.hpp"
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vfpga {
+
+class ThreadPool;
+
+// Bit number of undefined ("x"/"z") bits in module bodies. Bits 0 and 1 are
+// the constants, as in Yosys.
+constexpr int UNDEFINED_BIT = -1;
+
+// One parsed module of a hierarchical design. Instances of other modules
+// are ordinary cells whose type is the module name and whose pins are
+// named after the module's ports; they are expanded only when flattening.
+struct ModuleTemplate {
+  struct Port {
+    std::string name;
+    PortDirection direction = PortDirection::INOUT;
+    std::vector<int> bits;
+  };
+
+  std::string name;
+  Netlist body;
+  std::vector<Port> ports;
+  bool top = false; // Explicitly marked as the top module
+  int max_bit = 1;
+  std::string error; // Non-empty if parsing failed
+};
+
+// Flattening of parsed modules, shared by the netlist frontends
+class Hierarchy {
+public:
+  // Call parse(i) for each of 'count' modules. Several modules are parsed
+  // concurrently, on 'pool' or on a temporary pool if it is null.
+  static void parse_modules(size_t count, ThreadPool *pool,
+                            const std::function<void(size_t)> &parse);
+
+  // Flatten the design below the top module (the one marked 'top', else
+  // the first one no other module instantiates) into one Netlist.
+  // Instance cells are named by their path, e.g. "cpu.alu.add0"; each
+  // template is expanded once per instance. Bits of the top module keep
+  // their numbers and internal bits of instances get fresh ones. A design
+  // without instances is moved out of 'modules' unchanged. Reports errors
+  // (e.g. recursive instantiation) to std::cerr and returns nullopt.
+  static std::optional<Netlist> flatten(std::vector<ModuleTemplate> &modules);
+};
+
+} // namespace vfpga
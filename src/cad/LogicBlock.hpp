@@ -1,7 +1,8 @@
 #pragma once
 
-#include "../fabric/Tile.hpp"
-#include "../primitives/LUT.hpp"
+#include "../fabric/Fabric.hpp"
+#include "Netlist.hpp"
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -17,17 +18,26 @@ struct LogicBlock {
   bool use_lut;
   bool use_dff;
 
-  // LUT Configuration (if used)
-  std::vector<LogicVal> lut_mask;
+  // LUT Configuration (if used): bit i is the output for input index i
+  // over all Fabric::LUT_INPUTS inputs, as in Fabric::lut_masks
+  uint16_t lut_mask = Fabric::LUT_PASSTHROUGH;
 
   // Connectivity
-  // Map port names (LUT inputs, DFF input, Output) to Net names
-  std::vector<std::string> input_nets; // e.g. ["net_1", "net_2", ...]
-  std::string output_net;              // e.g. "net_3"
-  std::string clock_net;
+  // Netlist nets of the block's pin bits (LUT inputs in mask order, DFF
+  // input, hard block input bits) and output
+  std::vector<NetId> input_nets;
+  NetId output_net = NO_NET;
+  NetId clock_net = NO_NET;
 
   LogicBlock(int _id, std::string _name)
       : id(_id), name(_name), use_lut(false), use_dff(false) {}
 };
 
+// Blocks placed together in one CLB site (see Fabric::CLB_LES); hard
+// blocks (BRAM, DSP) form clusters of their own
+struct Cluster {
+  std::vector<int> blocks;   // Indices into the packed blocks
+  std::vector<NetId> inputs; // Nets read from outside the cluster
+};
+
 } // namespace vfpga
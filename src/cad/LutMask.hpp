@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace vfpga {
+
+// LUT truth tables of up to 6 inputs as 64-bit masks: bit i is the output
+// for the input vector whose bit k is input k (input 0 is the LSB, as in
+// Yosys $lut cells).
+class LutMask {
+public:
+  static constexpr int MAX_WIDTH = 6;
+
+  // Decode a $lut "LUT" parameter: a binary string of at least 2^width
+  // digits (MSB first, as Yosys writes it; longer strings keep their low
+  // bits), or else a decimal number (JSON numbers, e.g. "6" for XOR2).
+  // nullopt if the width is unsupported or the value is not a mask.
+  static std::optional<uint64_t> parse(std::string_view value, int width) {
+    if (width < 0 || width > MAX_WIDTH || value.empty())
+      return std::nullopt;
+    size_t size = size_t{1} << width;
+    uint64_t mask = 0;
+    if (value.size() >= size &&
+        value.find_first_not_of("01") == std::string_view::npos) {
+      if (value.size() > size)
+        value = value.substr(value.size() - size);
+      for (char c : value)
+        mask = (mask << 1) | (c == '1');
+    } else if (value.find_first_not_of("0123456789") ==
+               std::string_view::npos) {
+      for (char c : value) {
+        if (mask > (UINT64_MAX - 9) / 10)
+          return std::nullopt;
+        mask = mask * 10 + (c - '0');
+      }
+    } else {
+      return std::nullopt;
+    }
+    return mask & full(width);
+  }
+
+  // Binary string of 2^width characters, MSB first
+  static std::string format(uint64_t mask, int width) {
+    size_t size = size_t{1} << width;
+    std::string value(size, '0');
+    for (size_t i = 0; i < size; ++i)
+      if ((mask >> i) & 1)
+        value[size - 1 - i] = '1';
+    return value;
+  }
+
+  // All 2^width entries set
+  static uint64_t full(int width) {
+    return width >= MAX_WIDTH ? ~uint64_t{0}
+                              : (uint64_t{1} << (uint64_t{1} << width)) - 1;
+  }
+
+  // Truth table of input k alone
+  static uint64_t input(int k) {
+    static constexpr uint64_t INPUTS[MAX_WIDTH] = {
+        0xAAAAAAAAAAAAAAAA, 0xCCCCCCCCCCCCCCCC, 0xF0F0F0F0F0F0F0F0,
+        0xFF00FF00FF00FF00, 0xFFFF0000FFFF0000, 0xFFFFFFFF00000000};
+    return INPUTS[k];
+  }
+
+  // Truth table of a function of 'inputs.size()' signals whose own truth
+  // tables (over some common variables) are 'inputs'
+  static uint64_t compose(uint64_t mask, std::span<const uint64_t> inputs) {
+    uint64_t out = 0;
+    for (uint64_t m = 0; m < (uint64_t{1} << inputs.size()); ++m) {
+      if (!((mask >> m) & 1))
+        continue;
+      uint64_t term = ~uint64_t{0};
+      for (size_t k = 0; k < inputs.size(); ++k)
+        term &= ((m >> k) & 1) ? inputs[k] : ~inputs[k];
+      out |= term;
+    }
+    return out;
+  }
+
+  // Mask of width-1 inputs with input 'k' fixed to 'value'
+  static uint64_t cofactor(uint64_t mask, int width, int k, bool value) {
+    return remap(mask, width - 1, [&](uint64_t j) {
+      return insert_bit(j, k, value);
+    });
+  }
+
+  static bool depends_on(uint64_t mask, int width, int k) {
+    return cofactor(mask, width, k, false) != cofactor(mask, width, k, true);
+  }
+
+  // Input 'k' is the same signal as input 'keep' (keep < k): the mask of
+  // width-1 inputs without 'k'
+  static uint64_t merge_inputs(uint64_t mask, int width, int keep, int k) {
+    return remap(mask, width - 1, [&](uint64_t j) {
+      return insert_bit(j, k, (j >> keep) & 1);
+    });
+  }
+
+  // Exchange inputs k and k+1
+  static uint64_t swap_inputs(uint64_t mask, int width, int k) {
+    return remap(mask, width, [&](uint64_t j) {
+      uint64_t a = (j >> k) & 1, b = (j >> (k + 1)) & 1;
+      return (j & ~(uint64_t{3} << k)) | (a << (k + 1)) | (b << k);
+    });
+  }
+
+private:
+  // Entry j of the result is entry source(j) of 'mask'
+  template <typename Fn>
+  static uint64_t remap(uint64_t mask, int width, Fn &&source) {
+    uint64_t out = 0;
+    for (uint64_t j = 0; j < (uint64_t{1} << width); ++j)
+      out |= ((mask >> source(j)) & 1) << j;
+    return out;
+  }
+
+  // Index with a bit of value 'v' inserted at position k
+  static uint64_t insert_bit(uint64_t j, int k, bool v) {
+    uint64_t low = j & ((uint64_t{1} << k) - 1);
+    return ((j >> k) << (k + 1)) | (uint64_t{v} << k) | low;
+  }
+};
+
+} // namespace vfpga
@@ -0,0 +1,387 @@
+#include "Netlist.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace vfpga {
+
+void Netlist::check_last(CellId id) const {
+  if (cells.empty() || id != static_cast<CellId>(cells.size()) - 1)
+    throw std::runtime_error("Netlist: pins and parameters can only be added "
+                             "to the last cell");
+}
+
+size_t Netlist::add_port(std::string_view name, PortDirection direction,
+                         std::span<const int> bits) {
+  Port p;
+  p.name = names.intern(name);
+  p.direction = direction;
+  p.first_bit = static_cast<uint32_t>(port_net_ids.size());
+  p.num_bits = static_cast<uint32_t>(bits.size());
+  for (int bit : bits)
+    port_net_ids.push_back(net_of_bit(bit));
+  ports.push_back(p);
+  if (direction == PortDirection::INPUT)
+    inputs.emplace_back(name);
+  else if (direction == PortDirection::OUTPUT)
+    outputs.emplace_back(name);
+  return ports.size() - 1;
+}
+
+CellId Netlist::add_cell(std::string_view name, std::string_view type) {
+  CellId id = static_cast<CellId>(cells.size());
+  Cell c;
+  c.name = names.intern(name);
+  c.type = names.intern(type);
+  c.first_pin = static_cast<uint32_t>(pins.size());
+  c.first_param = static_cast<uint32_t>(parameters.size());
+  cells.push_back(c);
+
+  if (cell_by_name.size() <= static_cast<size_t>(c.name))
+    cell_by_name.resize(names.size(), -1);
+  cell_by_name[c.name] = id;
+  return id;
+}
+
+void Netlist::add_param(CellId cell, std::string_view key, std::string value) {
+  check_last(cell);
+  NameId k = names.intern(key);
+  Cell &c = cells[cell];
+  for (uint32_t i = c.first_param; i < c.first_param + c.num_params; ++i) {
+    if (parameters[i].key == k) {
+      parameters[i].value = std::move(value);
+      return;
+    }
+  }
+  parameters.push_back({k, std::move(value)});
+  ++c.num_params;
+}
+
+PinId Netlist::add_pin(CellId cell, std::string_view port,
+                       PortDirection direction, std::span<const int> bits) {
+  check_last(cell);
+  PinId id = static_cast<PinId>(pins.size());
+  Pin p;
+  p.cell = cell;
+  p.port = names.intern(port);
+  p.direction = direction;
+  p.first_bit = static_cast<uint32_t>(pin_net_ids.size());
+  p.num_bits = static_cast<uint32_t>(bits.size());
+  for (int bit : bits) {
+    NetId net = net_of_bit(bit);
+    int32_t slot = static_cast<int32_t>(pin_net_ids.size());
+    pin_net_ids.push_back(net);
+    bit_pin.push_back(id);
+    bit_next.push_back(-1);
+    if (!is_wire(net))
+      continue;
+
+    NetPins &np = net_pins[net];
+    SlotList &list =
+        direction == PortDirection::OUTPUT ? np.drivers : np.sinks;
+    if (list.tail < 0)
+      list.head = slot;
+    else
+      bit_next[list.tail] = slot;
+    list.tail = slot;
+    ++list.count;
+  }
+  pins.push_back(p);
+  ++cells[cell].num_pins;
+  return id;
+}
+
+NetId Netlist::net_of_bit(int bit) {
+  return bit >= 2   ? net_for_bit(bit)
+         : bit == 0 ? CONST0_NET
+         : bit == 1 ? CONST1_NET
+                    : NO_NET;
+}
+
+NetId Netlist::net_for_bit(int bit) {
+  NetId *slot;
+  if (static_cast<size_t>(bit) < net_by_bit.size()) {
+    slot = &net_by_bit[bit];
+  } else if (static_cast<size_t>(bit) < 2 * net_bits.size() + 1024) {
+    // Frontends number bits (nearly) consecutively, so the dense table
+    // grows geometrically with the nets
+    net_by_bit.resize(std::max<size_t>(bit + 1, 2 * net_by_bit.size()),
+                      NO_NET);
+    // Outlying bits the table now covers move into it, so every bit is
+    // looked up in exactly one place
+    for (auto it = sparse_net_by_bit.begin(); it != sparse_net_by_bit.end();) {
+      if (static_cast<size_t>(it->first) < net_by_bit.size()) {
+        net_by_bit[it->first] = it->second;
+        it = sparse_net_by_bit.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    slot = &net_by_bit[bit];
+  } else {
+    slot = &sparse_net_by_bit.try_emplace(bit, NO_NET).first->second;
+  }
+  if (*slot == NO_NET) {
+    *slot = static_cast<NetId>(net_bits.size());
+    net_bits.push_back(bit);
+    net_pins.emplace_back();
+  }
+  return *slot;
+}
+
+std::vector<CellId> Netlist::fanout_cells(CellId id) const {
+  std::vector<CellId> result;
+  std::unordered_set<CellId> seen;
+  for (PinId p = first_pin(id); p < end_pin(id); ++p) {
+    if (pins[p].direction != PortDirection::OUTPUT)
+      continue;
+    for (NetId net : nets_of(p))
+      if (is_wire(net))
+        for (PinId sink : sinks(net))
+          if (seen.insert(pins[sink].cell).second)
+            result.push_back(pins[sink].cell);
+  }
+  return result;
+}
+
+std::vector<CellId> Netlist::fanin_cells(CellId id) const {
+  std::vector<CellId> result;
+  std::unordered_set<CellId> seen;
+  for (PinId p = first_pin(id); p < end_pin(id); ++p) {
+    if (pins[p].direction == PortDirection::OUTPUT)
+      continue;
+    for (NetId net : nets_of(p))
+      if (is_wire(net))
+        for (PinId drv : drivers(net))
+          if (seen.insert(pins[drv].cell).second)
+            result.push_back(pins[drv].cell);
+  }
+  return result;
+}
+
+std::optional<CellId> Netlist::find_cell(std::string_view name) const {
+  auto id = names.find(name);
+  if (!id || static_cast<size_t>(*id) >= cell_by_name.size() ||
+      cell_by_name[*id] < 0)
+    return std::nullopt;
+  return cell_by_name[*id];
+}
+
+const std::string *Netlist::param(CellId id, std::string_view key) const {
+  auto k = names.find(key);
+  if (!k)
+    return nullptr;
+  for (const auto &p : params(id))
+    if (p.key == *k)
+      return &p.value;
+  return nullptr;
+}
+
+std::optional<PinId> Netlist::find_pin(CellId id, std::string_view port) const {
+  auto k = names.find(port);
+  if (!k)
+    return std::nullopt;
+  for (PinId p = first_pin(id); p < end_pin(id); ++p)
+    if (pins[p].port == *k)
+      return p;
+  return std::nullopt;
+}
+
+std::optional<NetId> Netlist::find_net(int bit) const {
+  if (bit >= 0 && static_cast<size_t>(bit) < net_by_bit.size() &&
+      net_by_bit[bit] != NO_NET)
+    return net_by_bit[bit];
+  auto it = sparse_net_by_bit.find(bit);
+  if (it == sparse_net_by_bit.end())
+    return std::nullopt;
+  return it->second;
+}
+
+size_t Netlist::bytes() const {
+  size_t total = names.bytes();
+  total += ports.capacity() * sizeof(Port);
+  total += port_net_ids.capacity() * sizeof(NetId);
+  total += cells.capacity() * sizeof(Cell) + pins.capacity() * sizeof(Pin);
+  total += parameters.capacity() * sizeof(Parameter);
+  for (const auto &p : parameters)
+    if (p.value.capacity() > 15) // Beyond the small-string buffer
+      total += p.value.capacity() + 1;
+  total += cell_by_name.capacity() * sizeof(CellId);
+  total += pin_net_ids.capacity() * sizeof(NetId);
+  total += net_bits.capacity() * sizeof(int);
+  total += net_by_bit.capacity() * sizeof(NetId);
+  total += sparse_net_by_bit.size() *
+           (sizeof(int) + sizeof(NetId) + 2 * sizeof(void *));
+  total += net_pins.capacity() * sizeof(NetPins);
+  total += bit_pin.capacity() * sizeof(PinId);
+  total += bit_next.capacity() * sizeof(int32_t);
+  return total;
+}
+
+void Netlist::write(BinaryWriter &w) const {
+  names.write(w);
+  w.write_vector(ports);
+  w.write_vector(port_net_ids);
+  w.write<uint64_t>(inputs.size());
+  for (const auto &s : inputs)
+    w.write_string(s);
+  w.write<uint64_t>(outputs.size());
+  for (const auto &s : outputs)
+    w.write_string(s);
+
+  w.write_vector(cells);
+  w.write_vector(pins);
+  // Parameter values are variable length: keys, then the values back to
+  // back with their end offsets
+  std::vector<NameId> keys;
+  std::vector<uint64_t> ends;
+  std::vector<char> values;
+  keys.reserve(parameters.size());
+  ends.reserve(parameters.size());
+  for (const auto &p : parameters) {
+    keys.push_back(p.key);
+    values.insert(values.end(), p.value.begin(), p.value.end());
+    ends.push_back(values.size());
+  }
+  w.write_vector(keys);
+  w.write_vector(ends);
+  w.write_vector(values);
+
+  w.write_vector(cell_by_name);
+  w.write_vector(pin_net_ids);
+  w.write_vector(net_bits);
+  w.write_vector(net_by_bit);
+  std::vector<int> sparse_bits;
+  std::vector<NetId> sparse_nets;
+  for (const auto &[bit, net] : sparse_net_by_bit) {
+    sparse_bits.push_back(bit);
+    sparse_nets.push_back(net);
+  }
+  w.write_vector(sparse_bits);
+  w.write_vector(sparse_nets);
+  w.write_vector(net_pins);
+  w.write_vector(bit_pin);
+  w.write_vector(bit_next);
+}
+
+Netlist Netlist::read(MemoryReader &r) {
+  Netlist n;
+  n.names = StringInterner::read(r);
+  n.ports = r.read_vector<Port>();
+  n.port_net_ids = r.read_vector<NetId>();
+  for (auto *list : {&n.inputs, &n.outputs}) {
+    uint64_t count = r.read<uint64_t>();
+    if (count > r.remaining() / sizeof(uint32_t))
+      throw std::runtime_error("Netlist: corrupt port list");
+    for (uint64_t i = 0; i < count; ++i)
+      list->push_back(r.read_string());
+  }
+
+  n.cells = r.read_vector<Cell>();
+  n.pins = r.read_vector<Pin>();
+  auto keys = r.read_vector<NameId>();
+  auto ends = r.read_vector<uint64_t>();
+  auto values = r.read_vector<char>();
+  if (keys.size() != ends.size())
+    throw std::runtime_error("Netlist: corrupt parameters");
+  n.parameters.reserve(keys.size());
+  uint64_t begin = 0;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (ends[i] < begin || ends[i] > values.size())
+      throw std::runtime_error("Netlist: corrupt parameters");
+    n.parameters.push_back(
+        {keys[i], std::string(values.data() + begin, ends[i] - begin)});
+    begin = ends[i];
+  }
+
+  n.cell_by_name = r.read_vector<CellId>();
+  n.pin_net_ids = r.read_vector<NetId>();
+  n.net_bits = r.read_vector<int>();
+  n.net_by_bit = r.read_vector<NetId>();
+  auto sparse_bits = r.read_vector<int>();
+  auto sparse_nets = r.read_vector<NetId>();
+  if (sparse_bits.size() != sparse_nets.size())
+    throw std::runtime_error("Netlist: corrupt bit map");
+  for (size_t i = 0; i < sparse_bits.size(); ++i)
+    n.sparse_net_by_bit.emplace(sparse_bits[i], sparse_nets[i]);
+  n.net_pins = r.read_vector<NetPins>();
+  n.bit_pin = r.read_vector<PinId>();
+  n.bit_next = r.read_vector<int32_t>();
+
+  if (!n.consistent())
+    throw std::runtime_error("Netlist: corrupt image");
+  return n;
+}
+
+bool Netlist::consistent() const {
+  auto below = [](auto value, size_t limit) {
+    return value >= 0 && static_cast<size_t>(value) < limit;
+  };
+  const size_t num_names = names.size(), num_slots = pin_net_ids.size();
+  const size_t nets = net_bits.size();
+  bool ok = net_pins.size() == nets && bit_pin.size() == num_slots &&
+            bit_next.size() == num_slots && cell_by_name.size() <= num_names;
+
+  uint64_t next_port_bit = 0;
+  for (const Port &p : ports) {
+    ok = ok && below(p.name, num_names) && p.first_bit == next_port_bit &&
+         p.direction >= PortDirection::INPUT &&
+         p.direction <= PortDirection::INOUT;
+    next_port_bit += p.num_bits;
+  }
+  ok = ok && next_port_bit == port_net_ids.size();
+  for (NetId net : port_net_ids)
+    ok = ok && (net >= CONST1_NET && net < static_cast<NetId>(nets));
+
+  uint64_t next_pin = 0, next_param = 0;
+  for (const Cell &c : cells) {
+    ok = ok && below(c.name, num_names) && below(c.type, num_names) &&
+         c.first_pin == next_pin && c.first_param == next_param;
+    next_pin += c.num_pins;
+    next_param += c.num_params;
+  }
+  ok = ok && next_pin == pins.size() && next_param == parameters.size();
+
+  uint64_t next_bit = 0;
+  for (const Pin &p : pins) {
+    ok = ok && below(p.cell, cells.size()) && below(p.port, num_names) &&
+         p.first_bit == next_bit && p.direction >= PortDirection::INPUT &&
+         p.direction <= PortDirection::INOUT;
+    next_bit += p.num_bits;
+  }
+  ok = ok && next_bit == num_slots;
+  for (const auto &p : parameters)
+    ok = ok && below(p.key, num_names);
+
+  for (CellId c : cell_by_name)
+    ok = ok && (c == -1 || below(c, cells.size()));
+  for (NetId net : pin_net_ids)
+    ok = ok && (net >= CONST1_NET && net < static_cast<NetId>(nets));
+  for (NetId net : net_by_bit)
+    ok = ok && (net == NO_NET || below(net, nets));
+  for (const auto &[bit, net] : sparse_net_by_bit)
+    ok = ok && below(net, nets) && !below(bit, net_by_bit.size());
+  for (PinId p : bit_pin)
+    ok = ok && below(p, pins.size());
+  for (int32_t s : bit_next)
+    ok = ok && (s == -1 || below(s, num_slots));
+  if (!ok)
+    return false;
+
+  // Each list must end at its tail after exactly 'count' slots, so
+  // iterating it terminates
+  for (const NetPins &np : net_pins) {
+    for (const SlotList *l : {&np.drivers, &np.sinks}) {
+      int32_t slot = l->head, last = -1;
+      for (uint32_t i = 0; i < l->count && slot != -1; ++i) {
+        last = slot;
+        slot = bit_next[slot];
+      }
+      if (slot != -1 || last != l->tail)
+        return false;
+    }
+  }
+  return true;
+}
+
+} // namespace vfpga
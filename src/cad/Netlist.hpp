@@ -1,90 +1,253 @@
 #pragma once
 
-#include <iostream>
-#include <map>
-#include <memory>
+#include "../utils/StringInterner.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace vfpga {
 
-// Forward declarations
-class Cell;
-class Net;
+using CellId = int32_t;
+using PinId = int32_t;
+using NetId = int32_t;
 
-enum class PortDirection { INPUT, OUTPUT, INOUT };
+// Pseudo-nets for bits that are not wires. They appear in a pin's bits (so
+// bit positions are preserved) but are never driven and have no sinks.
+constexpr NetId NO_NET = -1;     // Unconnected, "x" or "z"
+constexpr NetId CONST0_NET = -2; // Yosys bit "0"
+constexpr NetId CONST1_NET = -3; // Yosys bit "1"
 
-struct Port {
-  std::string name;
-  PortDirection direction;
-  std::shared_ptr<Net> connected_net;
+inline bool is_wire(NetId id) { return id >= 0; }
 
-  Port(std::string n, PortDirection d)
-      : name(n), direction(d), connected_net(nullptr) {}
-};
+enum class PortDirection { INPUT, OUTPUT, INOUT };
 
-class Cell {
+// Flat netlist: cells, pins (cell ports) and nets live in contiguous arrays
+// and refer to each other by integer ID. Names, cell types, port names and
+// parameter keys are interned.
+//
+// Pin -> net connectivity is stored in compressed sparse row form: each pin
+// owns a slice of 'pin_net_ids' (one net per port bit, in bit order).
+// Net -> pin connectivity is kept as per-net driver and sink lists threaded
+// through the same bit slots, updated by add_pin(), so fanout and fanin
+// queries are always current and never scan the netlist. Output pins are
+// drivers; input and inout pins are sinks.
+// Nets are identified by their Yosys bit number; names such as "net_5" are
+// only synthesized on demand. Following Yosys, bits 0 and 1 are the
+// constants and negative bits are undefined ("x"/"z").
+class Netlist {
 public:
-  std::string name;
-  std::string type; // e.g., "$lut", "$dff", "AND2"
-  std::map<std::string, Port> ports;
-  std::map<std::string, std::string> parameters; // e.g., LUT_MASK -> "0xF"
-
-  Cell(std::string n, std::string t) : name(n), type(t) {}
-
-  void add_port(std::string port_name, PortDirection dir) {
-    ports.emplace(port_name, Port(port_name, dir));
+  struct Cell {
+    NameId name;
+    NameId type;
+    uint32_t first_pin = 0, num_pins = 0;
+    uint32_t first_param = 0, num_params = 0;
+  };
+
+  struct Pin {
+    CellId cell;
+    NameId port;
+    PortDirection direction;
+    uint32_t first_bit = 0, num_bits = 0;
+  };
+
+  struct Parameter {
+    NameId key;
+    std::string value; // e.g. LUT -> "0110", WIDTH -> "2"
+  };
+
+  struct Port {
+    NameId name;
+    PortDirection direction;
+    uint32_t first_bit = 0, num_bits = 0;
+  };
+
+  std::vector<std::string> inputs;  // Names of the top-level inputs
+  std::vector<std::string> outputs; // Names of the top-level outputs
+
+  // Building. Cells are appended one at a time, and pins and parameters can
+  // only be added to the most recently added cell, which keeps every
+  // cell's slices contiguous.
+  CellId add_cell(std::string_view name, std::string_view type);
+  void add_param(CellId cell, std::string_view key, std::string value);
+  // 'bits' are Yosys bit numbers; each distinct bit >= 2 is one net
+  PinId add_pin(CellId cell, std::string_view port, PortDirection direction,
+                std::span<const int> bits = {});
+
+  // Top-level port, whose bits map to nets like pin bits do (ports are
+  // neither drivers nor sinks). Input and output ports are also listed by
+  // name in 'inputs' / 'outputs'.
+  size_t add_port(std::string_view name, PortDirection direction,
+                  std::span<const int> bits = {});
+
+  // Sizes
+  size_t num_ports() const { return ports.size(); }
+  size_t num_cells() const { return cells.size(); }
+  size_t num_pins() const { return pins.size(); }
+  size_t num_nets() const { return net_bits.size(); }
+
+  // Ports
+  const Port &port(size_t i) const { return ports[i]; }
+  std::string_view port_name(size_t i) const {
+    return names.str(ports[i].name);
+  }
+  std::span<const NetId> port_nets(size_t i) const {
+    return {port_net_ids.data() + ports[i].first_bit, ports[i].num_bits};
   }
-};
-
-class Net {
-public:
-  std::string name;
-  // We could store list of connected ports here for faster traversal
-  // but for now, connectivity is stored in Port::connected_net
 
-  Net(std::string n) : name(n) {}
-};
+  // Cells
+  const Cell &cell(CellId id) const { return cells[id]; }
+  std::string_view cell_name(CellId id) const {
+    return names.str(cells[id].name);
+  }
+  std::string_view cell_type(CellId id) const {
+    return names.str(cells[id].type);
+  }
+  std::optional<CellId> find_cell(std::string_view name) const;
 
-class Netlist {
-public:
-  std::map<std::string, std::shared_ptr<Cell>> cells;
-  std::map<std::string, std::shared_ptr<Net>> nets;
-  std::vector<std::string> inputs;  // Top-level inputs
-  std::vector<std::string> outputs; // Top-level outputs
-
-  std::shared_ptr<Cell> add_cell(std::string name, std::string type) {
-    auto cell = std::make_shared<Cell>(name, type);
-    cells[name] = cell;
-    return cell;
+  std::span<const Parameter> params(CellId id) const {
+    const Cell &c = cells[id];
+    return {parameters.data() + c.first_param, c.num_params};
   }
+  // nullptr if the cell has no such parameter
+  const std::string *param(CellId id, std::string_view key) const;
+
+  // Pins
+  const Pin &pin(PinId id) const { return pins[id]; }
+  std::string_view pin_name(PinId id) const { return names.str(pins[id].port); }
+  // IDs of a cell's pins, in the order they were added
+  PinId first_pin(CellId id) const { return cells[id].first_pin; }
+  PinId end_pin(CellId id) const {
+    return cells[id].first_pin + cells[id].num_pins;
+  }
+  std::optional<PinId> find_pin(CellId id, std::string_view port) const;
 
-  std::shared_ptr<Net> add_net(std::string name) {
-    if (nets.find(name) == nets.end()) {
-      nets[name] = std::make_shared<Net>(name);
-    }
-    return nets[name];
+  std::span<const NetId> nets_of(PinId id) const {
+    const Pin &p = pins[id];
+    return {pin_net_ids.data() + p.first_bit, p.num_bits};
+  }
+  // Net of the last wire bit of the port (the single-bit view of a port),
+  // or NO_NET if no wire is connected
+  NetId net_of(PinId id) const {
+    auto nets = nets_of(id);
+    for (size_t i = nets.size(); i-- > 0;)
+      if (is_wire(nets[i]))
+        return nets[i];
+    return NO_NET;
   }
 
-  // Connect a cell port to a net
-  void connect(std::string cell_name, std::string port_name,
-               std::string net_name) {
-    auto cell_it = cells.find(cell_name);
-    auto net = add_net(net_name);
-
-    if (cell_it != cells.end()) {
-      auto &port_map = cell_it->second->ports;
-      auto port_it = port_map.find(port_name);
-      if (port_it != port_map.end()) {
-        port_it->second.connected_net = net;
-      } else {
-        std::cerr << "Warning: Port " << port_name << " not found in cell "
-                  << cell_name << std::endl;
+  // Nets
+  int net_bit(NetId id) const { return net_bits[id]; }
+  std::string net_name(NetId id) const {
+    return "net_" + std::to_string(net_bits[id]);
+  }
+  std::optional<NetId> find_net(int bit) const;
+
+  // Forward range over the pins of one driver or sink list, in the order
+  // they were connected. A pin appears once per bit on the net.
+  class PinList {
+  public:
+    class iterator {
+    public:
+      PinId operator*() const { return list->bit_pin[slot]; }
+      iterator &operator++() {
+        slot = list->bit_next[slot];
+        return *this;
       }
-    } else {
-      std::cerr << "Warning: Cell " << cell_name << " not found" << std::endl;
-    }
+      bool operator!=(const iterator &o) const { return slot != o.slot; }
+
+    private:
+      friend class PinList;
+      iterator(const Netlist *l, int32_t s) : list(l), slot(s) {}
+      const Netlist *list;
+      int32_t slot;
+    };
+
+    iterator begin() const { return {list, head}; }
+    iterator end() const { return {list, -1}; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+  private:
+    friend class Netlist;
+    PinList(const Netlist *l, int32_t h, uint32_t n)
+        : list(l), head(h), count(n) {}
+    const Netlist *list;
+    int32_t head;
+    uint32_t count;
+  };
+
+  PinList drivers(NetId id) const {
+    const NetPins &n = net_pins[id];
+    return {this, n.drivers.head, n.drivers.count};
   }
+  PinList sinks(NetId id) const {
+    const NetPins &n = net_pins[id];
+    return {this, n.sinks.head, n.sinks.count};
+  }
+  // Number of sink pin bits on a net
+  size_t fanout(NetId id) const { return net_pins[id].sinks.count; }
+  // First driver of a net, or -1 if it is undriven (e.g. a top-level input)
+  PinId driver(NetId id) const {
+    int32_t slot = net_pins[id].drivers.head;
+    return slot < 0 ? -1 : bit_pin[slot];
+  }
+
+  // Distinct cells reading a net driven by 'id' / driving a net 'id' reads,
+  // in order of first appearance
+  std::vector<CellId> fanout_cells(CellId id) const;
+  std::vector<CellId> fanin_cells(CellId id) const;
+
+  // Names
+  std::string_view name(NameId id) const { return names.str(id); }
+  std::optional<NameId> find_name(std::string_view s) const {
+    return names.find(s);
+  }
+
+  // Approximate heap footprint
+  size_t bytes() const;
+
+  // Binary image of all arrays, including the name table and the driver and
+  // sink lists, so loading rebuilds nothing. read() checks every stored
+  // index and throws std::runtime_error on corrupt input.
+  void write(BinaryWriter &w) const;
+  static Netlist read(MemoryReader &r);
+
+private:
+  StringInterner names;
+  std::vector<Port> ports;
+  std::vector<NetId> port_net_ids; // Port -> nets (CSR values)
+  std::vector<Cell> cells;
+  std::vector<Pin> pins;
+  std::vector<Parameter> parameters;
+  std::vector<CellId> cell_by_name; // Indexed by NameId, -1 if not a cell
+
+  std::vector<NetId> pin_net_ids; // Pin -> nets (CSR values)
+  std::vector<int> net_bits;      // NetId -> Yosys bit number
+  std::vector<NetId> net_by_bit; // Bit -> net, NO_NET if none
+  std::unordered_map<int, NetId> sparse_net_by_bit; // Outlying bits
+
+  // Net -> pins: singly linked lists of bit slots (indices into
+  // pin_net_ids), so appending never moves or allocates per net
+  struct SlotList {
+    int32_t head = -1, tail = -1;
+    uint32_t count = 0;
+  };
+  struct NetPins {
+    SlotList drivers, sinks;
+  };
+  std::vector<NetPins> net_pins;
+  std::vector<PinId> bit_pin;     // Slot -> owning pin
+  std::vector<int32_t> bit_next;  // Slot -> next slot in its list, or -1
+
+  NetId net_of_bit(int bit); // Pseudo-nets for bits < 2
+  NetId net_for_bit(int bit);
+  void check_last(CellId id) const;
+  // Every stored index is in range (for images read from disk)
+  bool consistent() const;
 };
 
 } // namespace vfpga
@@ -0,0 +1,355 @@
+#include "Optimizer.hpp"
+#include "LutMask.hpp"
+#include "../utils/Hash.hpp"
+#include <algorithm>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace vfpga {
+
+namespace {
+
+// A $lut cell with a decoded mask. Input k of the mask is inputs[k].
+struct Lut {
+  CellId cell;
+  std::vector<NetId> inputs;
+  uint64_t mask = 0;
+  NetId output = NO_NET;
+};
+
+// Function of a simplified LUT whose inputs are in ascending net order
+struct LutKey {
+  uint64_t mask = 0;
+  int width = 0;
+  std::array<NetId, LutMask::MAX_WIDTH> inputs{};
+
+  bool operator==(const LutKey &) const = default;
+};
+
+struct LutKeyHash {
+  size_t operator()(const LutKey &k) const {
+    return fast_hash(k.inputs.data(), k.width * sizeof(NetId),
+                     k.mask ^ static_cast<uint64_t>(k.width));
+  }
+};
+
+class LogicOptimizer {
+public:
+  LogicOptimizer(const Netlist &in, const OptimizerOptions &options,
+                 OptimizerStats &stats)
+      : in(in), options(options), stats(stats),
+        lut_of_cell(in.num_cells(), -1), alias(in.num_nets()),
+        alive(in.num_cells(), 1) {
+    for (NetId n = 0; n < static_cast<NetId>(alias.size()); ++n)
+      alias[n] = n;
+  }
+
+  Netlist run() {
+    decode();
+    std::unordered_map<LutKey, NetId, LutKeyHash> functions;
+    for (int32_t i : topological_order())
+      simplify(luts[i], functions);
+    sweep();
+    return rebuild();
+  }
+
+private:
+  const Netlist &in;
+  const OptimizerOptions &options;
+  OptimizerStats &stats;
+
+  std::vector<Lut> luts;
+  std::vector<int32_t> lut_of_cell; // Index into 'luts', -1 if opaque
+  std::vector<NetId> alias;         // Net -> net or constant replacing it
+  std::vector<char> alive;          // Per cell
+
+  NetId resolve(NetId net) const {
+    while (is_wire(net) && alias[net] != net)
+      net = alias[net];
+    return net;
+  }
+
+  int bit_of(NetId net) const {
+    if (net == CONST0_NET)
+      return 0;
+    if (net == CONST1_NET)
+      return 1;
+    return is_wire(net) ? in.net_bit(net) : -1;
+  }
+
+  // LUTs with exactly pins A and Y, a single driver on Y and a mask of at
+  // most MAX_WIDTH inputs; any other cell is left as it is
+  void decode() {
+    auto lut_type = in.find_name("$lut");
+    if (!lut_type)
+      return;
+    for (CellId c = 0; c < static_cast<CellId>(in.num_cells()); ++c) {
+      if (in.cell(c).type != *lut_type)
+        continue;
+      std::optional<PinId> a, y;
+      bool other = false;
+      for (PinId p = in.first_pin(c); p < in.end_pin(c); ++p) {
+        PortDirection dir = in.pin(p).direction;
+        if (in.pin_name(p) == "A" && dir == PortDirection::INPUT)
+          a = p;
+        else if (in.pin_name(p) == "Y" && dir == PortDirection::OUTPUT)
+          y = p;
+        else
+          other = true;
+      }
+      if (other || !y || in.nets_of(*y).size() != 1)
+        continue;
+      NetId output = in.nets_of(*y)[0];
+      if (is_wire(output) && in.drivers(output).size() != 1)
+        continue;
+
+      int width = a ? static_cast<int>(in.nets_of(*a).size()) : 0;
+      const std::string *value = in.param(c, "LUT");
+      auto mask = value ? LutMask::parse(*value, width) : std::nullopt;
+      if (!mask)
+        continue;
+
+      Lut lut{c, {}, *mask, output};
+      if (a)
+        lut.inputs.assign(in.nets_of(*a).begin(), in.nets_of(*a).end());
+      lut_of_cell[c] = static_cast<int32_t>(luts.size());
+      luts.push_back(std::move(lut));
+    }
+  }
+
+  // Kahn's algorithm over LUT -> LUT edges; LUTs on combinational loops
+  // come last, in netlist order
+  std::vector<int32_t> topological_order() const {
+    std::vector<int32_t> driver(in.num_nets(), -1);
+    for (size_t i = 0; i < luts.size(); ++i)
+      if (is_wire(luts[i].output))
+        driver[luts[i].output] = static_cast<int32_t>(i);
+
+    std::vector<uint32_t> pending(luts.size(), 0);
+    std::vector<int32_t> order;
+    order.reserve(luts.size());
+    for (size_t i = 0; i < luts.size(); ++i) {
+      for (NetId n : luts[i].inputs)
+        pending[i] += is_wire(n) && driver[n] >= 0;
+      if (pending[i] == 0)
+        order.push_back(static_cast<int32_t>(i));
+    }
+    for (size_t head = 0; head < order.size(); ++head) {
+      NetId out = luts[order[head]].output;
+      if (!is_wire(out))
+        continue;
+      for (PinId p : in.sinks(out)) {
+        int32_t j = lut_of_cell[in.pin(p).cell];
+        if (j >= 0 && --pending[j] == 0)
+          order.push_back(j);
+      }
+    }
+    for (size_t i = 0; i < luts.size(); ++i)
+      if (pending[i] > 0)
+        order.push_back(static_cast<int32_t>(i));
+    return order;
+  }
+
+  void simplify(Lut &lut,
+                std::unordered_map<LutKey, NetId, LutKeyHash> &functions) {
+    for (NetId &n : lut.inputs)
+      n = resolve(n);
+    int width = static_cast<int>(lut.inputs.size());
+    auto drop = [&](int k, uint64_t mask) {
+      lut.mask = mask;
+      lut.inputs.erase(lut.inputs.begin() + k);
+      --width;
+    };
+
+    if (options.constant_propagation) {
+      for (int k = width; k-- > 0;) {
+        NetId n = lut.inputs[k];
+        if (n == CONST0_NET || n == CONST1_NET) {
+          drop(k, LutMask::cofactor(lut.mask, width, k, n == CONST1_NET));
+          ++stats.constant_inputs;
+        }
+      }
+    }
+    if (options.prune_inputs) {
+      for (int k = width; k-- > 1;) {
+        auto begin = lut.inputs.begin();
+        auto first = std::find(begin, begin + k, lut.inputs[k]);
+        if (is_wire(lut.inputs[k]) && first != begin + k) {
+          drop(k, LutMask::merge_inputs(lut.mask, width,
+                                        static_cast<int>(first - begin), k));
+          ++stats.pruned_inputs;
+        }
+      }
+      for (int k = width; k-- > 0;) {
+        if (!LutMask::depends_on(lut.mask, width, k)) {
+          drop(k, LutMask::cofactor(lut.mask, width, k, false));
+          ++stats.pruned_inputs;
+        }
+      }
+    }
+    if (!is_wire(lut.output))
+      return; // Nothing reads it; left to the sweep
+
+    NetId replacement = lut.output;
+    if (width == 0 && options.constant_propagation) {
+      replacement = (lut.mask & 1) ? CONST1_NET : CONST0_NET;
+      ++stats.constant_luts;
+    } else if (width == 1 && lut.mask == 0b10 && options.remove_buffers &&
+               is_wire(lut.inputs[0])) {
+      replacement = lut.inputs[0];
+      if (replacement != lut.output)
+        ++stats.buffers;
+    } else if (options.structural_hashing &&
+               std::all_of(lut.inputs.begin(), lut.inputs.end(), is_wire)) {
+      // Inputs of a symmetric function may be connected in any order
+      for (int pass = 0; pass < width; ++pass) {
+        for (int k = 0; k + 1 < width - pass; ++k) {
+          if (lut.inputs[k] > lut.inputs[k + 1]) {
+            std::swap(lut.inputs[k], lut.inputs[k + 1]);
+            lut.mask = LutMask::swap_inputs(lut.mask, width, k);
+          }
+        }
+      }
+      LutKey key;
+      key.mask = lut.mask;
+      key.width = width;
+      std::copy(lut.inputs.begin(), lut.inputs.end(), key.inputs.begin());
+      auto [it, inserted] = functions.try_emplace(key, lut.output);
+      if (!inserted) {
+        replacement = it->second;
+        ++stats.merged_luts;
+      }
+    }
+    if (replacement != lut.output) {
+      alias[lut.output] = replacement;
+      alive[lut.cell] = 0;
+    }
+  }
+
+  // Mark everything the output ports depend on through live cells; cells
+  // of types the packer does not know are always live. Inout pins (cells
+  // parsed without port_directions) may drive their nets, so a cell with
+  // one on a live net is live too.
+  void sweep() {
+    if (!options.sweep)
+      return;
+    std::vector<NetId> work;
+    std::vector<char> net_seen(in.num_nets(), 0);
+    auto visit = [&](NetId n) {
+      n = resolve(n);
+      if (is_wire(n) && !net_seen[n]) {
+        net_seen[n] = 1;
+        work.push_back(n);
+      }
+    };
+
+    bool has_outputs = false;
+    for (size_t i = 0; i < in.num_ports(); ++i) {
+      if (in.port(i).direction == PortDirection::INPUT)
+        continue;
+      has_outputs = true;
+      for (NetId n : in.port_nets(i))
+        visit(n);
+    }
+    if (!has_outputs)
+      return;
+
+    std::vector<char> live(in.num_cells(), 0);
+    auto keep = [&](CellId c) {
+      if (!alive[c] || live[c])
+        return;
+      live[c] = 1;
+      if (lut_of_cell[c] >= 0) {
+        for (NetId n : luts[lut_of_cell[c]].inputs)
+          visit(n);
+        return;
+      }
+      for (PinId p = in.first_pin(c); p < in.end_pin(c); ++p)
+        if (in.pin(p).direction != PortDirection::OUTPUT)
+          for (NetId n : in.nets_of(p))
+            visit(n);
+    };
+
+    std::vector<NameId> sweepable;
+    for (const char *type : {"$lut", "DFF", "$mul", "DSP", "$mem", "BRAM"})
+      if (auto id = in.find_name(type))
+        sweepable.push_back(*id);
+    for (CellId c = 0; c < static_cast<CellId>(in.num_cells()); ++c)
+      if (std::find(sweepable.begin(), sweepable.end(), in.cell(c).type) ==
+          sweepable.end())
+        keep(c);
+
+    while (!work.empty()) {
+      NetId n = work.back();
+      work.pop_back();
+      for (PinId p : in.drivers(n))
+        keep(in.pin(p).cell);
+      for (PinId p : in.sinks(n))
+        if (in.pin(p).direction == PortDirection::INOUT)
+          keep(in.pin(p).cell);
+    }
+    for (CellId c = 0; c < static_cast<CellId>(in.num_cells()); ++c) {
+      if (alive[c] && !live[c]) {
+        alive[c] = 0;
+        ++stats.swept_cells;
+      }
+    }
+  }
+
+  Netlist rebuild() const {
+    Netlist out;
+    std::vector<int> bits;
+    auto bits_of = [&](std::span<const NetId> nets) {
+      bits.clear();
+      for (NetId n : nets)
+        bits.push_back(bit_of(resolve(n)));
+      return std::span<const int>(bits);
+    };
+
+    for (size_t i = 0; i < in.num_ports(); ++i)
+      out.add_port(in.port_name(i), in.port(i).direction,
+                   bits_of(in.port_nets(i)));
+
+    for (CellId c = 0; c < static_cast<CellId>(in.num_cells()); ++c) {
+      if (!alive[c])
+        continue;
+      CellId id = out.add_cell(in.cell_name(c), in.cell_type(c));
+      for (const auto &param : in.params(c))
+        out.add_param(id, in.name(param.key), param.value);
+
+      if (lut_of_cell[c] >= 0) {
+        const Lut &lut = luts[lut_of_cell[c]];
+        int width = static_cast<int>(lut.inputs.size());
+        out.add_param(id, "WIDTH", std::to_string(width));
+        out.add_param(id, "LUT", LutMask::format(lut.mask, width));
+        if (width > 0)
+          out.add_pin(id, "A", PortDirection::INPUT, bits_of(lut.inputs));
+        int y = bit_of(lut.output);
+        out.add_pin(id, "Y", PortDirection::OUTPUT, std::span<const int>(&y, 1));
+        continue;
+      }
+      for (PinId p = in.first_pin(c); p < in.end_pin(c); ++p)
+        out.add_pin(id, in.pin_name(p), in.pin(p).direction,
+                    bits_of(in.nets_of(p)));
+    }
+    return out;
+  }
+};
+
+} // namespace
+
+Netlist Optimizer::optimize(const Netlist &netlist,
+                            const OptimizerOptions &options,
+                            OptimizerStats *stats) {
+  OptimizerStats local;
+  OptimizerStats &s = stats ? *stats : local;
+  s = OptimizerStats{};
+  s.cells_before = netlist.num_cells();
+  Netlist out = LogicOptimizer(netlist, options, s).run();
+  s.cells_after = out.num_cells();
+  return out;
+}
+
+} // namespace vfpga
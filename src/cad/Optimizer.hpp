@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Netlist.hpp"
+#include <cstddef>
+
+namespace vfpga {
+
+struct OptimizerOptions {
+  bool constant_propagation = true; // Fold constant LUT inputs into masks
+  bool remove_buffers = true;       // Bypass identity LUTs
+  bool prune_inputs = true;         // Drop repeated and ignored LUT inputs
+  bool structural_hashing = true;   // Merge LUTs computing the same function
+  bool sweep = true;                // Remove cells no output depends on
+};
+
+struct OptimizerStats {
+  size_t cells_before = 0;
+  size_t cells_after = 0;
+  size_t constant_inputs = 0; // LUT inputs folded into masks
+  size_t constant_luts = 0;   // LUTs replaced by a constant
+  size_t buffers = 0;         // Identity LUTs bypassed
+  size_t pruned_inputs = 0;   // Repeated or ignored LUT inputs dropped
+  size_t merged_luts = 0;     // Duplicate LUTs merged
+  size_t swept_cells = 0;     // Cells no top-level output depends on
+
+  size_t cells_removed() const { return cells_before - cells_after; }
+};
+
+// Logic optimization of a parsed netlist, run before packing.
+//
+// $lut cells of up to LutMask::MAX_WIDTH inputs are simplified in
+// topological order, so constants and merged nets found upstream are seen
+// downstream in one pass. Then every cell that no top-level output or
+// inout depends on is swept (netlists without output ports are not swept).
+// Cell types the optimizer does not know are never removed, and cells are
+// kept in their original order with their original names and bit numbers.
+class Optimizer {
+public:
+  static Netlist optimize(const Netlist &netlist,
+                          const OptimizerOptions &options = {},
+                          OptimizerStats *stats = nullptr);
+};
+
+} // namespace vfpga
@@ -1,86 +1,411 @@
 #include "Packer.hpp"
+#include "LutMask.hpp"
+#include "PathEstimate.hpp"
+#include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
 namespace vfpga {
 
-std::vector<LogicBlock> Packer::pack(const Netlist &netlist) {
+namespace {
+
+// LUT<4> mask of a $lut cell over its distinct wire inputs, which are
+// appended to 'inputs' (A[0] first): constant and unconnected inputs are
+// folded into the table, repeated ones merged, and the table is repeated
+// over the unused high inputs. A LUT without a mask is a passthrough of
+// its first input (with a warning). Throws std::runtime_error if the mask
+// cannot be decoded or more than Fabric::LUT_INPUTS inputs remain.
+uint16_t decode_lut(const Netlist &netlist, CellId c,
+                    std::vector<NetId> &inputs) {
+  auto fail = [&](const std::string &why) {
+    return std::runtime_error("Packer: LUT " +
+                              std::string(netlist.cell_name(c)) + " " + why);
+  };
+
+  std::vector<NetId> nets;
+  if (auto a = netlist.find_pin(c, "A"))
+    nets.assign(netlist.nets_of(*a).begin(), netlist.nets_of(*a).end());
+  int width = static_cast<int>(nets.size());
+  const std::string *declared = netlist.param(c, "WIDTH");
+  if (declared && *declared != std::to_string(width))
+    throw fail("has WIDTH " + *declared + " but " + std::to_string(width) +
+               " input bits");
+  const std::string *value = netlist.param(c, "LUT");
+  if (!value) {
+    std::cerr << "Packer: LUT " << netlist.cell_name(c)
+              << " has no LUT parameter (packed as a passthrough)"
+              << std::endl;
+    for (NetId net : nets)
+      if (is_wire(net))
+        inputs.push_back(net);
+    return Fabric::LUT_PASSTHROUGH;
+  }
+  auto mask = LutMask::parse(*value, width);
+  if (!mask)
+    throw fail("has no decodable LUT mask for " + std::to_string(width) +
+               " inputs");
+
+  for (int k = width; k-- > 0;) {
+    auto first = std::find(nets.begin(), nets.begin() + k, nets[k]);
+    if (!is_wire(nets[k]))
+      mask = LutMask::cofactor(*mask, width, k, nets[k] == CONST1_NET);
+    else if (first != nets.begin() + k)
+      mask = LutMask::merge_inputs(*mask, width,
+                                   static_cast<int>(first - nets.begin()), k);
+    else
+      continue;
+    nets.erase(nets.begin() + k);
+    --width;
+  }
+  if (width > Fabric::LUT_INPUTS)
+    throw fail("has " + std::to_string(width) + " distinct inputs; the "
+               "fabric's LUTs have " + std::to_string(Fabric::LUT_INPUTS));
+
+  inputs.insert(inputs.end(), nets.begin(), nets.end());
+  uint16_t packed = 0;
+  uint64_t index_mask = (uint64_t{1} << width) - 1;
+  for (unsigned i = 0; i < (1u << Fabric::LUT_INPUTS); ++i)
+    if ((*mask >> (i & index_mask)) & 1)
+      packed |= static_cast<uint16_t>(1u << i);
+  return packed;
+}
+
+} // namespace
+
+std::vector<LogicBlock> Packer::pack(const Netlist &netlist,
+                                     const PackerOptions &options) {
   std::vector<LogicBlock> blocks;
+  blocks.reserve(netlist.num_cells());
   int next_id = 0;
 
-  for (const auto &[name, cell] : netlist.cells) {
-    LogicBlock block(next_id++, name);
+  // Type names are compared as interned IDs (absent types never match)
+  auto type_id = [&](std::string_view type) {
+    return netlist.find_name(type).value_or(-1);
+  };
+  const NameId lut = type_id("$lut"), dff = type_id("DFF");
+  const NameId mem = type_id("$mem"), bram = type_id("BRAM");
+  const NameId mul = type_id("$mul"), dsp = type_id("DSP");
+  std::vector<NameId> unsupported; // Types already reported
 
-    if (cell->type == "$lut") {
-      block.use_lut = true;
-      // Parse LUT mask
-      // Assuming parameter "LUT" is an integer or string bitmask
-      // For simplicity, default to 0
-      // Real implementation needs to decode the parameter
-
-      // Connect inputs
-      // Assuming ports A, B, C, D... or A[0], A[1]
-      // We iterate cell ports and map to block inputs
-      for (const auto &[port_name, port] : cell->ports) {
-        if (port.direction == PortDirection::INPUT) {
-          if (port.connected_net) {
-            block.input_nets.push_back(port.connected_net->name);
-          } else {
-            block.input_nets.push_back(""); // Unconnected
-          }
-        } else if (port.direction == PortDirection::OUTPUT) {
-          if (port.connected_net) {
-            block.output_net = port.connected_net->name;
-          }
-        }
+  // Single-bit view of a port's connection
+  auto port_net = [&](CellId c, std::string_view port) {
+    auto pin = netlist.find_pin(c, port);
+    return pin ? netlist.net_of(*pin) : NO_NET;
+  };
+
+  // LUT -> DFF pairs sharing one block: the DFF packed with each LUT, and
+  // whether a DFF is already packed with its LUT
+  std::vector<CellId> fused_dff;
+  std::vector<char> absorbed;
+  if (options.fuse_lut_dff && lut >= 0 && dff >= 0) {
+    fused_dff.assign(netlist.num_cells(), -1);
+    absorbed.assign(netlist.num_cells(), 0);
+    std::vector<char> on_port(netlist.num_nets(), 0);
+    for (size_t i = 0; i < netlist.num_ports(); ++i)
+      for (NetId net : netlist.port_nets(i))
+        if (is_wire(net))
+          on_port[net] = 1;
+
+    for (CellId c = 0; c < static_cast<CellId>(netlist.num_cells()); ++c) {
+      if (netlist.cell(c).type != dff)
+        continue;
+      NetId d = port_net(c, "D");
+      if (!is_wire(d) || on_port[d] || netlist.fanout(d) != 1 ||
+          netlist.drivers(d).size() != 1)
+        continue;
+      CellId driver = netlist.pin(netlist.driver(d)).cell;
+      if (netlist.cell(driver).type == lut && fused_dff[driver] < 0 &&
+          port_net(driver, "Y") == d) {
+        fused_dff[driver] = c;
+        absorbed[c] = 1;
       }
+    }
+  }
 
-    } else if (cell->type == "DFF") {
+  for (CellId c = 0; c < static_cast<CellId>(netlist.num_cells()); ++c) {
+    if (!absorbed.empty() && absorbed[c])
+      continue; // Packed with the LUT driving it
+    LogicBlock block(next_id++, std::string(netlist.cell_name(c)));
+    NameId type = netlist.cell(c).type;
+
+    if (type == lut) {
+      block.use_lut = true;
+      block.lut_mask = decode_lut(netlist, c, block.input_nets);
+      block.output_net = port_net(c, "Y");
+
+      if (!fused_dff.empty() && fused_dff[c] >= 0) {
+        // The LUT output stays inside the LE
+        CellId reg = fused_dff[c];
+        block.name = netlist.cell_name(reg);
+        block.use_dff = true;
+        block.output_net = port_net(reg, "Q");
+        block.clock_net = port_net(reg, "C");
+      }
+    } else if (type == dff) {
       block.use_dff = true;
       // D -> Input
       // Q -> Output
       // C -> Clock
       // Very simple mapping for now
-      if (cell->ports.count("D") && cell->ports.at("D").connected_net) {
-        block.input_nets.push_back(cell->ports.at("D").connected_net->name);
-      }
-      if (cell->ports.count("Q") && cell->ports.at("Q").connected_net) {
-        block.output_net = cell->ports.at("Q").connected_net->name;
+      NetId d = port_net(c, "D");
+      auto d_pin = netlist.find_pin(c, "D");
+      if (d != NO_NET) {
+        block.input_nets.push_back(d);
+      } else if (d_pin && !netlist.nets_of(*d_pin).empty()) {
+        // D tied to a constant: the LE's LUT drives it with no inputs
+        block.use_lut = true;
+        block.lut_mask = netlist.nets_of(*d_pin).back() == CONST1_NET
+                             ? uint16_t{0xFFFF}
+                             : uint16_t{0x0000};
       }
-      if (cell->ports.count("C") && cell->ports.at("C").connected_net) {
-        block.clock_net = cell->ports.at("C").connected_net->name;
+      block.output_net = port_net(c, "Q");
+      block.clock_net = port_net(c, "C");
+    } else if (type == mem || type == bram || type == mul || type == dsp) {
+      block.type = (type == mem || type == bram) ? TileType::BRAM : TileType::DSP;
+      // Every input bit (ADDR, DATA, ...) in pin order; a block has one
+      // output net, the highest connected bit of its output pins
+      for (PinId p = netlist.first_pin(c); p < netlist.end_pin(c); ++p) {
+        if (netlist.pin(p).direction == PortDirection::INPUT) {
+          for (NetId net : netlist.nets_of(p))
+            if (is_wire(net))
+              block.input_nets.push_back(net);
+        } else if (netlist.pin(p).direction == PortDirection::OUTPUT &&
+                   netlist.net_of(p) != NO_NET) {
+          block.output_net = netlist.net_of(p);
+        }
       }
-    } else if (cell->type == "$mem" || cell->type == "BRAM") {
-      block.type = TileType::BRAM;
-      // Simplistic mapping:
-      // ADDR -> Input[0..N]
-      // DATA -> Input[N+1..M]
-      // OUT -> Output
-      for (const auto &[port_name, port] : cell->ports) {
-        if (port.direction == PortDirection::INPUT) {
-          if (port.connected_net)
-            block.input_nets.push_back(port.connected_net->name);
-        } else if (port.direction == PortDirection::OUTPUT) {
-          if (port.connected_net)
-            block.output_net = port.connected_net->name;
+    } else if (std::find(unsupported.begin(), unsupported.end(), type) ==
+               unsupported.end()) {
+      // Gates should have been mapped to LUTs (TechMapper) first
+      unsupported.push_back(type);
+      std::cerr << "Packer: unsupported cell type " << netlist.cell_type(c)
+                << " (packed as an empty block)" << std::endl;
+    }
+
+    blocks.push_back(std::move(block));
+  }
+
+  return blocks;
+}
+
+namespace {
+
+// Routing distances the estimate charges: a connection inside a cluster
+// stays on its site's local interconnect, any other leaves the site
+constexpr int LOCAL_HOPS = 1;
+constexpr int GLOBAL_HOPS = Fabric::CLB_LES;
+
+} // namespace
+
+std::vector<double>
+Packer::net_criticality(const std::vector<LogicBlock> &blocks) {
+  PathEstimate estimate(blocks);
+  double path = estimate.analyze([](int, int) { return GLOBAL_HOPS; });
+  return estimate.criticality(path);
+}
+
+std::vector<Cluster> Packer::cluster(const std::vector<LogicBlock> &blocks,
+                                     const PackerOptions &options,
+                                     ClusterStats *stats,
+                                     const std::vector<double> *criticality) {
+  const size_t max_les = static_cast<size_t>(std::max(options.cluster_les, 1));
+  const size_t max_inputs =
+      static_cast<size_t>(std::max(options.cluster_inputs, 0));
+  const size_t n = blocks.size();
+
+  // Distinct nets of each block (CSR), with its input nets first
+  std::vector<uint32_t> net_start(n + 1, 0), input_end(n, 0);
+  std::vector<NetId> block_nets;
+  NetId max_net = NO_NET;
+  for (size_t b = 0; b < n; ++b) {
+    net_start[b] = static_cast<uint32_t>(block_nets.size());
+    for (NetId net : blocks[b].input_nets)
+      if (is_wire(net) && std::find(block_nets.begin() + net_start[b],
+                                    block_nets.end(), net) == block_nets.end())
+        block_nets.push_back(net);
+    input_end[b] = static_cast<uint32_t>(block_nets.size());
+    NetId out = blocks[b].output_net;
+    if (is_wire(out) && std::find(block_nets.begin() + net_start[b],
+                                  block_nets.end(), out) == block_nets.end())
+      block_nets.push_back(out);
+    for (uint32_t i = net_start[b]; i < block_nets.size(); ++i)
+      max_net = std::max(max_net, block_nets[i]);
+  }
+  net_start[n] = static_cast<uint32_t>(block_nets.size());
+
+  // CLB blocks on each net (CSR)
+  std::vector<uint32_t> net_first(static_cast<size_t>(max_net) + 2, 0);
+  for (size_t b = 0; b < n; ++b)
+    if (blocks[b].type == TileType::CLB)
+      for (uint32_t i = net_start[b]; i < net_start[b + 1]; ++i)
+        ++net_first[block_nets[i] + 1];
+  std::partial_sum(net_first.begin(), net_first.end(), net_first.begin());
+  std::vector<int> net_blocks(net_first.back());
+  {
+    std::vector<uint32_t> fill(net_first.begin(), net_first.end() - 1);
+    for (size_t b = 0; b < n; ++b)
+      if (blocks[b].type == TileType::CLB)
+        for (uint32_t i = net_start[b]; i < net_start[b + 1]; ++i)
+          net_blocks[fill[block_nets[i]]++] = static_cast<int>(b);
+  }
+
+  // Net criticality, estimated unless given
+  const double alpha = std::clamp(options.timing_tradeoff, 0.0, 1.0);
+  std::optional<PathEstimate> estimate;
+  if (stats || (!criticality && alpha > 0))
+    estimate.emplace(blocks);
+  std::vector<double> estimated;
+  if (!criticality && estimate) {
+    double path = estimate->analyze([](int, int) { return GLOBAL_HOPS; });
+    estimated = estimate->criticality(path);
+    criticality = &estimated;
+  }
+  auto crit = [&](NetId net) {
+    return criticality && static_cast<size_t>(net) < criticality->size()
+               ? (*criticality)[net]
+               : 0.0;
+  };
+  std::vector<double> block_crit(n, 0.0);
+  for (size_t b = 0; b < n && alpha > 0; ++b)
+    for (uint32_t i = net_start[b]; i < net_start[b + 1]; ++i)
+      block_crit[b] = std::max(block_crit[b], crit(block_nets[i]));
+
+  // Seeds: most critical first, then most input nets (VPR's "max inputs"
+  // seed), netlist order among equals
+  std::vector<int> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    if (block_crit[a] != block_crit[b])
+      return block_crit[a] > block_crit[b];
+    return input_end[a] - net_start[a] > input_end[b] - net_start[b];
+  });
+
+  std::vector<Cluster> clusters;
+  std::vector<char> clustered(n, 0), candidate(n, 0);
+  std::vector<double> gain(n, 0.0); // Attraction to the cluster being grown
+  std::vector<int> candidates;
+  std::vector<NetId> outputs, inputs;
+
+  // Number of, and list of, external inputs of the cluster with 'b' added
+  auto count_inputs_with = [&](int b) {
+    NetId out = blocks[b].output_net;
+    auto has = [](const std::vector<NetId> &v, NetId net) {
+      return std::find(v.begin(), v.end(), net) != v.end();
+    };
+    size_t count = inputs.size() - has(inputs, out);
+    for (uint32_t i = net_start[b]; i < input_end[b]; ++i) {
+      NetId net = block_nets[i];
+      count += net != out && !has(outputs, net) && !has(inputs, net);
+    }
+    return count;
+  };
+  auto inputs_with = [&](int b) {
+    std::vector<NetId> result;
+    NetId out = blocks[b].output_net;
+    for (NetId net : inputs)
+      if (net != out)
+        result.push_back(net);
+    for (uint32_t i = net_start[b]; i < input_end[b]; ++i) {
+      NetId net = block_nets[i];
+      if (net != out &&
+          std::find(outputs.begin(), outputs.end(), net) == outputs.end() &&
+          std::find(result.begin(), result.end(), net) == result.end())
+        result.push_back(net);
+    }
+    return result;
+  };
+
+  for (int seed : order) {
+    if (clustered[seed])
+      continue;
+    Cluster cluster;
+    outputs.clear();
+    inputs.clear();
+
+    auto add = [&](int b, std::vector<NetId> new_inputs) {
+      clustered[b] = 1;
+      cluster.blocks.push_back(b);
+      inputs = std::move(new_inputs);
+      if (is_wire(blocks[b].output_net))
+        outputs.push_back(blocks[b].output_net);
+      for (uint32_t i = net_start[b]; i < net_start[b + 1]; ++i) {
+        NetId net = block_nets[i];
+        uint32_t first = net_first[net], last = net_first[net + 1];
+        if (last - first > static_cast<uint32_t>(options.attraction_fanout))
+          continue;
+        double weight = (1.0 - alpha) + alpha * crit(net);
+        for (uint32_t k = first; k < last; ++k) {
+          int other = net_blocks[k];
+          if (clustered[other])
+            continue;
+          gain[other] += weight;
+          if (!candidate[other]) {
+            candidate[other] = 1;
+            candidates.push_back(other);
+          }
         }
       }
-    } else if (cell->type == "$mul" || cell->type == "DSP") {
-      block.type = TileType::DSP;
-      for (const auto &[port_name, port] : cell->ports) {
-        if (port.direction == PortDirection::INPUT) {
-          if (port.connected_net)
-            block.input_nets.push_back(port.connected_net->name);
-        } else if (port.direction == PortDirection::OUTPUT) {
-          if (port.connected_net)
-            block.output_net = port.connected_net->name;
+    };
+
+    add(seed, inputs_with(seed));
+    if (blocks[seed].type == TileType::CLB) {
+      while (cluster.blocks.size() < max_les) {
+        int best = -1;
+        size_t best_inputs = 0;
+        for (int b : candidates) {
+          if (clustered[b] || (best >= 0 && gain[b] < gain[best]))
+            continue;
+          size_t with = count_inputs_with(b);
+          if (with > max_inputs)
+            continue;
+          if (best < 0 || gain[b] > gain[best] || with < best_inputs ||
+              (with == best_inputs && b < best)) {
+            best = b;
+            best_inputs = with;
+          }
         }
+        if (best < 0)
+          break;
+        add(best, inputs_with(best));
       }
     }
+    for (int b : candidates) {
+      gain[b] = 0;
+      candidate[b] = 0;
+    }
+    candidates.clear();
 
-    blocks.push_back(block);
+    cluster.inputs = inputs;
+    clusters.push_back(std::move(cluster));
   }
 
-  return blocks;
+  if (stats) {
+    *stats = ClusterStats{};
+    stats->clusters = clusters.size();
+    std::vector<int> cluster_of(n, -1);
+    for (size_t c = 0; c < clusters.size(); ++c)
+      for (int b : clusters[c].blocks)
+        cluster_of[b] = static_cast<int>(c);
+    auto local = [&](int d, int b) { return cluster_of[d] == cluster_of[b]; };
+
+    for (size_t b = 0; b < n; ++b) {
+      for (NetId net : blocks[b].input_nets) {
+        int d = estimate->driver_of(net);
+        if (d >= 0 && local(d, static_cast<int>(b))) {
+          ++stats->absorbed;
+          stats->critical_absorbed += crit(net) >= 0.9;
+        }
+      }
+    }
+    stats->path_ps = estimate->analyze([](int, int) { return GLOBAL_HOPS; });
+    stats->clustered_path_ps = estimate->analyze([&](int d, int b) {
+      return local(d, b) ? LOCAL_HOPS : GLOBAL_HOPS;
+    });
+  }
+  return clusters;
 }
 
 } // namespace vfpga
@@ -1,19 +1,72 @@
 #pragma once
 
+#include "../fabric/Fabric.hpp"
 #include "LogicBlock.hpp"
 #include "Netlist.hpp"
 #include <vector>
 
 namespace vfpga {
 
+struct PackerOptions {
+  bool fuse_lut_dff = true;                // One LE for a LUT and its DFF
+  int cluster_les = Fabric::CLB_LES;       // Blocks per cluster
+  int cluster_inputs = Fabric::CLB_INPUTS; // Distinct external input nets
+  int attraction_fanout = 64; // Wider nets (resets, enables) do not attract
+  // Weight of net criticality against net sharing in the attraction of a
+  // block to a cluster (VPR's alpha); 0 packs for area only
+  double timing_tradeoff = 0.75;
+};
+
+struct ClusterStats {
+  size_t clusters = 0;
+  size_t absorbed = 0;          // Block-to-block connections inside clusters
+  size_t critical_absorbed = 0; // Those of criticality >= 0.9
+  // Estimated critical path with every connection on global routing, and
+  // with the connections inside a cluster on its local interconnect
+  double path_ps = 0.0;
+  double clustered_path_ps = 0.0;
+
+  double path_gain() const {
+    return path_ps > 0 ? 1.0 - clustered_path_ps / path_ps : 0.0;
+  }
+};
+
 class Packer {
 public:
-  // Convert Netlist to a list of LogicBlocks
-  // For now, simple 1-to-1 mapping:
-  // - Each LUT becomes a LogicBlock (use_lut=true)
+  // Convert Netlist to a list of LogicBlocks, one per cell:
+  // - Each LUT becomes a LogicBlock (use_lut=true) reading one net per
+  //   distinct input bit, its LUT/WIDTH parameters decoded into lut_mask
+  //   (constant inputs folded in); throws std::runtime_error for masks
+  //   that do not decode or need more than Fabric::LUT_INPUTS inputs
   // - Each DFF becomes a LogicBlock (use_dff=true)
-  // - Future optimization: Pack LUT+DFF into single Block if connected directly
-  static std::vector<LogicBlock> pack(const Netlist &netlist);
+  // - A LUT whose output is read only by a DFF's D input (and is not a
+  //   top-level port) shares the DFF's block, as the LE's LUT feeding its
+  //   register; the block is named after the DFF
+  static std::vector<LogicBlock> pack(const Netlist &netlist,
+                                      const PackerOptions &options = {});
+
+  // Group CLB blocks into clusters of at most 'cluster_les' blocks reading
+  // at most 'cluster_inputs' nets driven outside the cluster (clock nets
+  // are global and not counted), T-VPack style: a cluster is seeded with
+  // the most critical unclustered block (then the one using the most input
+  // nets) and grown with the block that still fits and is most attracted
+  // to it. Each net shared with the cluster attracts a block by
+  // (1 - timing_tradeoff) + timing_tradeoff * criticality. Every block is
+  // in exactly one cluster.
+  //
+  // 'criticality' is indexed by NetId, in [0, 1], from any timing source;
+  // without it, it is estimated by net_criticality().
+  static std::vector<Cluster>
+  cluster(const std::vector<LogicBlock> &blocks,
+          const PackerOptions &options = {}, ClusterStats *stats = nullptr,
+          const std::vector<double> *criticality = nullptr);
+
+  // Pre-placement timing estimate with the delays TimingAnalyzer charges
+  // and every connection routed Fabric::CLB_LES hops: 1 - slack / critical
+  // path delay of each net (0 for nets no block drives), indexed by NetId.
+  // Blocks with a DFF, BRAMs and DSPs start and end paths.
+  static std::vector<double>
+  net_criticality(const std::vector<LogicBlock> &blocks);
 };
 
 } // namespace vfpga
@@ -1,130 +1,501 @@
 #include "Parser.hpp"
+#include "Hierarchy.hpp"
+#include "../utils/MappedFile.hpp"
 #include "../utils/json.hpp"
-#include <fstream>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 using json = nlohmann::json;
 
 namespace vfpga {
 
-std::optional<Netlist> Parser::from_json(const std::string &filename) {
-  std::ifstream file(filename);
-  if (!file.is_open()) {
-    std::cerr << "Error: Could not open file " << filename << std::endl;
-    return std::nullopt;
+namespace {
+
+// Yosys writes the constants as the strings "0" and "1" and undefined
+// bits as "x" or "z"
+int string_bit(const std::string &s) {
+  return s == "0" ? 0 : s == "1" ? 1 : UNDEFINED_BIT;
+}
+
+// --- Locating modules ---
+
+// Byte range of one module's JSON object inside the file
+struct ModuleSpan {
+  std::string name;
+  size_t begin = 0, end = 0;
+};
+
+// Structural scan of the top level of a Yosys JSON document: finds the
+// members of "modules" without tokenizing their contents, so each module
+// can then be parsed independently. Checks only what it skips over
+// (bracket nesting and strings); module bodies are validated by their own
+// parse.
+class ModuleScanner {
+public:
+  explicit ModuleScanner(std::string_view text) : text(text) {}
+
+  bool have_modules = false;
+  std::vector<ModuleSpan> modules;
+
+  bool scan() {
+    if (!expect('{'))
+      return false;
+    if (expect('}'))
+      return at_end();
+    while (true) {
+      std::string key;
+      if (!read_string(key) || !expect(':'))
+        return false;
+      if (key == "modules" && peek('{')) {
+        have_modules = true;
+        if (!scan_modules())
+          return false;
+      } else if (!skip_value()) {
+        return false;
+      }
+      if (!expect(','))
+        return expect('}') && at_end();
+    }
   }
 
-  try {
-    json j;
-    file >> j;
+private:
+  std::string_view text;
+  size_t pos = 0;
 
-    Netlist netlist;
+  void skip_ws() {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' ||
+                                 text[pos] == '\r' || text[pos] == '\t'))
+      ++pos;
+  }
+  bool peek(char c) {
+    skip_ws();
+    return pos < text.size() && text[pos] == c;
+  }
+  bool expect(char c) {
+    if (!peek(c))
+      return false;
+    ++pos;
+    return true;
+  }
+  // Only whitespace may follow the root object
+  bool at_end() {
+    skip_ws();
+    return pos == text.size();
+  }
 
-    // Yosys JSONs usually have a "modules" object at the top level
-    if (!j.contains("modules")) {
-      std::cerr << "Error: Invalid JSON netlist (missing 'modules')"
-                << std::endl;
-      return std::nullopt;
+  bool skip_string() {
+    if (!expect('"'))
+      return false;
+    while (pos < text.size()) {
+      char c = text[pos++];
+      if (c == '\\')
+        ++pos;
+      else if (c == '"')
+        return pos <= text.size();
     }
+    return false;
+  }
 
-    // We assume a single top-level module for now, or take the first one
-    // Typically the top module name is the key.
-    auto modules = j["modules"];
-    if (modules.empty()) {
-      std::cerr << "Error: No modules found in netlist" << std::endl;
-      return std::nullopt;
+  bool read_string(std::string &out) {
+    skip_ws();
+    size_t start = pos;
+    if (!skip_string())
+      return false;
+    std::string_view raw = text.substr(start + 1, pos - start - 2);
+    if (raw.find('\\') == std::string_view::npos) {
+      out.assign(raw);
+      return true;
     }
+    std::string_view quoted = text.substr(start, pos - start);
+    auto decoded = json::parse(quoted.begin(), quoted.end(), nullptr, false);
+    if (!decoded.is_string())
+      return false;
+    out = decoded.get<std::string>();
+    return true;
+  }
 
-    // Just take the first module found
-    auto module_it = modules.begin();
-    std::string module_name = module_it.key();
-    auto module_data = module_it.value();
-
-    // 1. Parse Ports (Top-level inputs/outputs)
-    if (module_data.contains("ports")) {
-      for (auto &[port_name, port_data] : module_data["ports"].items()) {
-        std::string direction = port_data["direction"];
-        if (direction == "input") {
-          netlist.inputs.push_back(port_name);
-          // Create a net for this input so cells can connect to it
-          // The bits of the port are often listed in "bits".
-          // For simplicity, handle single-bit ports or name them by index.
-        } else if (direction == "output") {
-          netlist.outputs.push_back(port_name);
-        }
-
-        // netlist.add_net(port_name); // Create net for valid top-level IO
-      }
+  bool skip_value() {
+    skip_ws();
+    if (pos >= text.size())
+      return false;
+    char c = text[pos];
+    if (c == '"')
+      return skip_string();
+    if (c != '{' && c != '[') {
+      // Scalar: up to the next delimiter
+      size_t start = pos;
+      while (pos < text.size() && !std::strchr(",}] \n\r\t", text[pos]))
+        ++pos;
+      return pos > start;
     }
 
-    // 2. Parse Cells
-    if (module_data.contains("cells")) {
-      for (auto &[cell_name, cell_data] : module_data["cells"].items()) {
-        std::string cell_type = cell_data["type"];
-        auto cell = netlist.add_cell(cell_name, cell_type);
-
-        // Parameters (e.g. LUT mask)
-        if (cell_data.contains("parameters")) {
-          for (auto &[param_name, param_val] :
-               cell_data["parameters"].items()) {
-            if (param_val.is_string()) {
-              cell->parameters[param_name] = param_val;
-            } else {
-              cell->parameters[param_name] = param_val.dump();
-            }
-          }
-        }
-
-        // Port Directions (Optional but important for Packer)
-        std::map<std::string, PortDirection> known_dirs;
-        if (cell_data.contains("port_directions")) {
-          for (auto &[pname, pdir_str] : cell_data["port_directions"].items()) {
-            if (pdir_str == "input")
-              known_dirs[pname] = PortDirection::INPUT;
-            else if (pdir_str == "output")
-              known_dirs[pname] = PortDirection::OUTPUT;
-            else
-              known_dirs[pname] = PortDirection::INOUT;
-          }
-        }
-
-        // Port Connections
-        if (cell_data.contains("connections")) {
-          for (auto &[port_name, conn_bits] :
-               cell_data["connections"].items()) {
-
-            // Determine direction
-            PortDirection dir = PortDirection::INOUT; // Default
-            if (known_dirs.count(port_name)) {
-              dir = known_dirs[port_name];
-            }
-
-            cell->add_port(port_name, dir);
-
-            // conn_bits is usually an array of integers (net IDs).
-            for (auto &bit : conn_bits) {
-              if (bit.is_number_integer()) {
-                std::string net_name = "net_" + std::to_string((int)bit);
-                netlist.connect(cell_name, port_name, net_name);
-              }
-            }
-          }
-        }
+    std::vector<char> closers;
+    while (pos < text.size()) {
+      c = text[pos];
+      if (c == '"') {
+        if (!skip_string())
+          return false;
+        continue;
+      }
+      ++pos;
+      if (c == '{' || c == '[') {
+        closers.push_back(c == '{' ? '}' : ']');
+      } else if (c == '}' || c == ']') {
+        if (closers.empty() || closers.back() != c)
+          return false;
+        closers.pop_back();
+        if (closers.empty())
+          return true;
       }
     }
+    return false;
+  }
+
+  bool scan_modules() {
+    expect('{');
+    if (expect('}'))
+      return true;
+    while (true) {
+      ModuleSpan span;
+      if (!read_string(span.name) || !expect(':') || !peek('{'))
+        return false;
+      span.begin = pos;
+      if (!skip_value())
+        return false;
+      span.end = pos;
+      modules.push_back(std::move(span));
+      if (!expect(','))
+        return expect('}');
+    }
+  }
+};
+
+// Validating SAX consumer that only keeps the first error message, used to
+// explain documents the scanner rejected
+struct ErrorReporter : nlohmann::json_sax<json> {
+  std::string message = "JSON Parse Error";
+
+  bool null() override { return true; }
+  bool boolean(bool) override { return true; }
+  bool number_integer(number_integer_t) override { return true; }
+  bool number_unsigned(number_unsigned_t) override { return true; }
+  bool number_float(number_float_t, const string_t &) override { return true; }
+  bool string(string_t &) override { return true; }
+  bool binary(binary_t &) override { return true; }
+  bool start_object(std::size_t) override { return true; }
+  bool key(string_t &) override { return true; }
+  bool end_object() override { return true; }
+  bool start_array(std::size_t) override { return true; }
+  bool end_array() override { return true; }
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &ex) override {
+    message = std::string("JSON Parse Error: ") + ex.what();
+    return false;
+  }
+};
+
+// --- Parsing one module ---
+
+// SAX handler that builds a module's Netlist while its JSON is being
+// tokenized. Only one port or cell is buffered at a time (Yosys does not
+// fix the order of "type", "port_directions" and "connections" inside a
+// cell), so memory is bounded by the Netlist itself plus the largest
+// single cell.
+class ModuleSaxHandler {
+public:
+  explicit ModuleSaxHandler(ModuleTemplate &module)
+      : module(module), netlist(module.body) {}
+
+  std::string error; // Set when a callback aborts the parse
+
+  bool null() { return scalar("null"); }
+  bool boolean(bool val) { return scalar(val ? "true" : "false"); }
+  bool number_integer(json::number_integer_t val) {
+    if (top() == Context::BITS) {
+      int bit = static_cast<int>(val);
+      bits->push_back(bit);
+      module.max_bit = std::max(module.max_bit, bit);
+      return true;
+    }
+    return scalar(std::to_string(val));
+  }
+  bool number_unsigned(json::number_unsigned_t val) {
+    return number_integer(static_cast<json::number_integer_t>(val));
+  }
+  bool number_float(json::number_float_t, const json::string_t &raw) {
+    return scalar(raw);
+  }
+  bool string(json::string_t &val) {
+    switch (top()) {
+    case Context::ATTRIBUTES:
+      // Newer Yosys versions write attribute values as binary strings
+      if (current_key == "top")
+        module.top = val.find('1') != std::string::npos;
+      return true;
+    case Context::PORT:
+      if (current_key == "direction")
+        port_direction = std::move(val);
+      return true;
+    case Context::BITS:
+      bits->push_back(string_bit(val));
+      return true;
+    case Context::CELL:
+      if (current_key == "type")
+        cell.type = std::move(val);
+      return true;
+    case Context::PARAMETERS:
+      cell.parameters.emplace_back(current_key, std::move(val));
+      return true;
+    case Context::PORT_DIRECTIONS:
+      cell.directions.emplace_back(current_key,
+                                   val == "input"    ? PortDirection::INPUT
+                                   : val == "output" ? PortDirection::OUTPUT
+                                                     : PortDirection::INOUT);
+      return true;
+    default:
+      return true;
+    }
+  }
+  bool binary(json::binary_t &) { return true; }
+
+  bool start_object(std::size_t) {
+    Context next = Context::SKIP;
+    switch (top()) {
+    case Context::NONE:
+      next = Context::MODULE;
+      break;
+    case Context::MODULE:
+      if (current_key == "attributes")
+        next = Context::ATTRIBUTES;
+      else if (current_key == "ports")
+        next = Context::PORTS;
+      else if (current_key == "cells")
+        next = Context::CELLS;
+      break;
+    case Context::PORTS:
+      next = Context::PORT;
+      port = {};
+      port.name = current_key;
+      port_direction.clear();
+      break;
+    case Context::CELLS:
+      next = Context::CELL;
+      cell.clear();
+      cell.name = current_key;
+      break;
+    case Context::CELL:
+      if (current_key == "parameters")
+        next = Context::PARAMETERS;
+      else if (current_key == "port_directions")
+        next = Context::PORT_DIRECTIONS;
+      else if (current_key == "connections")
+        next = Context::CONNECTIONS;
+      break;
+    default:
+      break;
+    }
+    stack.push_back(next);
+    return true;
+  }
+
+  bool key(json::string_t &val) {
+    current_key.swap(val);
+    return true;
+  }
+
+  bool end_object() {
+    Context done = top();
+    stack.pop_back();
+    if (done == Context::PORT)
+      finish_port();
+    else if (done == Context::CELL)
+      return finish_cell();
+    return true;
+  }
+
+  bool start_array(std::size_t) {
+    if (top() == Context::CONNECTIONS) {
+      cell.connections.emplace_back(current_key, std::vector<int>{});
+      bits = &cell.connections.back().second;
+      stack.push_back(Context::BITS);
+    } else if (top() == Context::PORT && current_key == "bits") {
+      bits = &port.bits;
+      stack.push_back(Context::BITS);
+    } else {
+      stack.push_back(Context::SKIP);
+    }
+    return true;
+  }
+
+  bool end_array() {
+    stack.pop_back();
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &ex) {
+    error = std::string("JSON Parse Error: ") + ex.what();
+    return false;
+  }
+
+private:
+  enum class Context {
+    NONE,
+    MODULE,
+    ATTRIBUTES,
+    PORTS,
+    PORT,
+    CELLS,
+    CELL,
+    PARAMETERS,
+    PORT_DIRECTIONS,
+    CONNECTIONS,
+    BITS, // Bit array of a port or of a cell connection
+    SKIP, // Any value (and everything nested in it) we don't use
+  };
+
+  struct PendingCell {
+    std::string name;
+    std::string type;
+    std::vector<std::pair<std::string, std::string>> parameters;
+    std::vector<std::pair<std::string, PortDirection>> directions;
+    std::vector<std::pair<std::string, std::vector<int>>> connections;
+
+    void clear() {
+      name.clear();
+      type.clear();
+      parameters.clear();
+      directions.clear();
+      connections.clear();
+    }
+  };
 
-    // 3. Parse Netnames (Optional, mapped net names to bit indices)
-    // If we want human-readable net names instead of "net_123"
-    if (module_data.contains("netnames")) {
-      // TODO: Mapping logic
+  ModuleTemplate &module;
+  Netlist &netlist;
+  std::vector<Context> stack;
+  std::string current_key;
+  ModuleTemplate::Port port;
+  std::string port_direction;
+  PendingCell cell;
+  std::vector<int> *bits = nullptr; // Target of the open BITS array
+
+  Context top() const { return stack.empty() ? Context::NONE : stack.back(); }
+
+  // Non-string scalars only matter as parameter values, where they are kept
+  // as their JSON text
+  bool scalar(std::string text) {
+    if (top() == Context::PARAMETERS)
+      cell.parameters.emplace_back(current_key, std::move(text));
+    else if (top() == Context::ATTRIBUTES && current_key == "top")
+      module.top = text != "0" && text != "false" && text != "null";
+    else if (top() == Context::CONNECTIONS) // Malformed: not a bit array
+      cell.connections.emplace_back(current_key, std::vector<int>{});
+    return true;
+  }
+
+  void finish_port() {
+    if (port_direction == "input")
+      port.direction = PortDirection::INPUT;
+    else if (port_direction == "output")
+      port.direction = PortDirection::OUTPUT;
+    netlist.add_port(port.name, port.direction, port.bits);
+    module.ports.push_back(std::move(port));
+  }
+
+  bool finish_cell() {
+    if (cell.type.empty()) {
+      error = "Error: Cell " + cell.name + " has no type";
+      return false;
     }
+    CellId c = netlist.add_cell(cell.name, cell.type);
+    for (auto &[key, value] : cell.parameters)
+      netlist.add_param(c, key, std::move(value));
 
-    return netlist;
+    for (const auto &[port_name, port_bits] : cell.connections) {
+      PortDirection dir = PortDirection::INOUT; // Default
+      for (const auto &[name, d] : cell.directions)
+        if (name == port_name)
+          dir = d;
+      netlist.add_pin(c, port_name, dir, port_bits);
+    }
+    return true;
+  }
+};
 
-  } catch (const json::parse_error &e) {
-    std::cerr << "JSON Parse Error: " << e.what() << std::endl;
+void parse_module(std::string_view text, const ModuleSpan &span,
+                  ModuleTemplate &module) {
+  module.name = span.name;
+  ModuleSaxHandler handler(module);
+  const char *begin = text.data() + span.begin;
+  if (!json::sax_parse(begin, text.data() + span.end, &handler))
+    module.error = handler.error.empty() ? "JSON Parse Error" : handler.error;
+}
+
+} // namespace
+
+std::optional<Netlist> Parser::from_json(const std::string &filename,
+                                         ThreadPool *pool) {
+  // The file is mapped rather than read, so even very large netlists are
+  // never held in memory twice
+  std::unique_ptr<MappedFile> file;
+  try {
+    file = std::make_unique<MappedFile>(filename);
+  } catch (const std::runtime_error &) {
+    std::cerr << "Error: Could not open file " << filename << std::endl;
     return std::nullopt;
   }
+  const char *text = reinterpret_cast<const char *>(file->data());
+  return from_json_text(std::string_view(text, file->size()), pool);
+}
+
+std::optional<Netlist> Parser::from_json_text(std::string_view text,
+                                              ThreadPool *pool) {
+  ModuleScanner scanner(text);
+  if (!scanner.scan()) {
+    ErrorReporter reporter;
+    json::sax_parse(text.begin(), text.end(), &reporter);
+    std::cerr << reporter.message << std::endl;
+    return std::nullopt;
+  }
+
+  // Yosys JSONs usually have a "modules" object at the top level
+  if (!scanner.have_modules) {
+    std::cerr << "Error: Invalid JSON netlist (missing 'modules')"
+              << std::endl;
+    return std::nullopt;
+  }
+  const auto &spans = scanner.modules;
+  if (spans.empty()) {
+    std::cerr << "Error: No modules found in netlist" << std::endl;
+    return std::nullopt;
+  }
+
+  // Every module is parsed exactly once, however often it is instantiated
+  std::vector<ModuleTemplate> modules(spans.size());
+  Hierarchy::parse_modules(spans.size(), pool, [&](size_t i) {
+    parse_module(text, spans[i], modules[i]);
+  });
+  for (const auto &m : modules) {
+    if (!m.error.empty()) {
+      std::cerr << m.error << " (module " << m.name << ")" << std::endl;
+      return std::nullopt;
+    }
+  }
+
+  // Netnames (human-readable names for bit indices) are not used yet
+  return Hierarchy::flatten(modules);
+}
+
+std::optional<Netlist> Parser::from_file(const std::string &filename,
+                                         ThreadPool *pool) {
+  if (filename.ends_with(".blif"))
+    return from_blif(filename, pool);
+  return from_json(filename, pool);
 }
 
 } // namespace vfpga
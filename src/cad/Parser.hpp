@@ -3,13 +3,46 @@
 #include "Netlist.hpp"
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace vfpga {
 
+class ThreadPool;
+
 class Parser {
 public:
-  // Parse a JSON file (Yosys compatible format) and return a Netlist
-  static std::optional<Netlist> from_json(const std::string &filename);
+  // Parse a JSON file (Yosys compatible format) and return a flat Netlist.
+  // Each module is streamed through a SAX parser that builds its Netlist
+  // directly; no JSON document is ever materialized. Modules are parsed
+  // concurrently (on 'pool', or on a temporary pool if there is more than
+  // one module) and the hierarchy below the top module (the one with the
+  // "top" attribute, else the one nobody instantiates) is flattened.
+  // Instance cells are named by their path, e.g. "cpu.alu.add0".
+  static std::optional<Netlist> from_json(const std::string &filename,
+                                          ThreadPool *pool = nullptr);
+
+  // Same, for JSON text already in memory
+  static std::optional<Netlist> from_json_text(std::string_view text,
+                                               ThreadPool *pool = nullptr);
+
+  // Parse a BLIF file (.model, .inputs, .outputs, .names, .latch, .subckt
+  // and .gate). The file is memory-mapped and tokenized in place. .names
+  // covers become $lut cells (WIDTH and LUT mask, input i is A[i]),
+  // latches become DFF cells and subcircuits become cells of the model's
+  // type, with bus pins such as "A[3]" grouped into multi-bit ports.
+  // Models defined in the file are parsed concurrently and flattened like
+  // JSON modules, with the first model as the top; .blackbox models and
+  // undefined ones stay primitive cells.
+  static std::optional<Netlist> from_blif(const std::string &filename,
+                                          ThreadPool *pool = nullptr);
+
+  // Same, for BLIF text already in memory
+  static std::optional<Netlist> from_blif_text(std::string_view text,
+                                               ThreadPool *pool = nullptr);
+
+  // from_blif() for ".blif" files, from_json() otherwise
+  static std::optional<Netlist> from_file(const std::string &filename,
+                                          ThreadPool *pool = nullptr);
 };
 
 } // namespace vfpga
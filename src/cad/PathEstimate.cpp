@@ -0,0 +1,76 @@
+#include "PathEstimate.hpp"
+#include <numeric>
+
+namespace vfpga {
+
+PathEstimate::PathEstimate(const std::vector<LogicBlock> &blocks)
+    : blocks(blocks), arrival(blocks.size()), required(blocks.size()) {
+  NetId max_net = NO_NET;
+  for (const auto &b : blocks)
+    max_net = std::max(max_net, b.output_net);
+  driver.assign(static_cast<size_t>(max_net) + 1, -1);
+  for (size_t b = 0; b < blocks.size(); ++b)
+    if (is_wire(blocks[b].output_net))
+      driver[blocks[b].output_net] = static_cast<int>(b);
+
+  // Kahn order of the combinational blocks over combinational fanout
+  // (CSR); loops come last
+  std::vector<uint32_t> pending(blocks.size(), 0);
+  std::vector<uint32_t> first(blocks.size() + 1, 0);
+  auto comb_driver = [&](NetId net) {
+    int d = driver_of(net);
+    return d >= 0 && combinational(d) ? d : -1;
+  };
+  for (size_t b = 0; b < blocks.size(); ++b)
+    if (combinational(b))
+      for (NetId net : blocks[b].input_nets)
+        if (int d = comb_driver(net); d >= 0)
+          ++first[d + 1];
+  std::partial_sum(first.begin(), first.end(), first.begin());
+  std::vector<int> readers(first.back());
+  std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    if (!combinational(b))
+      continue;
+    for (NetId net : blocks[b].input_nets) {
+      if (int d = comb_driver(net); d >= 0) {
+        ++pending[b];
+        readers[fill[d]++] = static_cast<int>(b);
+      }
+    }
+    if (pending[b] == 0)
+      order.push_back(static_cast<int>(b));
+  }
+  for (size_t head = 0; head < order.size(); ++head) {
+    int d = order[head];
+    for (uint32_t k = first[d]; k < first[d + 1]; ++k)
+      if (--pending[readers[k]] == 0)
+        order.push_back(readers[k]);
+  }
+  for (size_t b = 0; b < blocks.size(); ++b)
+    if (combinational(b) && pending[b] > 0)
+      order.push_back(static_cast<int>(b));
+}
+
+std::vector<double> PathEstimate::criticality(double path) const {
+  std::vector<double> crit(driver.size(), 0.0);
+  if (path <= 0)
+    return crit;
+  for (size_t b = 0; b < blocks.size(); ++b)
+    if (is_wire(blocks[b].output_net))
+      crit[blocks[b].output_net] =
+          std::clamp(1.0 - (required[b] - arrival[b]) / path, 0.0, 1.0);
+  return crit;
+}
+
+double PathEstimate::connection_criticality(int d, int b, double hops,
+                                            double path) const {
+  if (path <= 0)
+    return 0.0;
+  double needed = combinational(b) ? required[b] - LUT<4>::DELAY_PS
+                                   : path - capture_delay(b);
+  double slack = needed - (arrival[d] + hops * Fabric::HOP_DELAY_PS);
+  return std::clamp(1.0 - slack / path, 0.0, 1.0);
+}
+
+} // namespace vfpga
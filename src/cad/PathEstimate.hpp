@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../fabric/Fabric.hpp"
+#include "../primitives/BRAM.hpp"
+#include "../primitives/DFF.hpp"
+#include "../primitives/DSP.hpp"
+#include "../primitives/LUT.hpp"
+#include "LogicBlock.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace vfpga {
+
+// Longest-path timing over packed blocks, with the delays TimingAnalyzer
+// charges and routing delay from a caller's hop count per connection (the
+// packer's guesses, or the placer's distances). A block with a DFF, BRAM
+// or DSP launches paths at its output and captures them at its inputs;
+// LUT-only blocks are combinational.
+class PathEstimate {
+public:
+  explicit PathEstimate(const std::vector<LogicBlock> &blocks);
+
+  // Critical path delay in ps with 'hops(driver, sink)' routing hops per
+  // connection; fills the arrival and required times of block outputs
+  template <typename Hops> double analyze(Hops hops) {
+    auto wire = [&](int d, int b) { return hops(d, b) * Fabric::HOP_DELAY_PS; };
+    for (size_t b = 0; b < blocks.size(); ++b)
+      arrival[b] = combinational(b) ? LUT<4>::DELAY_PS : launch_delay(b);
+    for (int b : order)
+      for (NetId net : blocks[b].input_nets)
+        if (int d = driver_of(net); d >= 0)
+          arrival[b] = std::max(arrival[b], arrival[d] + wire(d, b) +
+                                                LUT<4>::DELAY_PS);
+
+    // Capture times, and the outputs nothing reads
+    double path = 0;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      path = std::max(path, arrival[b]);
+      if (combinational(b))
+        continue;
+      for (NetId net : blocks[b].input_nets)
+        if (int d = driver_of(net); d >= 0)
+          path = std::max(path, arrival[d] + wire(d, b) + capture_delay(b));
+    }
+
+    std::fill(required.begin(), required.end(), path);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      if (combinational(b))
+        continue;
+      for (NetId net : blocks[b].input_nets)
+        if (int d = driver_of(net); d >= 0)
+          required[d] = std::min(required[d], path - capture_delay(b) -
+                                                  wire(d, static_cast<int>(b)));
+    }
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+      for (NetId net : blocks[*it].input_nets)
+        if (int d = driver_of(net); d >= 0)
+          required[d] = std::min(required[d], required[*it] -
+                                                  LUT<4>::DELAY_PS -
+                                                  wire(d, *it));
+    return path;
+  }
+
+  // 1 - slack / path of the net each block drives, indexed by NetId,
+  // after analyze()
+  std::vector<double> criticality(double path) const;
+
+  // 1 - slack / path of the connection from block 'd' to block 'b' when
+  // it takes 'hops' routing hops, after analyze() returned 'path'
+  double connection_criticality(int d, int b, double hops, double path) const;
+
+  int driver_of(NetId net) const {
+    return is_wire(net) && static_cast<size_t>(net) < driver.size()
+               ? driver[net]
+               : -1;
+  }
+
+private:
+  const std::vector<LogicBlock> &blocks;
+  std::vector<int> driver; // Net -> block driving it, -1 if none
+  std::vector<int> order;  // Combinational blocks
+  std::vector<double> arrival, required;
+
+  bool combinational(size_t b) const {
+    return blocks[b].type == TileType::CLB && !blocks[b].use_dff;
+  }
+  double launch_delay(size_t b) const {
+    if (blocks[b].type == TileType::BRAM)
+      return BRAM::DELAY_READ_PS;
+    if (blocks[b].type == TileType::DSP)
+      return DSP::DELAY_MUL_PS;
+    return DFF::DELAY_CLK_Q_PS;
+  }
+  double capture_delay(size_t b) const {
+    return (blocks[b].use_lut ? LUT<4>::DELAY_PS : 0) + DFF::DELAY_SETUP_PS;
+  }
+};
+
+} // namespace vfpga
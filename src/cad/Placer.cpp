@@ -1,159 +1,1257 @@
 #include "Placer.hpp"
+#include "GlobalPlacer.hpp"
+#include "PathEstimate.hpp"
+#include "../utils/Philox.hpp"
+#include "../utils/ThreadPool.hpp"
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <limits>
-#include <unordered_map>
+#include <memory>
+#include <numeric>
+#include <random>
 
 namespace vfpga {
 
-std::map<int, std::pair<int, int>>
-Placer::place(Fabric &fabric, const std::vector<LogicBlock> &blocks) {
-  if (blocks.size() > fabric.size()) {
-    throw std::runtime_error("Not enough resources in Fabric to place design");
+namespace {
+
+using Pos = std::pair<int, int>;
+
+// Site kinds; blocks of other tile types are placed on CLB sites
+enum SiteKind { CLB_SITE, BRAM_SITE, DSP_SITE, NUM_SITE_KINDS };
+
+SiteKind site_kind(TileType type) {
+  if (type == TileType::BRAM)
+    return BRAM_SITE;
+  if (type == TileType::DSP)
+    return DSP_SITE;
+  return CLB_SITE;
+}
+
+// Tiles one placement unit can occupy: up to 'les' vertically adjacent CLB
+// tiles of a column, or a single BRAM or DSP tile
+struct Site {
+  std::vector<Pos> tiles;
+  int unit = -1; // Occupant, -1 if free
+};
+
+using SiteLists = std::array<std::vector<Site>, NUM_SITE_KINDS>;
+
+SiteLists make_sites(const Fabric &fabric, size_t les) {
+  SiteLists sites;
+  for (int x = 0; x < fabric.width; ++x) {
+    for (int y = 0; y < fabric.height; ++y) {
+      TileType type = fabric.get_tile(x, y).type;
+      if (type != TileType::CLB && type != TileType::BRAM &&
+          type != TileType::DSP)
+        continue;
+      auto &list = sites[site_kind(type)];
+      if (type == TileType::CLB && !list.empty() &&
+          list.back().tiles.size() < les &&
+          list.back().tiles.back() == Pos{x, y - 1})
+        list.back().tiles.push_back({x, y});
+      else
+        list.push_back(Site{{{x, y}}});
+    }
   }
+  return sites;
+}
 
-  std::map<int, std::pair<int, int>> current_locs;
+const char *const NOT_ENOUGH[NUM_SITE_KINDS] = {
+    "Not enough CLB tiles", "Not enough BRAM tiles", "Not enough DSP tiles"};
 
-  // 1. Organize Fabric Tiles by Type
-  std::vector<std::pair<int, int>> clb_tiles;
-  std::vector<std::pair<int, int>> bram_tiles;
-  std::vector<std::pair<int, int>> dsp_tiles;
-  std::vector<std::pair<int, int>> io_tiles;
+// Bounding box of a net's blocks with the number of blocks on each edge,
+// so that most moves update it without visiting the net's other blocks
+struct NetBox {
+  int min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+  int on_min_x = 0, on_max_x = 0, on_min_y = 0, on_max_y = 0;
 
-  for (const auto &tile : fabric.grid) {
-    if (tile.type == TileType::CLB)
-      clb_tiles.push_back({tile.x, tile.y});
-    else if (tile.type == TileType::BRAM)
-      bram_tiles.push_back({tile.x, tile.y});
-    else if (tile.type == TileType::DSP)
-      dsp_tiles.push_back({tile.x, tile.y});
-    else if (tile.type == TileType::IO)
-      io_tiles.push_back({tile.x, tile.y});
+  int64_t hpwl() const { return (max_x - min_x) + (max_y - min_y); }
+};
+
+// One axis of a box for a block moving from 'from' to 'to'; false if the
+// block was the last one on the edge it left, which needs a recompute
+bool shift_edges(int &lo, int &hi, int &on_lo, int &on_hi, int from, int to) {
+  if (to < from) {
+    if (from == hi) {
+      if (on_hi == 1)
+        return false;
+      --on_hi;
+    }
+    if (to < lo) {
+      lo = to;
+      on_lo = 1;
+    } else if (to == lo) {
+      ++on_lo;
+    }
+  } else if (to > from) {
+    if (from == lo) {
+      if (on_lo == 1)
+        return false;
+      --on_lo;
+    }
+    if (to > hi) {
+      hi = to;
+      on_hi = 1;
+    } else if (to == hi) {
+      ++on_hi;
+    }
   }
+  return true;
+}
 
-  // 2. Random Initialization respecting types
-  std::random_device rd;
-  std::mt19937 g(rd());
-  std::shuffle(clb_tiles.begin(), clb_tiles.end(), g);
-  std::shuffle(bram_tiles.begin(), bram_tiles.end(), g);
-  std::shuffle(dsp_tiles.begin(), dsp_tiles.end(), g);
+// Bounding box of the blocks 'first'..'last' of a net at 'pos'
+NetBox compute_box(const int *first, const int *last,
+                   const std::vector<Pos> &pos) {
+  NetBox box;
+  box.min_x = box.min_y = std::numeric_limits<int>::max();
+  box.max_x = box.max_y = std::numeric_limits<int>::min();
+  auto edge = [](int v, int &lo, int &hi, int &on_lo, int &on_hi) {
+    if (v < lo) {
+      lo = v;
+      on_lo = 0;
+    }
+    if (v > hi) {
+      hi = v;
+      on_hi = 0;
+    }
+    on_lo += v == lo;
+    on_hi += v == hi;
+  };
+  for (const int *b = first; b != last; ++b) {
+    auto [x, y] = pos[*b];
+    edge(x, box.min_x, box.max_x, box.on_min_x, box.on_max_x);
+    edge(y, box.min_y, box.max_y, box.on_min_y, box.on_max_y);
+  }
+  return box;
+}
 
-  size_t clb_idx = 0;
-  size_t bram_idx = 0;
-  size_t dsp_idx = 0;
+int distance(Pos a, Pos b) {
+  return std::abs(a.first - b.first) + std::abs(a.second - b.second);
+}
 
-  for (const auto &block : blocks) {
-    if (block.type == TileType::CLB) {
-      if (clb_idx >= clb_tiles.size())
-        throw std::runtime_error("Not enough CLB tiles");
-      current_locs[block.id] = clb_tiles[clb_idx++];
-    } else if (block.type == TileType::BRAM) {
-      if (bram_idx >= bram_tiles.size())
-        throw std::runtime_error("Not enough BRAM tiles");
-      current_locs[block.id] = bram_tiles[bram_idx++];
-    } else if (block.type == TileType::DSP) {
-      if (dsp_idx >= dsp_tiles.size())
-        throw std::runtime_error("Not enough DSP tiles");
-      current_locs[block.id] = dsp_tiles[dsp_idx++];
-    } else {
-      // Fallback or IO?
-      // Treating others as CLB for now or throw
-      if (clb_idx >= clb_tiles.size())
-        throw std::runtime_error("Not enough tiles for unknown type");
-      current_locs[block.id] = clb_tiles[clb_idx++];
-    }
-  }
-
-  double current_cost = calculate_cost(blocks, current_locs);
-  double initial_temp = 100.0 * std::sqrt(blocks.size()); // Heuristic
-  double final_temp = 0.01;
-  double alpha = 0.95; // Cooling rate
-  int moves_per_temp = 10 * blocks.size();
-
-  double temp = initial_temp;
-
-  // Annealing Loop
-  while (temp > final_temp) {
-    for (int i = 0; i < moves_per_temp; ++i) {
-      if (blocks.empty())
-        break;
-
-      std::uniform_int_distribution<> distr_block(0, blocks.size() - 1);
-      int idx = distr_block(g);
-      const auto &block = blocks[idx];
-      int block_id = block.id;
-
-      // Pick a destination tile COMPATIBLE with block type
-      std::pair<int, int> new_pos;
-      if (block.type == TileType::CLB) {
-        std::uniform_int_distribution<> d(0, clb_tiles.size() - 1);
-        new_pos = clb_tiles[d(g)];
-      } else if (block.type == TileType::BRAM) {
-        std::uniform_int_distribution<> d(0, bram_tiles.size() - 1);
-        new_pos = bram_tiles[d(g)];
-      } else if (block.type == TileType::DSP) {
-        std::uniform_int_distribution<> d(0, dsp_tiles.size() - 1);
-        new_pos = dsp_tiles[d(g)];
-      } else {
-        continue;
+// Placement units (clusters or single blocks) on their sites, the block
+// positions, the nets with blocks on two or more tiles' worth of pins (CSR
+// both ways), and the driver-to-sink connections between blocks (CSR from
+// each block)
+struct Layout {
+  std::vector<std::vector<int>> units;
+  std::vector<SiteKind> unit_kind;
+  std::vector<int> unit_site; // Index into the unit kind's site list
+  std::vector<int> unit_base; // Local index of its first block in a Region
+  SiteLists sites;
+  std::vector<Pos> pos; // Per block
+
+  std::vector<uint32_t> net_first, block_first;
+  std::vector<int> net_blocks, block_nets;
+
+  std::vector<int> conn_driver, conn_sink;
+  std::vector<uint32_t> block_conn_first;
+  std::vector<int> block_conns;
+
+  // Cost weights: per tile of a net's half perimeter, raised by
+  // congestion_weight times the mean RUDY overflow over the net's box, and
+  // per tile of each connection's length. Plain HPWL until a cost update.
+  double wire_weight = 1.0, congestion_weight = 0.0;
+  std::vector<double> conn_weight;
+  std::vector<double> overflow; // Prefix sums over (x, y), 'rows' per column
+  int rows = 0;
+
+  double net_cost(const NetBox &box) const {
+    double cost = wire_weight * static_cast<double>(box.hpwl());
+    if (overflow.empty())
+      return cost;
+    auto at = [&](int x, int y) { return overflow[x * rows + y]; };
+    double over = at(box.max_x + 1, box.max_y + 1) -
+                  at(box.min_x, box.max_y + 1) - at(box.max_x + 1, box.min_y) +
+                  at(box.min_x, box.min_y);
+    double area = static_cast<double>(box.max_x - box.min_x + 1) *
+                  (box.max_y - box.min_y + 1);
+    return cost * (1.0 + congestion_weight * over / area);
+  }
+
+  NetBox net_box(size_t n) const {
+    return compute_box(net_blocks.data() + net_first[n],
+                       net_blocks.data() + net_first[n + 1], pos);
+  }
+
+  int64_t wirelength() const {
+    int64_t total = 0;
+    for (size_t n = 0; n + 1 < net_first.size(); ++n)
+      total += net_box(n).hpwl();
+    return total;
+  }
+
+  double total_cost() const {
+    double cost = 0;
+    for (size_t n = 0; n + 1 < net_first.size(); ++n)
+      cost += net_cost(net_box(n));
+    for (size_t c = 0; c < conn_weight.size(); ++c)
+      cost += conn_weight[c] * distance(pos[conn_driver[c]], pos[conn_sink[c]]);
+    return cost;
+  }
+};
+
+// Fabric tiles [x0, x1) x [y0, y1)
+struct Bounds {
+  int x0, y0, x1, y1;
+
+  bool contains(Pos p) const {
+    return p.first >= x0 && p.first < x1 && p.second >= y0 && p.second < y1;
+  }
+};
+
+// Simulated annealing of the units on the sites of one fabric region (the
+// sites whose first tile it holds), with every block outside it held where
+// the Layout had it. Block positions and net bounding boxes are kept per
+// local index, so a move costs the fanout of the moved blocks rather than
+// the design size. Moves only write the region's own sites and units, so
+// disjoint regions anneal concurrently; store() publishes the positions.
+class Region {
+public:
+  Region(Layout &layout, const Bounds &bounds, Philox rng)
+      : layout(layout), bounds(bounds), rng(rng) {
+    index_sites();
+    index_nets();
+    index_connections();
+    for (size_t n = 0; n < boxes.size(); ++n)
+      boxes[n] = compute_box(static_cast<int>(n));
+    for (size_t c = 0; c < conn_ends.size(); ++c)
+      lengths[c] = distance(pos[conn_ends[c].first], pos[conn_ends[c].second]);
+    reweigh();
+  }
+
+  double cost = 0;
+
+  // Recompute the cost after the Layout's weights changed
+  void reweigh() {
+    cost = 0;
+    for (size_t n = 0; n < boxes.size(); ++n) {
+      net_costs[n] = layout.net_cost(boxes[n]);
+      cost += net_costs[n];
+    }
+    for (size_t c = 0; c < conn_ends.size(); ++c) {
+      weights[c] = layout.conn_weight[conn_ids[c]];
+      cost += weights[c] * lengths[c];
+    }
+  }
+
+  size_t num_units() const { return own_units.size(); }
+  size_t num_nets() const { return boxes.size(); }
+
+  // 20 standard deviations of the cost over one accepted random move per
+  // unit (VPR's starting temperature)
+  double starting_temperature(double range) {
+    double sum = 0, sum_sq = 0;
+    size_t samples = 0;
+    for (size_t i = 0; i < own_units.size(); ++i) {
+      if (auto proposal = propose(range)) {
+        commit(proposal->second);
+        sum += cost;
+        sum_sq += cost * cost;
+        ++samples;
       }
+    }
+    if (samples < 2)
+      return 0.0;
+    double mean = sum / samples;
+    return 20.0 * std::sqrt(std::max(0.0, sum_sq / samples - mean * mean));
+  }
+
+  // Standard deviation of the cost change of one proposal per unit within
+  // 'range', each reverted, for starting from a placement worth keeping
+  double move_deviation(double range) {
+    double sum = 0, sum_sq = 0;
+    size_t samples = 0;
+    for (size_t i = 0; i < own_units.size(); ++i) {
+      if (auto proposal = propose(range)) {
+        const Move &move = proposal->first;
+        swap_sites(move.kind, move.from, move.to);
+        double delta = proposal->second;
+        sum += delta;
+        sum_sq += delta * delta;
+        ++samples;
+      }
+    }
+    if (samples < 2)
+      return 0.0;
+    double mean = sum / samples;
+    return std::sqrt(std::max(0.0, sum_sq / samples - mean * mean));
+  }
+
+  // 'moves' proposals at 'temp'; returns the number accepted
+  long sweep(long moves, double temp, double range) {
+    long accepted = 0;
+    if (own_units.empty())
+      return 0;
+    for (long i = 0; i < moves; ++i)
+      if (auto proposal = propose(range))
+        accepted += decide(proposal->first, proposal->second, temp);
+    return accepted;
+  }
+
+  void store() const {
+    for (size_t i = 0; i < num_owned; ++i)
+      layout.pos[blocks[i]] = pos[i];
+  }
+
+private:
+  Layout &layout;
+  Bounds bounds;
+  Philox rng;
+  std::uniform_real_distribution<> chance{0.0, 1.0};
+
+  std::vector<int> own_units;
+  // Layout block of each local block: the units' blocks in order, then
+  // the blocks outside the region sharing a net with them
+  std::vector<int> blocks;
+  size_t num_owned = 0;
+  std::vector<Pos> pos;
+
+  // Site of each tile of the region (by column, then row) within its
+  // kind's list, -1 for tiles of no owned site, and the sorted columns
+  // holding each kind of site
+  std::vector<int> site_of_tile;
+  std::array<std::vector<int>, NUM_SITE_KINDS> kind_columns;
+
+  // The Layout's nets reaching owned blocks, over local blocks
+  std::vector<uint32_t> net_first, block_first;
+  std::vector<int> net_blocks, block_nets;
+  std::vector<NetBox> boxes;
+  std::vector<double> net_costs;
+
+  // The Layout's connections reaching owned blocks, over local blocks,
+  // with their weights and lengths (CSR from each owned block)
+  std::vector<std::pair<int, int>> conn_ends;
+  std::vector<int> conn_ids, lengths;
+  std::vector<double> weights;
+  std::vector<uint32_t> block_conn_first;
+  std::vector<int> block_conns;
+
+  // Per-move scratch: nets whose boxes and connections whose lengths the
+  // move changes
+  std::vector<NetBox> trial;
+  std::vector<double> trial_costs;
+  std::vector<uint32_t> stamp, conn_stamp;
+  std::vector<char> stale;
+  std::vector<int> touched, touched_conns, trial_lengths;
+  uint32_t move_id = 0;
+
+  int tile_index(int x, int y) const {
+    return (x - bounds.x0) * (bounds.y1 - bounds.y0) + (y - bounds.y0);
+  }
+
+  void index_sites() {
+    site_of_tile.assign(static_cast<size_t>(bounds.x1 - bounds.x0) *
+                            (bounds.y1 - bounds.y0),
+                        -1);
+    for (int kind = 0; kind < NUM_SITE_KINDS; ++kind) {
+      const auto &list = layout.sites[kind];
+      for (size_t s = 0; s < list.size(); ++s) {
+        if (!bounds.contains(list[s].tiles[0]))
+          continue;
+        for (Pos tile : list[s].tiles) {
+          if (!bounds.contains(tile))
+            continue;
+          site_of_tile[tile_index(tile.first, tile.second)] =
+              static_cast<int>(s);
+          auto &columns = kind_columns[kind];
+          if (columns.empty() || columns.back() != tile.first)
+            columns.push_back(tile.first); // Sites are listed by column
+        }
+        if (list[s].unit >= 0)
+          own_units.push_back(list[s].unit);
+      }
+    }
+    for (int u : own_units) {
+      layout.unit_base[u] = static_cast<int>(blocks.size());
+      blocks.insert(blocks.end(), layout.units[u].begin(),
+                    layout.units[u].end());
+    }
+    num_owned = blocks.size();
+  }
+
+  void index_nets() {
+    // Local indices of Layout blocks and nets, by binary search over the
+    // sorted owned blocks, outside blocks and nets
+    std::vector<std::pair<int, int>> owned(num_owned);
+    for (size_t i = 0; i < num_owned; ++i)
+      owned[i] = {blocks[i], static_cast<int>(i)};
+    std::sort(owned.begin(), owned.end());
+    auto owned_index = [&](int b) {
+      auto it = std::lower_bound(owned.begin(), owned.end(),
+                                 std::pair<int, int>{b, -1});
+      return it != owned.end() && it->first == b ? it->second : -1;
+    };
 
-      std::pair<int, int> old_pos = current_locs[block_id];
-      if (old_pos == new_pos)
+    std::vector<int> nets;
+    for (size_t i = 0; i < num_owned; ++i)
+      for (uint32_t k = layout.block_first[blocks[i]];
+           k < layout.block_first[blocks[i] + 1]; ++k)
+        nets.push_back(layout.block_nets[k]);
+    std::sort(nets.begin(), nets.end());
+    nets.erase(std::unique(nets.begin(), nets.end()), nets.end());
+
+    std::vector<int> outside;
+    for (int n : nets)
+      for (uint32_t k = layout.net_first[n]; k < layout.net_first[n + 1]; ++k)
+        if (owned_index(layout.net_blocks[k]) < 0)
+          outside.push_back(layout.net_blocks[k]);
+    std::sort(outside.begin(), outside.end());
+    outside.erase(std::unique(outside.begin(), outside.end()), outside.end());
+    blocks.insert(blocks.end(), outside.begin(), outside.end());
+    auto local_index = [&](int b) {
+      int i = owned_index(b);
+      if (i >= 0)
+        return i;
+      return static_cast<int>(
+          num_owned + (std::lower_bound(outside.begin(), outside.end(), b) -
+                       outside.begin()));
+    };
+
+    pos.resize(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+      pos[i] = layout.pos[blocks[i]];
+
+    net_first.assign(1, 0);
+    for (int n : nets) {
+      for (uint32_t k = layout.net_first[n]; k < layout.net_first[n + 1]; ++k)
+        net_blocks.push_back(local_index(layout.net_blocks[k]));
+      net_first.push_back(static_cast<uint32_t>(net_blocks.size()));
+    }
+    block_first.assign(1, 0);
+    for (size_t i = 0; i < num_owned; ++i) {
+      for (uint32_t k = layout.block_first[blocks[i]];
+           k < layout.block_first[blocks[i] + 1]; ++k)
+        block_nets.push_back(static_cast<int>(
+            std::lower_bound(nets.begin(), nets.end(), layout.block_nets[k]) -
+            nets.begin()));
+      block_first.push_back(static_cast<uint32_t>(block_nets.size()));
+    }
+
+    boxes.resize(nets.size());
+    net_costs.resize(nets.size());
+    trial.resize(nets.size());
+    trial_costs.resize(nets.size());
+    stamp.assign(nets.size(), 0);
+    stale.assign(nets.size(), 0);
+  }
+
+  void index_connections() {
+    if (layout.block_conn_first.empty())
+      return;
+    for (size_t i = 0; i < num_owned; ++i)
+      for (uint32_t k = layout.block_conn_first[blocks[i]];
+           k < layout.block_conn_first[blocks[i] + 1]; ++k)
+        conn_ids.push_back(layout.block_conns[k]);
+    std::sort(conn_ids.begin(), conn_ids.end());
+    conn_ids.erase(std::unique(conn_ids.begin(), conn_ids.end()),
+                   conn_ids.end());
+
+    // Both ends share a net with an owned block, so both have local indices
+    std::vector<std::pair<int, int>> local(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+      local[i] = {blocks[i], static_cast<int>(i)};
+    std::sort(local.begin(), local.end());
+    auto local_index = [&](int b) {
+      return std::lower_bound(local.begin(), local.end(),
+                              std::pair<int, int>{b, -1})
+          ->second;
+    };
+    for (int c : conn_ids)
+      conn_ends.emplace_back(local_index(layout.conn_driver[c]),
+                             local_index(layout.conn_sink[c]));
+
+    block_conn_first.assign(1, 0);
+    for (size_t i = 0; i < num_owned; ++i) {
+      for (uint32_t k = layout.block_conn_first[blocks[i]];
+           k < layout.block_conn_first[blocks[i] + 1]; ++k)
+        block_conns.push_back(static_cast<int>(
+            std::lower_bound(conn_ids.begin(), conn_ids.end(),
+                             layout.block_conns[k]) -
+            conn_ids.begin()));
+      block_conn_first.push_back(static_cast<uint32_t>(block_conns.size()));
+    }
+    lengths.assign(conn_ids.size(), 0);
+    weights.assign(conn_ids.size(), 0.0);
+    trial_lengths.assign(conn_ids.size(), 0);
+    conn_stamp.assign(conn_ids.size(), 0);
+  }
+
+  NetBox compute_box(int net) const {
+    return vfpga::compute_box(net_blocks.data() + net_first[net],
+                              net_blocks.data() + net_first[net + 1], pos);
+  }
+
+  // An owned site of the unit's kind whose first tile is within 'range'
+  // tiles of the unit's site on both axes, chosen uniformly by column and
+  // row; -1 if the tile drawn starts no owned site
+  int pick_site(int u, int range) {
+    SiteKind kind = layout.unit_kind[u];
+    auto [x0, y0] = layout.sites[kind][layout.unit_site[u]].tiles[0];
+    const auto &columns = kind_columns[kind];
+    auto lo = std::lower_bound(columns.begin(), columns.end(), x0 - range);
+    auto hi = std::upper_bound(columns.begin(), columns.end(), x0 + range);
+    std::uniform_int_distribution<> column(0, static_cast<int>(hi - lo) - 1);
+    std::uniform_int_distribution<> row(std::max(bounds.y0, y0 - range),
+                                        std::min(bounds.y1 - 1, y0 + range));
+    int x = lo[column(rng)];
+    return site_of_tile[tile_index(x, row(rng))];
+  }
+
+  // Exchange the occupants of two sites of one kind, moving their blocks
+  // and updating the trial boxes of their nets and the trial lengths of
+  // their connections. Returns the change in cost.
+  double swap_sites(SiteKind kind, int a, int b) {
+    auto &list = layout.sites[kind];
+    std::swap(list[a].unit, list[b].unit);
+    ++move_id;
+    touched.clear();
+    touched_conns.clear();
+    for (int s : {a, b}) {
+      int u = list[s].unit;
+      if (u < 0)
         continue;
+      layout.unit_site[u] = s;
+      for (size_t k = 0; k < layout.units[u].size(); ++k) {
+        int block = layout.unit_base[u] + static_cast<int>(k);
+        Pos from = pos[block], to = list[s].tiles[k];
+        pos[block] = to;
+        for (uint32_t i = block_first[block]; i < block_first[block + 1];
+             ++i) {
+          int net = block_nets[i];
+          if (stamp[net] != move_id) {
+            stamp[net] = move_id;
+            touched.push_back(net);
+            trial[net] = boxes[net];
+            stale[net] = 0;
+          }
+          NetBox &box = trial[net];
+          if (!stale[net])
+            stale[net] = !shift_edges(box.min_x, box.max_x, box.on_min_x,
+                                      box.on_max_x, from.first, to.first) ||
+                         !shift_edges(box.min_y, box.max_y, box.on_min_y,
+                                      box.on_max_y, from.second, to.second);
+        }
+        if (block_conn_first.empty())
+          continue;
+        for (uint32_t i = block_conn_first[block];
+             i < block_conn_first[block + 1]; ++i) {
+          int c = block_conns[i];
+          if (conn_stamp[c] != move_id) {
+            conn_stamp[c] = move_id;
+            touched_conns.push_back(c);
+          }
+        }
+      }
+    }
 
-      // Check if occupied
-      int occupied_by = -1;
-      for (auto const &[bid, loc] : current_locs) {
-        if (loc == new_pos) {
-          occupied_by = bid;
-          break;
+    double delta = 0;
+    for (int net : touched) {
+      if (stale[net])
+        trial[net] = compute_box(net);
+      trial_costs[net] = layout.net_cost(trial[net]);
+      delta += trial_costs[net] - net_costs[net];
+    }
+    for (int c : touched_conns) {
+      trial_lengths[c] =
+          distance(pos[conn_ends[c].first], pos[conn_ends[c].second]);
+      delta += weights[c] * (trial_lengths[c] - lengths[c]);
+    }
+    return delta;
+  }
+
+  void commit(double delta) {
+    for (int net : touched) {
+      boxes[net] = trial[net];
+      net_costs[net] = trial_costs[net];
+    }
+    for (int c : touched_conns)
+      lengths[c] = trial_lengths[c];
+    cost += delta;
+  }
+
+  // Propose moving a random unit to a site within 'range'; the occupant,
+  // if any, swaps into the vacated site. Applies the move and returns its
+  // change in cost, or nothing if the move is void or does not fit.
+  struct Move {
+    SiteKind kind;
+    int from, to;
+  };
+  std::optional<std::pair<Move, double>> propose(double range) {
+    std::uniform_int_distribution<> pick_unit(0, own_units.size() - 1);
+    int u = own_units[pick_unit(rng)];
+    SiteKind kind = layout.unit_kind[u];
+    auto &list = layout.sites[kind];
+    int from = layout.unit_site[u];
+    int to = pick_site(u, static_cast<int>(range));
+    if (to < 0 || to == from)
+      return std::nullopt;
+    int occupied_by = list[to].unit;
+    if (layout.units[u].size() > list[to].tiles.size() ||
+        (occupied_by >= 0 &&
+         layout.units[occupied_by].size() > list[from].tiles.size()))
+      return std::nullopt;
+    Move move{kind, from, to};
+    return std::pair{move, swap_sites(kind, from, to)};
+  }
+
+  // Metropolis criterion at 'temp'; a rejected move is reverted
+  bool decide(const Move &move, double delta, double temp) {
+    if (delta <= 0 || (temp > 0 && chance(rng) < std::exp(-delta / temp))) {
+      commit(delta);
+      return true;
+    }
+    swap_sites(move.kind, move.from, move.to);
+    return false;
+  }
+};
+
+// VPR-style annealing schedule over a Layout. The starting temperature is
+// 20 standard deviations of the cost change of random moves, each
+// temperature's acceptance rate picks the next cooling factor and the move
+// range limit (destinations within that many tiles, at least 3, shrinking
+// as fewer moves are accepted), and annealing ends with a greedy pass once
+// the temperature drops below exit_ratio times the cost per net. Small
+// designs get at least 10 moves per unit and temperature.
+//
+// With 'global_placement' the units first get the positions of a
+// GlobalPlacer run, spread each round by recursive bisection of the sites
+// of each kind and Tetris legalization, and the anneal starts from there
+// at 'refine_temperature' with the smallest move range.
+//
+// With 'regions' > 1 each temperature splits the fabric into a grid of
+// about that many Regions, shifted by half a region every other
+// temperature, and anneals them concurrently: a unit moves only within its
+// region, against the positions the other regions' blocks had when the
+// temperature started, and the positions are merged afterwards.
+//
+// The cost is VPR's timing-driven one plus a congestion term. Once per
+// temperature the placement is timed, each connection weighted by its
+// criticality to a power rising from 1 to 8 as the move range shrinks, and
+// the RUDY routing demand of every tile (each net's wire spread evenly
+// over its bounding box) recomputed. Until the next update the cost is
+// (1 - timing_tradeoff) times the wirelength plus timing_tradeoff times
+// the weighted connection lengths, each normalized by its value at the
+// update, and each net's wirelength is raised by congestion_weight times
+// the mean demand beyond one track over its box.
+//
+// Every random choice comes from a Philox stream of 'key' named by what
+// it is for, so the placement depends on the key alone.
+class Annealer {
+public:
+  Annealer(const Fabric &fabric, const std::vector<LogicBlock> &blocks,
+           const std::vector<Cluster> &clusters, const PlacerOptions &options,
+           uint64_t key, ThreadPool *pool)
+      : fabric(fabric), blocks(blocks), clusters(clusters), options(options),
+        key(key), rng(key, ASSIGN_STREAM), pool(pool) {
+    layout.pos.resize(blocks.size());
+    index_nets();
+    if (options.timing_tradeoff > 0) {
+      estimate.emplace(blocks);
+      index_connections();
+    }
+  }
+
+  std::map<int, std::pair<int, int>> run() {
+    make_units(!clusters.empty());
+    std::optional<SiteKind> short_of = assign();
+    if (short_of && !clusters.empty()) {
+      make_units(false);
+      short_of = assign();
+    }
+    if (short_of)
+      throw std::runtime_error(NOT_ENOUGH[*short_of]);
+    if (options.global_placement)
+      global_place();
+    for (size_t u = 0; u < layout.units.size(); ++u)
+      locate(static_cast<int>(u));
+    anneal();
+
+    std::map<int, std::pair<int, int>> placement;
+    for (size_t b = 0; b < blocks.size(); ++b)
+      placement[blocks[b].id] = layout.pos[b];
+    return placement;
+  }
+
+private:
+  // Streams: the initial assignment, the whole-fabric annealing and the
+  // final quench; region i at temperature step s uses (s + 1) << 32 | i
+  static constexpr uint64_t ASSIGN_STREAM = 0, ANNEAL_STREAM = 1,
+                            QUENCH_STREAM = 2;
+
+  const Fabric &fabric;
+  const std::vector<LogicBlock> &blocks;
+  const std::vector<Cluster> &clusters;
+  const PlacerOptions &options;
+  uint64_t key;
+  Philox rng; // ASSIGN_STREAM
+  ThreadPool *pool;
+  Layout layout;
+  std::optional<PathEstimate> estimate; // For timing-driven costs
+  std::vector<int> tile_site; // Site of each tile (y * width + x), or -1
+
+  void index_nets() {
+    NetId max_net = NO_NET;
+    for (const auto &b : blocks) {
+      max_net = std::max(max_net, b.output_net);
+      for (NetId net : b.input_nets)
+        max_net = std::max(max_net, net);
+    }
+    // Distinct wire nets of each block
+    std::vector<std::vector<NetId>> nets_of(blocks.size());
+    std::vector<uint32_t> degree(static_cast<size_t>(max_net) + 1, 0);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      auto &nets = nets_of[b];
+      nets = blocks[b].input_nets;
+      nets.push_back(blocks[b].output_net);
+      nets.erase(std::remove_if(nets.begin(), nets.end(),
+                                [](NetId n) { return !is_wire(n); }),
+                 nets.end());
+      std::sort(nets.begin(), nets.end());
+      nets.erase(std::unique(nets.begin(), nets.end()), nets.end());
+      for (NetId n : nets)
+        ++degree[n];
+    }
+
+    // Nets on a single block have no length and are left out
+    std::vector<int> index(degree.size(), -1);
+    int num_nets = 0;
+    for (size_t n = 0; n < degree.size(); ++n)
+      if (degree[n] > 1)
+        index[n] = num_nets++;
+
+    auto &block_first = layout.block_first, &net_first = layout.net_first;
+    block_first.assign(blocks.size() + 1, 0);
+    net_first.assign(static_cast<size_t>(num_nets) + 1, 0);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      block_first[b + 1] = block_first[b];
+      for (NetId n : nets_of[b]) {
+        if (index[n] < 0)
+          continue;
+        layout.block_nets.push_back(index[n]);
+        ++block_first[b + 1];
+        ++net_first[index[n] + 1];
+      }
+    }
+    std::partial_sum(net_first.begin(), net_first.end(), net_first.begin());
+    layout.net_blocks.resize(net_first.back());
+    std::vector<uint32_t> fill(net_first.begin(), net_first.end() - 1);
+    for (size_t b = 0; b < blocks.size(); ++b)
+      for (uint32_t i = block_first[b]; i < block_first[b + 1]; ++i)
+        layout.net_blocks[fill[layout.block_nets[i]]++] = static_cast<int>(b);
+  }
+
+  // A connection from the driver of each distinct input net of a block
+  // to the block, listed from both ends
+  void index_connections() {
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      std::vector<NetId> inputs = blocks[b].input_nets;
+      std::sort(inputs.begin(), inputs.end());
+      inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+      for (NetId net : inputs) {
+        int d = estimate->driver_of(net);
+        if (d >= 0 && d != static_cast<int>(b)) {
+          layout.conn_driver.push_back(d);
+          layout.conn_sink.push_back(static_cast<int>(b));
         }
       }
+    }
+    size_t num_conns = layout.conn_driver.size();
+    auto &first = layout.block_conn_first;
+    first.assign(blocks.size() + 1, 0);
+    for (size_t c = 0; c < num_conns; ++c) {
+      ++first[layout.conn_driver[c] + 1];
+      ++first[layout.conn_sink[c] + 1];
+    }
+    std::partial_sum(first.begin(), first.end(), first.begin());
+    layout.block_conns.resize(first.back());
+    std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+    for (size_t c = 0; c < num_conns; ++c) {
+      layout.block_conns[fill[layout.conn_driver[c]]++] = static_cast<int>(c);
+      layout.block_conns[fill[layout.conn_sink[c]]++] = static_cast<int>(c);
+    }
+    layout.conn_weight.assign(num_conns, 0.0);
+  }
+
+  void make_units(bool clustered) {
+    auto &units = layout.units;
+    units.clear();
+    std::vector<char> in_cluster(blocks.size(), 0);
+    if (clustered) {
+      for (const Cluster &cluster : clusters) {
+        if (cluster.blocks.empty())
+          continue;
+        units.push_back(cluster.blocks);
+        for (int b : cluster.blocks)
+          in_cluster[b] = 1;
+      }
+    }
+    for (size_t b = 0; b < blocks.size(); ++b)
+      if (!in_cluster[b])
+        units.push_back({static_cast<int>(b)});
+    layout.unit_kind.clear();
+    for (const auto &unit : units)
+      layout.unit_kind.push_back(site_kind(blocks[unit[0]].type));
+    layout.unit_base.assign(units.size(), 0);
+    layout.sites = make_sites(fabric, clustered ? Fabric::CLB_LES : 1);
+  }
 
-      // Apply move
-      current_locs[block_id] = new_pos;
-      if (occupied_by != -1) {
-        current_locs[occupied_by] = old_pos; // Swap
+  // Random initialization respecting types: the largest units take the
+  // largest sites, otherwise in shuffled order. Returns the kind of site
+  // that ran out, if any.
+  std::optional<SiteKind> assign() {
+    const auto &units = layout.units;
+    layout.unit_site.assign(units.size(), -1);
+    for (int kind = 0; kind < NUM_SITE_KINDS; ++kind) {
+      auto &list = layout.sites[kind];
+      std::vector<int> free(list.size());
+      std::iota(free.begin(), free.end(), 0);
+      std::shuffle(free.begin(), free.end(), rng);
+      std::stable_sort(free.begin(), free.end(), [&](int a, int b) {
+        return list[a].tiles.size() > list[b].tiles.size();
+      });
+      std::vector<int> members;
+      for (size_t u = 0; u < units.size(); ++u)
+        if (layout.unit_kind[u] == kind)
+          members.push_back(static_cast<int>(u));
+      std::stable_sort(members.begin(), members.end(), [&](int a, int b) {
+        return units[a].size() > units[b].size();
+      });
+      if (members.size() > free.size())
+        return static_cast<SiteKind>(kind);
+      for (size_t i = 0; i < members.size(); ++i) {
+        if (units[members[i]].size() > list[free[i]].tiles.size())
+          return static_cast<SiteKind>(kind);
+        layout.unit_site[members[i]] = free[i];
+        list[free[i]].unit = members[i];
       }
+    }
+    return std::nullopt;
+  }
+
+  void locate(int u) {
+    const Site &site = layout.sites[layout.unit_kind[u]][layout.unit_site[u]];
+    for (size_t k = 0; k < layout.units[u].size(); ++k)
+      layout.pos[layout.units[u][k]] = site.tiles[k];
+  }
+
+  // Recursive bisection of the units of each kind over its sites: the
+  // sites are halved across their longer side and the units split at the
+  // same rank along that axis, in proportion to the sites, down to one
+  // site each. Keeps the relative order of the units while spreading them
+  // evenly. Returns the first tile of each unit's site.
+  std::vector<GlobalPlacer::Point>
+  bisect(const std::vector<GlobalPlacer::Point> &targets) const {
+    std::vector<GlobalPlacer::Point> spread(targets.size());
+    for (int kind = 0; kind < NUM_SITE_KINDS; ++kind) {
+      std::vector<int> members;
+      for (size_t u = 0; u < layout.units.size(); ++u)
+        if (layout.unit_kind[u] == kind)
+          members.push_back(static_cast<int>(u));
+      std::vector<GlobalPlacer::Point> corners;
+      for (const Site &site : layout.sites[kind])
+        corners.push_back(site.tiles[0]);
+      split(members.begin(), members.end(), corners.begin(), corners.end(),
+            targets, spread);
+    }
+    return spread;
+  }
+
+  using PointIt = std::vector<GlobalPlacer::Point>::iterator;
+  static void split(std::vector<int>::iterator first,
+                    std::vector<int>::iterator last, PointIt site_first,
+                    PointIt site_last,
+                    const std::vector<GlobalPlacer::Point> &targets,
+                    std::vector<GlobalPlacer::Point> &spread) {
+    long units = last - first, sites = site_last - site_first;
+    if (units == 0)
+      return;
+    if (sites == 1) {
+      spread[*first] = *site_first;
+      return;
+    }
+    double min_x = std::numeric_limits<double>::max(), max_x = -min_x;
+    double min_y = min_x, max_y = max_x;
+    for (PointIt it = site_first; it != site_last; ++it) {
+      min_x = std::min(min_x, it->first);
+      max_x = std::max(max_x, it->first);
+      min_y = std::min(min_y, it->second);
+      max_y = std::max(max_y, it->second);
+    }
+    bool by_x = max_x - min_x >= max_y - min_y;
+    auto key = [by_x](const GlobalPlacer::Point &p) {
+      return by_x ? std::pair{p.first, p.second} : std::pair{p.second, p.first};
+    };
+    long half = sites / 2;
+    std::nth_element(
+        site_first, site_first + half, site_last,
+        [&](const auto &a, const auto &b) { return key(a) < key(b); });
+    long left =
+        std::clamp(std::lround(static_cast<double>(units) * half / sites),
+                   std::max(0L, units - (sites - half)), std::min(units, half));
+    std::nth_element(first, first + left, last, [&](int a, int b) {
+      return key(targets[a]) < key(targets[b]);
+    });
+    split(first, first + left, site_first, site_first + half, targets, spread);
+    split(first + left, last, site_first + half, site_last, targets, spread);
+  }
+
+  // Tetris legalization: the largest units first, then from left to right,
+  // each takes the free site of its kind whose first tile is nearest its
+  // target. Returns the first tile of each unit's site.
+  std::vector<GlobalPlacer::Point>
+  legalize(const std::vector<GlobalPlacer::Point> &targets) {
+    const auto &units = layout.units;
+    if (tile_site.empty()) {
+      tile_site.assign(fabric.size(), -1);
+      for (const auto &list : layout.sites)
+        for (size_t s = 0; s < list.size(); ++s)
+          for (auto [x, y] : list[s].tiles)
+            tile_site[y * fabric.width + x] = static_cast<int>(s);
+    }
+    for (auto &list : layout.sites)
+      for (Site &site : list)
+        site.unit = -1;
+
+    std::vector<int> order(units.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+      if (units[a].size() != units[b].size())
+        return units[a].size() > units[b].size();
+      return targets[a] < targets[b];
+    });
 
-      double new_cost = calculate_cost(blocks, current_locs);
-      double delta = new_cost - current_cost;
-
-      // Metropolis Criterion
-      bool accept = false;
-      if (delta < 0) {
-        accept = true;
-      } else {
-        std::uniform_real_distribution<> distr_prob(0.0, 1.0);
-        if (distr_prob(g) < std::exp(-delta / temp)) {
-          accept = true;
+    std::vector<GlobalPlacer::Point> placed(units.size());
+    int max_radius = std::max(fabric.width, fabric.height);
+    for (int u : order) {
+      auto [tx, ty] = targets[u];
+      int cx = std::clamp(static_cast<int>(std::lround(tx)), 0,
+                          fabric.width - 1);
+      int cy = std::clamp(static_cast<int>(std::lround(ty)), 0,
+                          fabric.height - 1);
+      SiteKind kind = layout.unit_kind[u];
+      auto &list = layout.sites[kind];
+      int best = -1;
+      double best_distance = std::numeric_limits<double>::max();
+      auto consider = [&](int x, int y) {
+        if (x < 0 || y < 0 || x >= fabric.width || y >= fabric.height)
+          return;
+        int s = tile_site[y * fabric.width + x];
+        if (s < 0 || site_kind(fabric.get_tile(x, y).type) != kind ||
+            list[s].unit >= 0 || list[s].tiles.size() < units[u].size())
+          return;
+        auto [sx, sy] = list[s].tiles[0];
+        double d = std::abs(sx - tx) + std::abs(sy - ty);
+        if (d < best_distance || (d == best_distance && s < best)) {
+          best_distance = d;
+          best = s;
+        }
+      };
+      // Rings of growing radius, until no nearer first tile can remain
+      for (int r = 0; r <= max_radius; ++r) {
+        if (best >= 0 && r > best_distance + Fabric::CLB_LES)
+          break;
+        for (int d = -r; d <= r; ++d) {
+          consider(cx + d, cy - r);
+          consider(cx + d, cy + r);
+          if (d != -r && d != r) {
+            consider(cx - r, cy + d);
+            consider(cx + r, cy + d);
+          }
         }
       }
+      list[best].unit = u;
+      layout.unit_site[u] = best;
+      placed[u] = list[best].tiles[0];
+    }
+    return placed;
+  }
+
+  // Quadratic placement of the units from their random sites, spread by
+  // bisection and legalization, leaving each unit on its legal site
+  void global_place() {
+    std::vector<int> unit_of(blocks.size());
+    for (size_t u = 0; u < layout.units.size(); ++u)
+      for (int b : layout.units[u])
+        unit_of[b] = static_cast<int>(u);
+    std::vector<int> cells(layout.net_blocks.size());
+    for (size_t k = 0; k < cells.size(); ++k)
+      cells[k] = unit_of[layout.net_blocks[k]];
+
+    std::vector<GlobalPlacer::Point> start(layout.units.size());
+    for (size_t u = 0; u < start.size(); ++u)
+      start[u] =
+          layout.sites[layout.unit_kind[u]][layout.unit_site[u]].tiles[0];
+    auto placed = GlobalPlacer::place(
+        start, layout.net_first, cells,
+        [&](const auto &solved) { return legalize(bisect(solved)); });
+    legalize(placed);
+  }
 
-      if (accept) {
-        current_cost = new_cost;
-      } else {
-        // Revert
-        current_locs[block_id] = old_pos;
-        if (occupied_by != -1) {
-          current_locs[occupied_by] = new_pos;
+  // One temperature on a grid of about options.regions regions, shifted by
+  // half a region on odd steps so that units cross the borders; the moves
+  // are shared out by units. Returns the fraction accepted.
+  double anneal_regions(long moves, double temp, double range, int step) {
+    int across = std::clamp(
+        static_cast<int>(std::ceil(std::sqrt(options.regions))), 1,
+        fabric.width);
+    int down = std::clamp((options.regions + across - 1) / across, 1,
+                          fabric.height);
+    int w = (fabric.width + across - 1) / across;
+    int h = (fabric.height + down - 1) / down;
+    int shift_x = step % 2 ? w / 2 : 0, shift_y = step % 2 ? h / 2 : 0;
+    std::vector<Bounds> grid;
+    for (int x = -shift_x; x < fabric.width; x += w)
+      for (int y = -shift_y; y < fabric.height; y += h)
+        grid.push_back({std::max(x, 0), std::max(y, 0),
+                        std::min(x + w, fabric.width),
+                        std::min(y + h, fabric.height)});
+
+    // Each region's stream is named by the step and its place in the grid,
+    // so the result does not depend on the number of threads or their
+    // scheduling
+    std::vector<std::unique_ptr<Region>> regions(grid.size());
+    std::vector<long> attempted(grid.size(), 0), accepted(grid.size(), 0);
+    double per_unit = static_cast<double>(moves) / layout.units.size();
+    pool->parallel_for(0, grid.size(), [&](size_t i) {
+      Philox stream(key, (static_cast<uint64_t>(step + 1) << 32) | i);
+      regions[i] = std::make_unique<Region>(layout, grid[i], stream);
+      attempted[i] = std::lround(per_unit * regions[i]->num_units());
+      accepted[i] = regions[i]->sweep(attempted[i], temp, range);
+    });
+    pool->parallel_for(0, grid.size(), [&](size_t i) { regions[i]->store(); });
+
+    long total = std::accumulate(attempted.begin(), attempted.end(), 0L);
+    return total ? static_cast<double>(std::accumulate(accepted.begin(),
+                                                       accepted.end(), 0L)) /
+                       total
+                 : 0.0;
+  }
+
+  // Cost update from the current positions (VPR's timing update): the
+  // criticality of each connection, routed over its Manhattan distance,
+  // raised to 'exponent'; the RUDY demand of each tile (every net's half
+  // perimeter plus one, spread evenly over its box) beyond the one track a
+  // tile routes; and weights making wirelength and timing
+  // 1 - timing_tradeoff and timing_tradeoff of the cost here
+  void update_costs(double exponent) {
+    const auto &pos = layout.pos;
+    size_t num_nets = layout.net_first.size() - 1;
+    std::vector<NetBox> boxes(num_nets);
+    for (size_t n = 0; n < num_nets; ++n)
+      boxes[n] = layout.net_box(n);
+
+    if (options.congestion_weight > 0) {
+      int rows = fabric.height + 1;
+      std::vector<double> demand(static_cast<size_t>(fabric.width + 1) * rows,
+                                 0.0);
+      for (const NetBox &box : boxes) {
+        double area = static_cast<double>(box.max_x - box.min_x + 1) *
+                      (box.max_y - box.min_y + 1);
+        double density = (box.hpwl() + 1) / area;
+        demand[box.min_x * rows + box.min_y] += density;
+        demand[(box.max_x + 1) * rows + box.min_y] -= density;
+        demand[box.min_x * rows + box.max_y + 1] -= density;
+        demand[(box.max_x + 1) * rows + box.max_y + 1] += density;
+      }
+      auto &over = layout.overflow;
+      over.assign(demand.size(), 0.0);
+      for (int x = 0; x < fabric.width; ++x) {
+        for (int y = 0; y < fabric.height; ++y) {
+          int i = x * rows + y;
+          if (x > 0)
+            demand[i] += demand[i - rows];
+          if (y > 0)
+            demand[i] += demand[i - 1];
+          if (x > 0 && y > 0)
+            demand[i] -= demand[i - rows - 1];
+          over[i + rows + 1] = std::max(0.0, demand[i] - 1.0) +
+                               over[i + rows] + over[i + 1] - over[i];
         }
       }
+      layout.rows = rows;
+      layout.congestion_weight = options.congestion_weight;
     }
-    temp *= alpha;
+
+    double tradeoff = estimate ? std::clamp(options.timing_tradeoff, 0.0, 1.0)
+                               : 0.0;
+    layout.wire_weight = 1.0;
+    double wire = 0;
+    for (const NetBox &box : boxes)
+      wire += layout.net_cost(box);
+    layout.wire_weight = wire > 0 ? (1.0 - tradeoff) / wire : 0.0;
+    if (!estimate)
+      return;
+
+    auto hops = [&](int d, int b) { return distance(pos[d], pos[b]); };
+    double path = estimate->analyze(hops);
+    double timing = 0;
+    for (size_t c = 0; c < layout.conn_weight.size(); ++c) {
+      int d = layout.conn_driver[c], b = layout.conn_sink[c];
+      double crit =
+          estimate->connection_criticality(d, b, hops(d, b), path);
+      layout.conn_weight[c] = std::pow(crit, exponent);
+      timing += layout.conn_weight[c] * hops(d, b);
+    }
+    for (double &weight : layout.conn_weight)
+      weight *= timing > 0 ? tradeoff / timing : 0.0;
   }
 
-  std::cout << "Final Placement Cost: " << current_cost << std::endl;
-  return current_locs;
+  void anneal() {
+    // VPR's moves per temperature, with enough for small designs to settle;
+    // the range limit keeps a few sites of slack on the sparse fabric
+    const long MIN_MOVES_PER_UNIT = 10;
+    const double MIN_RANGE = 3.0;
+    size_t num_units = layout.units.size();
+    double max_range = std::max(fabric.width, fabric.height);
+    double min_range = std::min(MIN_RANGE, max_range);
+    double range = options.global_placement ? min_range : max_range;
+    long moves_per_temp = std::max<long>(
+        MIN_MOVES_PER_UNIT * static_cast<long>(num_units),
+        std::lround(options.inner_num *
+                    std::pow(static_cast<double>(num_units), 4.0 / 3)));
+
+    // Costs are updated every temperature, with the criticality exponent
+    // going from 1 at the full range to 8 at the smallest (as in VPR)
+    bool update =
+        layout.net_first.size() > 1 &&
+        (options.timing_tradeoff > 0 || options.congestion_weight > 0);
+    auto exponent = [&](double r) {
+      return max_range > min_range
+                 ? 8.0 - 7.0 * (r - min_range) / (max_range - min_range)
+                 : 8.0;
+    };
+    if (update)
+      update_costs(exponent(range));
+
+    Bounds whole{0, 0, fabric.width, fabric.height};
+    auto region =
+        std::make_unique<Region>(layout, whole, Philox(key, ANNEAL_STREAM));
+    if (region->num_units() == 0 || region->num_nets() == 0)
+      return; // Every legal placement has zero cost
+
+    // After global placement only local moves are worth trying, at a
+    // temperature that keeps the structure found
+    double temp = options.global_placement
+                      ? options.refine_temperature *
+                            region->move_deviation(range)
+                      : region->starting_temperature(range);
+    double cost = region->cost;
+    double nets = static_cast<double>(region->num_nets());
+    bool parallel = options.regions > 1 && pool;
+    if (parallel) {
+      region->store();
+      region.reset();
+    }
+    for (int step = 0; cost > 0 && temp > options.exit_ratio * cost / nets;
+         ++step) {
+      double rate;
+      if (parallel)
+        rate = anneal_regions(moves_per_temp, temp, range, step);
+      else
+        rate = static_cast<double>(region->sweep(moves_per_temp, temp, range)) /
+               moves_per_temp;
+
+      // Cool fastest while nearly everything or nearly nothing is accepted,
+      // and keep the acceptance rate near 0.44 with the range limit
+      temp *= rate > 0.96 ? 0.5 : rate > 0.8 ? 0.9 : rate > 0.15 ? 0.95 : 0.8;
+      range = std::clamp(range * (1.0 - 0.44 + rate), min_range, max_range);
+
+      if (update) {
+        if (region)
+          region->store();
+        update_costs(exponent(range));
+        if (region)
+          region->reweigh();
+      }
+      cost = region ? region->cost : layout.total_cost();
+    }
+
+    // Greedy quench
+    if (!region)
+      region =
+          std::make_unique<Region>(layout, whole, Philox(key, QUENCH_STREAM));
+    region->sweep(moves_per_temp, 0.0, range);
+    region->store();
+  }
+};
+
+} // namespace
+
+std::map<int, std::pair<int, int>>
+Placer::place(Fabric &fabric, const std::vector<LogicBlock> &blocks,
+              uint32_t seed, const std::vector<Cluster> &clusters,
+              const PlacerOptions &options) {
+  if (blocks.size() > fabric.size()) {
+    throw std::runtime_error("Not enough resources in Fabric to place design");
+  }
+
+  size_t runs = static_cast<size_t>(std::max(options.seeds, 1));
+  std::unique_ptr<ThreadPool> pool;
+  if (options.regions > 1 || runs > 1)
+    pool = std::make_unique<ThreadPool>(options.threads);
+  std::vector<std::map<int, std::pair<int, int>>> placements(runs);
+  // Run k draws from key (k << 32 | seed), so run 0 is the single-run
+  // placement
+  auto place_run = [&](size_t k) {
+    uint64_t key = (static_cast<uint64_t>(k) << 32) | seed;
+    placements[k] =
+        Annealer(fabric, blocks, clusters, options, key, pool.get()).run();
+  };
+  if (runs > 1)
+    pool->parallel_for(0, runs, place_run);
+  else
+    place_run(0);
+
+  // The run of least cost, weighing wirelength and critical path as the
+  // annealer does, each relative to the best of all runs; the first wins
+  // ties
+  size_t best = 0;
+  if (runs > 1) {
+    double tradeoff = std::clamp(options.timing_tradeoff, 0.0, 1.0);
+    std::vector<double> hpwl(runs), path(runs, 0.0);
+    for (size_t k = 0; k < runs; ++k) {
+      hpwl[k] = calculate_cost(blocks, placements[k]);
+      if (tradeoff > 0)
+        path[k] = critical_path_ps(blocks, placements[k]);
+    }
+    double min_hpwl = *std::min_element(hpwl.begin(), hpwl.end());
+    double min_path = *std::min_element(path.begin(), path.end());
+    auto score = [&](size_t k) {
+      return (1.0 - tradeoff) * (min_hpwl > 0 ? hpwl[k] / min_hpwl : 1.0) +
+             tradeoff * (min_path > 0 ? path[k] / min_path : 1.0);
+    };
+    for (size_t k = 1; k < runs; ++k)
+      if (score(k) < score(best))
+        best = k;
+  }
+  std::cout << "Final Placement Cost: "
+            << calculate_cost(blocks, placements[best]) << std::endl;
+  return std::move(placements[best]);
 }
 
 double
 Placer::calculate_cost(const std::vector<LogicBlock> &blocks,
                        const std::map<int, std::pair<int, int>> &locations) {
-  // Build net-to-pins map
-  std::unordered_map<std::string, std::vector<std::pair<int, int>>> net_points;
+  // Bounding box of every net, indexed by NetId
+  struct Box {
+    int min_x = std::numeric_limits<int>::max();
+    int max_x = std::numeric_limits<int>::min();
+    int min_y = std::numeric_limits<int>::max();
+    int max_y = std::numeric_limits<int>::min();
+    int points = 0;
+
+    void add(std::pair<int, int> p) {
+      min_x = std::min(min_x, p.first);
+      max_x = std::max(max_x, p.first);
+      min_y = std::min(min_y, p.second);
+      max_y = std::max(max_y, p.second);
+      ++points;
+    }
+  };
 
   // We assume IO ports are at fixed locations or ignored for now?
   // WARNING: If we don't handle IOs, the cloud of logic might just drift
@@ -162,50 +1260,45 @@ Placer::calculate_cost(const std::vector<LogicBlock> &blocks,
   // would pull everything to 0,0. Let's assume input nets originate "nowhere"
   // (pure internal cost) unless we map IOs.
 
+  NetId max_net = NO_NET;
+  for (const auto &block : blocks) {
+    max_net = std::max(max_net, block.output_net);
+    for (NetId net : block.input_nets)
+      max_net = std::max(max_net, net);
+  }
+  std::vector<Box> boxes(max_net + 1);
+
   for (const auto &block : blocks) {
     std::pair<int, int> pos = locations.at(block.id);
 
     // Output drives a net
-    if (!block.output_net.empty()) {
-      net_points[block.output_net].push_back(pos);
-    }
+    if (block.output_net != NO_NET)
+      boxes[block.output_net].add(pos);
 
     // Inputs sink nets
-    for (const auto &net : block.input_nets) {
-      if (!net.empty()) {
-        net_points[net].push_back(pos);
-      }
-    }
+    for (NetId net : block.input_nets)
+      if (net != NO_NET)
+        boxes[net].add(pos);
   }
 
   double total_hpwl = 0;
-  for (const auto &[net_name, points] : net_points) {
-    if (points.size() > 1) { // Only nets with >= 2 points have length
-      total_hpwl += get_net_hpwl(points);
-    }
+  for (const auto &box : boxes) {
+    if (box.points > 1) // Only nets with >= 2 points have length
+      total_hpwl += (box.max_x - box.min_x) + (box.max_y - box.min_y);
   }
 
   return total_hpwl;
 }
 
-int Placer::get_net_hpwl(const std::vector<std::pair<int, int>> &points) {
-  int min_x = std::numeric_limits<int>::max();
-  int max_x = std::numeric_limits<int>::min();
-  int min_y = std::numeric_limits<int>::max();
-  int max_y = std::numeric_limits<int>::min();
-
-  for (const auto &p : points) {
-    if (p.first < min_x)
-      min_x = p.first;
-    if (p.first > max_x)
-      max_x = p.first;
-    if (p.second < min_y)
-      min_y = p.second;
-    if (p.second > max_y)
-      max_y = p.second;
-  }
-
-  return (max_x - min_x) + (max_y - min_y);
+double
+Placer::critical_path_ps(const std::vector<LogicBlock> &blocks,
+                         const std::map<int, std::pair<int, int>> &locations) {
+  std::vector<Pos> pos(blocks.size());
+  for (size_t b = 0; b < blocks.size(); ++b)
+    pos[b] = locations.at(blocks[b].id);
+  PathEstimate estimate(blocks);
+  return estimate.analyze(
+      [&](int d, int b) { return distance(pos[d], pos[b]); });
 }
 
 } // namespace vfpga
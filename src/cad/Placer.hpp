@@ -2,12 +2,31 @@
 
 #include "../fabric/Fabric.hpp"
 #include "LogicBlock.hpp"
+#include <cstdint>
 #include <map>
-#include <random>
 #include <vector>
 
 namespace vfpga {
 
+// VPR-style adaptive annealing schedule, optionally over parallel regions
+struct PlacerOptions {
+  double inner_num = 0.5;       // Moves per temperature: inner_num * units^4/3
+  double exit_ratio = 0.005;    // Stop below this temperature per net of cost
+  int regions = 1;              // Regions annealed concurrently, 1 for none
+  size_t threads = 0;           // Workers for regions or seeds, 0 for all
+  int seeds = 1;                // Placements run in parallel, best kept
+  bool global_placement = true; // Start from GlobalPlacer instead of random
+  // Starting temperature after global placement, in standard deviations of
+  // the cost change of local moves
+  double refine_temperature = 1.0;
+  // Weight of timing against wirelength in the cost (VPR's lambda); 0
+  // places for wirelength only
+  double timing_tradeoff = 0.5;
+  // Cost of a net's wirelength per unit of mean RUDY overflow over its
+  // bounding box; 0 leaves congestion out
+  double congestion_weight = 0.5;
+};
+
 class Placer {
 public:
   struct Placement {
@@ -17,19 +36,33 @@ public:
     int block_id;
   };
 
+  static constexpr uint32_t DEFAULT_SEED = 1;
+
   // Main entry point
   // Returns mapping: BlockID -> (x, y)
+  // With clusters (Packer::cluster) whole clusters move between CLB sites
+  // of Fabric::CLB_LES tiles, a cluster's blocks taking the tiles of its
+  // site in order; blocks outside every cluster move on their own. If the
+  // clusters do not fit the sites, every block is placed on its own.
+  // 'options' sets the schedule, parallelism and cost (see PlacerOptions).
+  //
+  // The seed alone decides the placement, whatever the number of threads.
   static std::map<int, std::pair<int, int>>
-  place(Fabric &fabric, const std::vector<LogicBlock> &blocks);
+  place(Fabric &fabric, const std::vector<LogicBlock> &blocks,
+        uint32_t seed = DEFAULT_SEED,
+        const std::vector<Cluster> &clusters = {},
+        const PlacerOptions &options = {});
 
-private:
-  // Helper to calculate cost (HPWL)
+  // Total HPWL of a placement (the wirelength part of the annealing cost)
   static double
   calculate_cost(const std::vector<LogicBlock> &blocks,
                  const std::map<int, std::pair<int, int>> &locations);
 
-  // Helper to calculate HPWL for a single net
-  static int get_net_hpwl(const std::vector<std::pair<int, int>> &points);
+  // Estimated critical path of a placement in ps, each connection routed
+  // over its Manhattan distance (the timing part of the annealing cost)
+  static double
+  critical_path_ps(const std::vector<LogicBlock> &blocks,
+                   const std::map<int, std::pair<int, int>> &locations);
 };
 
 } // namespace vfpga
@@ -54,56 +54,45 @@ bool Router::route(Fabric &fabric, const std::vector<LogicBlock> &blocks,
 
   // Identify Nets (Internal struct for routing logic)
   struct NetInfo {
-    std::string name;
+    NetId net;
     int source_node = -1;
     std::vector<int> sink_nodes;
     std::vector<int> current_path; // List of nodes used
   };
   std::vector<NetInfo> internal_nets;
 
-  // Helper to find existing net or create
-  // We can't use a lambda with auto return type easily if we want to modify the
-  // vector passing references. Let's just do it inline or use index.
+  // Nets are collected in order of first appearance; 'slot' maps a NetId to
+  // its entry in internal_nets
+  std::vector<int> slot;
+  auto info = [&](NetId net) -> NetInfo & {
+    if (slot.size() <= static_cast<size_t>(net))
+      slot.resize(net + 1, -1);
+    if (slot[net] < 0) {
+      slot[net] = static_cast<int>(internal_nets.size());
+      internal_nets.push_back({net, -1, {}, {}});
+    }
+    return internal_nets[slot[net]];
+  };
 
   for (const auto &block : blocks) {
-    if (block_to_node.find(block.id) == block_to_node.end())
+    auto placed = block_to_node.find(block.id);
+    if (placed == block_to_node.end())
       continue;
-    int node_id = block_to_node[block.id];
-
-    if (!block.output_net.empty()) {
-      bool found = false;
-      for (auto &n : internal_nets) {
-        if (n.name == block.output_net) {
-          n.source_node = node_id;
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        internal_nets.push_back({block.output_net, node_id, {}, {}});
-      }
-    }
-    for (const auto &input_net : block.input_nets) {
-      if (!input_net.empty()) {
-        bool found = false;
-        for (auto &n : internal_nets) {
-          if (n.name == input_net) {
-            n.sink_nodes.push_back(node_id);
-            found = true;
-            break;
-          }
-        }
-        if (!found) {
-          internal_nets.push_back({input_net, -1, {node_id}, {}});
-        }
-      }
-    }
+    int node_id = placed->second;
+
+    if (block.output_net != NO_NET)
+      info(block.output_net).source_node = node_id;
+    for (NetId input_net : block.input_nets)
+      if (input_net != NO_NET)
+        info(input_net).sink_nodes.push_back(node_id);
   }
 
   double pres_fac = PRES_FAC_INIT;
+  iterations = 0;
 
   for (int iter = 0; iter < MAX_ITERATIONS; ++iter) {
     bool congestion_free = true;
+    iterations = iter + 1;
 
     // 1. Rip-up & Route all nets
     for (auto &net : internal_nets) {
@@ -179,7 +168,7 @@ bool Router::route(Fabric &fabric, const std::vector<LogicBlock> &blocks,
             curr = parent[curr];
           }
         } else {
-          // std::cerr << "Failed to route part of net: " << net.name <<
+          // std::cerr << "Failed to route part of net: " << net.net <<
           // std::endl;
         }
       }
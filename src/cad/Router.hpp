@@ -47,6 +47,7 @@ public:
     std::vector<Point> path; // Full routing path (list of nodes/tiles)
   };
   std::vector<Net> nets; // Instance member, but route is static...
+  int iterations = 0;    // Pathfinder iterations used by the last route()
   // We should probably make Router a class instance, or just return nets from
   // route? Or make nets static? Static is messy. The TimingAnalyzer takes
   // 'const Router&'. So Router was intended to be an instance. But
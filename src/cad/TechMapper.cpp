@@ -0,0 +1,499 @@
+#include "TechMapper.hpp"
+#include "LutMask.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace vfpga {
+
+namespace {
+
+struct Gate {
+  std::string_view type;
+  int arity;
+  uint64_t mask; // Input 0 is the first input pin by name (A, then B, S)
+};
+
+constexpr Gate GATES[] = {
+    {"$_BUF_", 1, 0b10},  {"$_NOT_", 1, 0b01},   {"$_AND_", 2, 0x8},
+    {"$_NAND_", 2, 0x7},  {"$_OR_", 2, 0xE},     {"$_NOR_", 2, 0x1},
+    {"$_XOR_", 2, 0x6},   {"$_XNOR_", 2, 0x9},   {"$_ANDNOT_", 2, 0x2},
+    {"$_ORNOT_", 2, 0xB}, {"$_MUX_", 3, 0xCA},   {"$_NMUX_", 3, 0x35},
+    {"BUF", 1, 0b10},     {"INV", 1, 0b01},      {"NOT", 1, 0b01},
+    {"AND2", 2, 0x8},     {"NAND2", 2, 0x7},     {"OR2", 2, 0xE},
+    {"NOR2", 2, 0x1},     {"XOR2", 2, 0x6},      {"XNOR2", 2, 0x9},
+    {"MUX2", 3, 0xCA},
+};
+
+// Single-output function of up to MAX_WIDTH signals. Pseudo-net inputs
+// are constants ("x" is taken as 0).
+struct Node {
+  CellId cell;
+  NetId output;
+  uint64_t mask;
+  int width = 0;
+  std::array<NetId, LutMask::MAX_WIDTH> inputs{};
+};
+
+// Sorted set of leaf nets, with the cost of implementing the node above
+// it as one LUT
+struct Cut {
+  std::array<NetId, LutMask::MAX_WIDTH> leaves{};
+  int size = 0;
+  int depth = 0;
+  float area = 0;
+  uint64_t signature = 0; // One bit per leaf (mod 64), for quick rejects
+
+  void add(NetId leaf) {
+    leaves[size++] = leaf;
+    signature |= uint64_t{1} << (leaf & 63);
+  }
+  bool subset_of(const Cut &o) const {
+    return (signature & ~o.signature) == 0 &&
+           std::includes(o.leaves.begin(), o.leaves.begin() + o.size,
+                         leaves.begin(), leaves.begin() + size);
+  }
+};
+
+class CutMapper {
+public:
+  CutMapper(const Netlist &in, const MapperOptions &options,
+            MapperStats &stats)
+      : in(in), stats(stats),
+        K(std::clamp(options.lut_size, 1, LutMask::MAX_WIDTH)),
+        C(std::max(1, options.cuts_per_node)),
+        recover(options.area_recovery), node_of_net(in.num_nets(), -1),
+        node_of_cell(in.num_cells(), -1), root(in.num_nets(), 0) {}
+
+  Netlist run() {
+    decode();
+    order_nodes();
+    enumerate(false);
+    cover();
+    if (recover) {
+      compute_required();
+      enumerate(true);
+      cover();
+    }
+    stats.nodes = nodes.size();
+    return rebuild();
+  }
+
+private:
+  const Netlist &in;
+  MapperStats &stats;
+  const int K, C;
+  const bool recover;
+
+  std::vector<Node> nodes;
+  std::vector<int32_t> node_of_net;  // Node driving a net, or -1
+  std::vector<int32_t> node_of_cell; // Node of a cell, or -1
+  std::vector<char> root;            // Nets needed outside the network
+  std::vector<int32_t> order;        // Topological, then cyclic nodes
+  std::vector<char> cyclic;
+
+  std::vector<std::vector<Cut>> cuts; // Live priority cuts per node
+  std::vector<Cut> best;
+  std::vector<int> arrival;  // Depth of the best cut
+  std::vector<float> flow;   // Area flow of the best cut
+  std::vector<int> required; // Latest depth keeping the mapped depth
+  std::vector<char> used;    // In the cover
+
+  void decode() {
+    const NameId lut_type = in.find_name("$lut").value_or(-1);
+    std::vector<std::pair<NameId, const Gate *>> gate_types;
+    for (const Gate &g : GATES)
+      if (auto id = in.find_name(g.type))
+        gate_types.emplace_back(*id, &g);
+
+    std::vector<PinId> input_pins;
+    for (CellId c = 0; c < static_cast<CellId>(in.num_cells()); ++c) {
+      NameId type = in.cell(c).type;
+      auto gate = std::find_if(gate_types.begin(), gate_types.end(),
+                               [&](const auto &g) { return g.first == type; });
+      if (type != lut_type && gate == gate_types.end())
+        continue;
+
+      // One single-bit output pin; inputs sorted by name ($lut: one A bus)
+      std::optional<PinId> output;
+      bool ok = true;
+      input_pins.clear();
+      for (PinId p = in.first_pin(c); p < in.end_pin(c); ++p) {
+        PortDirection dir = in.pin(p).direction;
+        if (dir == PortDirection::OUTPUT && !output &&
+            in.nets_of(p).size() == 1)
+          output = p;
+        else if (dir == PortDirection::INPUT)
+          input_pins.push_back(p);
+        else
+          ok = false;
+      }
+      if (!ok || !output)
+        continue;
+      std::sort(input_pins.begin(), input_pins.end(), [&](PinId a, PinId b) {
+        return in.pin_name(a) < in.pin_name(b);
+      });
+
+      Node node{c, in.nets_of(*output)[0], 0};
+      if (!is_wire(node.output) || in.drivers(node.output).size() != 1)
+        continue;
+      if (type == lut_type) {
+        if (in.pin_name(*output) != "Y" || input_pins.size() > 1 ||
+            (input_pins.size() == 1 && in.pin_name(input_pins[0]) != "A"))
+          continue;
+        auto nets = input_pins.empty() ? std::span<const NetId>()
+                                       : in.nets_of(input_pins[0]);
+        const std::string *value = in.param(c, "LUT");
+        int width = static_cast<int>(nets.size());
+        auto mask = value && width <= K ? LutMask::parse(*value, width)
+                                        : std::nullopt;
+        if (!mask)
+          continue;
+        node.mask = *mask;
+        for (NetId n : nets)
+          node.inputs[node.width++] = n;
+      } else {
+        if (static_cast<int>(input_pins.size()) != gate->second->arity)
+          continue;
+        node.mask = gate->second->mask;
+        for (PinId p : input_pins) {
+          if (in.nets_of(p).size() != 1)
+            ok = false;
+          else
+            node.inputs[node.width++] = in.nets_of(p)[0];
+        }
+        if (!ok)
+          continue;
+      }
+      node_of_net[node.output] = static_cast<int32_t>(nodes.size());
+      node_of_cell[c] = static_cast<int32_t>(nodes.size());
+      nodes.push_back(node);
+    }
+
+    // Everything outside the network that reads a net needs it
+    for (CellId c = 0; c < static_cast<CellId>(in.num_cells()); ++c) {
+      if (node_of_cell[c] >= 0)
+        continue;
+      for (PinId p = in.first_pin(c); p < in.end_pin(c); ++p)
+        if (in.pin(p).direction != PortDirection::OUTPUT)
+          for (NetId n : in.nets_of(p))
+            if (is_wire(n))
+              root[n] = 1;
+    }
+    for (size_t i = 0; i < in.num_ports(); ++i)
+      if (in.port(i).direction != PortDirection::INPUT)
+        for (NetId n : in.port_nets(i))
+          if (is_wire(n))
+            root[n] = 1;
+  }
+
+  int32_t fanin_node(NetId n) const {
+    return is_wire(n) ? node_of_net[n] : -1;
+  }
+
+  // Kahn's algorithm; nodes on combinational loops come last and are
+  // mapped one to one
+  void order_nodes() {
+    std::vector<uint32_t> pending(nodes.size(), 0);
+    order.reserve(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      for (int k = 0; k < nodes[i].width; ++k)
+        pending[i] += fanin_node(nodes[i].inputs[k]) >= 0;
+      if (pending[i] == 0)
+        order.push_back(static_cast<int32_t>(i));
+    }
+    for (size_t head = 0; head < order.size(); ++head) {
+      for (PinId p : in.sinks(nodes[order[head]].output)) {
+        int32_t j = node_of_cell[in.pin(p).cell];
+        if (j >= 0 && --pending[j] == 0)
+          order.push_back(j);
+      }
+    }
+    cyclic.assign(nodes.size(), 0);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (pending[i] > 0) {
+        cyclic[i] = 1;
+        order.push_back(static_cast<int32_t>(i));
+      }
+    }
+  }
+
+  void cost(Cut &cut) const {
+    cut.depth = 0;
+    cut.area = 1;
+    for (int k = 0; k < cut.size; ++k) {
+      int32_t j = node_of_net[cut.leaves[k]];
+      if (j >= 0) {
+        cut.depth = std::max(cut.depth, arrival[j]);
+        cut.area += flow[j];
+      }
+    }
+    ++cut.depth;
+  }
+
+  bool merge(const Cut &a, const Cut &b, Cut &out) const {
+    if (std::popcount(a.signature | b.signature) > K)
+      return false;
+    out = Cut{};
+    int i = 0, j = 0;
+    while (i < a.size || j < b.size) {
+      NetId next;
+      if (j == b.size || (i < a.size && a.leaves[i] < b.leaves[j]))
+        next = a.leaves[i++];
+      else if (i == a.size || b.leaves[j] < a.leaves[i])
+        next = b.leaves[j++];
+      else
+        next = (++j, a.leaves[i++]);
+      if (out.size == K)
+        return false;
+      out.add(next);
+    }
+    return true;
+  }
+
+  // Keep the best C cuts of 'set' for node i, dropping duplicates and
+  // cuts that contain a better one
+  void select(std::vector<Cut> &set, int32_t i, bool recovery) const {
+    for (Cut &cut : set)
+      cost(cut);
+    int req = recovery ? required[i] : INT_MAX;
+    auto key = [&](const Cut &c) {
+      bool late = c.depth > req;
+      float first = recovery && !late ? c.area : float(c.depth);
+      float second = recovery && !late ? float(c.depth) : c.area;
+      return std::make_tuple(late, first, second, c.size);
+    };
+    std::sort(set.begin(), set.end(),
+              [&](const Cut &a, const Cut &b) { return key(a) < key(b); });
+    size_t kept = 0;
+    for (size_t a = 0; a < set.size() && kept < static_cast<size_t>(C); ++a) {
+      bool dominated = false;
+      for (size_t b = 0; b < kept && !dominated; ++b)
+        dominated = set[b].subset_of(set[a]);
+      if (!dominated)
+        set[kept++] = set[a];
+    }
+    set.resize(kept);
+  }
+
+  // The node's own inputs as one cut (always K-feasible)
+  Cut fanin_cut(const Node &n) const {
+    std::array<NetId, LutMask::MAX_WIDTH> wires;
+    int count = 0;
+    for (int k = 0; k < n.width; ++k)
+      if (is_wire(n.inputs[k]))
+        wires[count++] = n.inputs[k];
+    std::sort(wires.begin(), wires.begin() + count);
+    Cut cut;
+    for (int k = 0; k < count; ++k)
+      if (k == 0 || wires[k] != wires[k - 1])
+        cut.add(wires[k]);
+    cost(cut);
+    return cut;
+  }
+
+  void enumerate(bool recovery) {
+    cuts.assign(nodes.size(), {});
+    best.resize(nodes.size());
+    arrival.resize(nodes.size(), 0);
+    flow.resize(nodes.size(), 0.0f);
+
+    // Cut lists are freed once every fanout has been enumerated
+    std::vector<uint32_t> remaining(nodes.size(), 0);
+    for (const Node &n : nodes)
+      for (int k = 0; k < n.width; ++k)
+        if (int32_t j = fanin_node(n.inputs[k]); j >= 0)
+          ++remaining[j];
+
+    std::vector<Cut> set, next;
+    for (int32_t i : order) {
+      const Node &n = nodes[i];
+      set.assign(1, Cut{});
+      for (int k = 0; k < n.width && !cyclic[i]; ++k) {
+        NetId f = n.inputs[k];
+        if (!is_wire(f))
+          continue;
+        int32_t j = node_of_net[f];
+        Cut leaf;
+        leaf.add(f);
+        std::span<const Cut> from(&leaf, 1);
+        if (j >= 0 && !cuts[j].empty())
+          from = cuts[j];
+        next.clear();
+        Cut merged;
+        for (const Cut &a : set)
+          for (const Cut &b : from)
+            if (merge(a, b, merged))
+              next.push_back(merged);
+        select(next, i, recovery);
+        set.swap(next);
+      }
+      if (cyclic[i] || set.empty())
+        set.assign(1, fanin_cut(n));
+      else if (set.size() == 1 && set[0].size == 0)
+        cost(set[0]); // Constant
+
+      best[i] = set.front();
+      arrival[i] = best[i].depth;
+      flow[i] = best[i].area / std::max<float>(1, in.fanout(n.output));
+
+      // Fanouts see this node either through its cuts or as a leaf
+      Cut trivial;
+      trivial.add(n.output);
+      if (cyclic[i])
+        set.clear();
+      set.push_back(trivial);
+      cuts[i] = std::move(set);
+      set = {};
+
+      for (int k = 0; k < n.width; ++k)
+        if (int32_t j = fanin_node(n.inputs[k]); j >= 0 && --remaining[j] == 0)
+          std::vector<Cut>().swap(cuts[j]);
+    }
+    cuts.clear();
+  }
+
+  // Nodes whose outputs the rest of the netlist or a chosen LUT reads
+  void cover() {
+    used.assign(nodes.size(), 0);
+    std::vector<NetId> work;
+    stats.depth = 0;
+    for (NetId n = 0; n < static_cast<NetId>(root.size()); ++n) {
+      if (root[n] && node_of_net[n] >= 0) {
+        work.push_back(n);
+        stats.depth = std::max(stats.depth, arrival[node_of_net[n]]);
+      }
+    }
+    stats.luts = 0;
+    while (!work.empty()) {
+      int32_t i = node_of_net[work.back()];
+      work.pop_back();
+      if (used[i])
+        continue;
+      used[i] = 1;
+      ++stats.luts;
+      for (int k = 0; k < best[i].size; ++k)
+        if (node_of_net[best[i].leaves[k]] >= 0)
+          work.push_back(best[i].leaves[k]);
+    }
+  }
+
+  void compute_required() {
+    required.assign(nodes.size(), INT_MAX);
+    for (NetId n = 0; n < static_cast<NetId>(root.size()); ++n)
+      if (root[n] && node_of_net[n] >= 0)
+        required[node_of_net[n]] = stats.depth;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      int32_t i = *it;
+      if (!used[i] || required[i] == INT_MAX)
+        continue;
+      for (int k = 0; k < best[i].size; ++k)
+        if (int32_t j = node_of_net[best[i].leaves[k]]; j >= 0)
+          required[j] = std::min(required[j], required[i] - 1);
+    }
+  }
+
+  // Function of node i in terms of its cut leaves
+  uint64_t truth_table(int32_t i, const Cut &cut) const {
+    std::unordered_map<NetId, uint64_t> value;
+    for (int k = 0; k < cut.size; ++k)
+      value[cut.leaves[k]] = LutMask::input(k);
+
+    std::vector<std::pair<NetId, bool>> stack{{nodes[i].output, false}};
+    while (!stack.empty()) {
+      auto [net, expanded] = stack.back();
+      if (value.count(net)) {
+        stack.pop_back();
+        continue;
+      }
+      if (node_of_net[net] < 0)
+        throw std::logic_error("TechMapper: cut does not cover its cone");
+      const Node &n = nodes[node_of_net[net]];
+      if (!expanded) {
+        stack.back().second = true;
+        for (int k = 0; k < n.width; ++k)
+          if (is_wire(n.inputs[k]) && !value.count(n.inputs[k]))
+            stack.push_back({n.inputs[k], false});
+        continue;
+      }
+      std::array<uint64_t, LutMask::MAX_WIDTH> tables;
+      for (int k = 0; k < n.width; ++k) {
+        NetId f = n.inputs[k];
+        tables[k] = is_wire(f)           ? value.at(f)
+                    : f == CONST1_NET    ? ~uint64_t{0}
+                                         : 0;
+      }
+      value[net] = LutMask::compose(n.mask, {tables.data(), size_t(n.width)});
+      stack.pop_back();
+    }
+    return value.at(nodes[i].output) & LutMask::full(cut.size);
+  }
+
+  int bit_of(NetId net) const {
+    if (net == CONST0_NET)
+      return 0;
+    if (net == CONST1_NET)
+      return 1;
+    return is_wire(net) ? in.net_bit(net) : -1;
+  }
+
+  Netlist rebuild() const {
+    Netlist out;
+    std::vector<int> bits;
+    auto bits_of = [&](std::span<const NetId> nets) {
+      bits.clear();
+      for (NetId n : nets)
+        bits.push_back(bit_of(n));
+      return std::span<const int>(bits);
+    };
+
+    for (size_t i = 0; i < in.num_ports(); ++i)
+      out.add_port(in.port_name(i), in.port(i).direction,
+                   bits_of(in.port_nets(i)));
+
+    for (CellId c = 0; c < static_cast<CellId>(in.num_cells()); ++c) {
+      int32_t i = node_of_cell[c];
+      if (i < 0) {
+        CellId id = out.add_cell(in.cell_name(c), in.cell_type(c));
+        for (const auto &param : in.params(c))
+          out.add_param(id, in.name(param.key), param.value);
+        for (PinId p = in.first_pin(c); p < in.end_pin(c); ++p)
+          out.add_pin(id, in.pin_name(p), in.pin(p).direction,
+                      bits_of(in.nets_of(p)));
+        continue;
+      }
+      if (!used[i])
+        continue;
+
+      const Cut &cut = best[i];
+      CellId id = out.add_cell(in.cell_name(c), "$lut");
+      out.add_param(id, "WIDTH", std::to_string(cut.size));
+      out.add_param(id, "LUT",
+                    LutMask::format(truth_table(i, cut), cut.size));
+      if (cut.size > 0)
+        out.add_pin(id, "A", PortDirection::INPUT,
+                    bits_of({cut.leaves.data(), size_t(cut.size)}));
+      int y = bit_of(nodes[i].output);
+      out.add_pin(id, "Y", PortDirection::OUTPUT, std::span<const int>(&y, 1));
+    }
+    return out;
+  }
+};
+
+} // namespace
+
+Netlist TechMapper::map(const Netlist &netlist, const MapperOptions &options,
+                        MapperStats *stats) {
+  MapperStats local;
+  MapperStats &s = stats ? *stats : local;
+  s = MapperStats{};
+  return CutMapper(netlist, options, s).run();
+}
+
+} // namespace vfpga
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Netlist.hpp"
+#include <cstddef>
+
+namespace vfpga {
+
+struct MapperOptions {
+  int lut_size = 4;          // K, as the LUT<4> in each CLB (at most 6)
+  int cuts_per_node = 8;     // Priority cuts kept per node
+  bool area_recovery = true; // Re-map off the critical path for area
+};
+
+struct MapperStats {
+  size_t nodes = 0; // Gates and narrow LUTs that were mapped
+  size_t luts = 0;  // LUTs covering them
+  int depth = 0;    // LUT levels on the longest mapped path
+};
+
+// Technology mapping of combinational logic into K-input $lut cells.
+//
+// Single-output gates (the Yosys internal cells $_AND_, $_MUX_, ... and
+// generic AND2, INV, MUX2, ... cells) and $lut cells of at most K inputs
+// are the nodes of a logic network; everything else, and the top-level
+// ports, bound it. Gate inputs are taken in pin name order (A, B, S).
+//
+// Priority cuts: every node keeps its best 'cuts_per_node' K-feasible
+// cuts, ranked by depth and then area flow, merged from its fanins' cuts.
+// The cover is read back from the outputs the rest of the netlist needs,
+// and with area recovery the nodes off the critical path are then re-cut
+// for area flow without exceeding the depth found. Each LUT's mask is the
+// truth table of its cone over the cut leaves.
+//
+// Unmapped cells, ports and the names and bit numbers of surviving nets are
+// kept; a LUT takes the name of the node whose output it computes.
+class TechMapper {
+public:
+  static Netlist map(const Netlist &netlist, const MapperOptions &options = {},
+                     MapperStats *stats = nullptr);
+};
+
+} // namespace vfpga
@@ -0,0 +1,329 @@
+#include "BitstreamCompression.hpp"
+#include "../utils/Hash.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace vfpga {
+
+namespace {
+
+constexpr uint8_t RECORD_EMPTY_RUN = 0x00;
+constexpr uint8_t RECORD_FRAME = 0x01;
+
+// Zero runs shorter than this stay inside literals, so that e.g. the high
+// bytes of small mux selects don't cost a record each
+constexpr size_t MIN_ZERO_RUN = 4;
+
+CompressedBitstreamHeader make_header(const Fabric &fabric) {
+  CompressedBitstreamHeader h{};
+  std::memcpy(h.magic, CompressedBitstreamHeader::MAGIC, sizeof(h.magic));
+  h.version = CompressedBitstreamHeader::VERSION;
+  h.width = fabric.width;
+  h.height = fabric.height;
+  h.lut_inputs = Fabric::LUT_INPUTS;
+  h.bram_depth = Fabric::BRAM_DEPTH;
+  return h;
+}
+
+bool all_zero(const void *data, size_t bytes) {
+  const auto *p = static_cast<const uint8_t *>(data);
+  return std::all_of(p, p + bytes, [](uint8_t b) { return b == 0; });
+}
+
+bool is_empty(const Fabric::Frame &frame) {
+  return std::all_of(frame.lut_masks.begin(), frame.lut_masks.end(),
+                     [](uint16_t m) { return m == Fabric::LUT_PASSTHROUGH; }) &&
+         all_zero(frame.dff_init.data(), frame.dff_init.size_bytes()) &&
+         all_zero(frame.mux_selects.data(), frame.mux_selects.size_bytes()) &&
+         all_zero(frame.bram_init.data(), frame.bram_init.size_bytes());
+}
+
+class Encoder {
+public:
+  explicit Encoder(std::ostream &out) : out(out) {}
+
+  void bytes(const void *data, size_t size) {
+    out.write(static_cast<const char *>(data), size);
+    hash.update(data, size);
+    count += size;
+  }
+
+  void byte(uint8_t b) { bytes(&b, 1); }
+
+  void varint(uint64_t v) {
+    uint8_t buf[10];
+    size_t n = 0;
+    do {
+      buf[n] = static_cast<uint8_t>(v & 0x7F);
+      v >>= 7;
+      if (v)
+        buf[n] |= 0x80;
+      ++n;
+    } while (v);
+    bytes(buf, n);
+  }
+
+  // (<zeros> <literal length> <literals>)* covering exactly 'size' bytes
+  void zero_runs(const void *data, size_t size) {
+    const auto *p = static_cast<const uint8_t *>(data);
+    size_t i = 0;
+    while (i < size) {
+      size_t zeros = 0;
+      while (i + zeros < size && p[i + zeros] == 0)
+        ++zeros;
+      i += zeros;
+
+      size_t literal = 0;
+      while (i + literal < size) {
+        if (p[i + literal] != 0) {
+          ++literal;
+          continue;
+        }
+        size_t run = 0;
+        while (i + literal + run < size && p[i + literal + run] == 0)
+          ++run;
+        if (run >= MIN_ZERO_RUN || i + literal + run == size)
+          break;
+        literal += run;
+      }
+
+      varint(zeros);
+      varint(literal);
+      bytes(p + i, literal);
+      i += literal;
+    }
+  }
+
+  uint64_t size() const { return count; }
+  uint64_t digest() const { return hash.digest(); }
+
+private:
+  std::ostream &out;
+  Hasher hash;
+  uint64_t count = 0;
+};
+
+// Buffered reader that hashes everything it consumes.
+// Throws std::runtime_error on truncated or malformed input.
+class Decoder {
+public:
+  explicit Decoder(std::istream &in) : in(in), buffer(1 << 16) {}
+
+  void bytes(void *dst, size_t size) {
+    auto *out = static_cast<char *>(dst);
+    while (size > 0) {
+      if (pos == end)
+        refill();
+      size_t n = std::min(size, end - pos);
+      std::memcpy(out, buffer.data() + pos, n);
+      hash.update(buffer.data() + pos, n);
+      pos += n;
+      out += n;
+      size -= n;
+      count += n;
+    }
+  }
+
+  uint8_t byte() {
+    uint8_t b;
+    bytes(&b, 1);
+    return b;
+  }
+
+  uint64_t varint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t b = byte();
+      v |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return v;
+    }
+    throw std::runtime_error("malformed varint");
+  }
+
+  // Inverse of Encoder::zero_runs. 'dst' must already be zeroed.
+  void zero_runs(void *dst, size_t size) {
+    auto *p = static_cast<uint8_t *>(dst);
+    size_t i = 0;
+    while (i < size) {
+      uint64_t zeros = varint();
+      uint64_t literal = varint();
+      if ((zeros == 0 && literal == 0) || zeros > size - i ||
+          literal > size - i - zeros)
+        throw std::runtime_error("bad zero-run record");
+      i += zeros;
+      bytes(p + i, literal);
+      i += literal;
+    }
+  }
+
+  uint64_t size() const { return count; }
+  uint64_t digest() const { return hash.digest(); }
+
+private:
+  std::istream &in;
+  std::vector<char> buffer;
+  size_t pos = 0, end = 0;
+  Hasher hash;
+  uint64_t count = 0;
+
+  void refill() {
+    in.read(buffer.data(), buffer.size());
+    pos = 0;
+    end = static_cast<size_t>(in.gcount());
+    if (end == 0)
+      throw std::runtime_error("unexpected end of file");
+  }
+};
+
+} // namespace
+
+bool BitstreamCompression::encode(std::ostream &out, const Fabric &fabric) {
+  // Dictionary of non-default LUT masks, most frequent first
+  std::unordered_map<uint16_t, size_t> frequency;
+  for (uint16_t mask : fabric.lut_masks)
+    if (mask != Fabric::LUT_PASSTHROUGH)
+      ++frequency[mask];
+  std::vector<std::pair<uint16_t, size_t>> by_frequency(frequency.begin(),
+                                                        frequency.end());
+  std::sort(by_frequency.begin(), by_frequency.end(),
+            [](const auto &a, const auto &b) {
+              return a.second != b.second ? a.second > b.second
+                                          : a.first < b.first;
+            });
+  std::unordered_map<uint16_t, uint32_t> index; // 0 is the default mask
+  for (size_t i = 0; i < by_frequency.size(); ++i)
+    index[by_frequency[i].first] = static_cast<uint32_t>(i + 1);
+
+  CompressedBitstreamHeader header = make_header(fabric);
+  header.dictionary_size = static_cast<uint32_t>(by_frequency.size());
+  std::streampos start = out.tellp();
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  Encoder enc(out);
+  for (const auto &[mask, count] : by_frequency)
+    enc.bytes(&mask, sizeof(mask));
+
+  int empty_run = 0;
+  for (int x = 0; x < fabric.width; ++x) {
+    Fabric::Frame frame = fabric.frame(x);
+    if (is_empty(frame)) {
+      ++empty_run;
+      continue;
+    }
+    if (empty_run > 0) {
+      enc.byte(RECORD_EMPTY_RUN);
+      enc.varint(empty_run);
+      empty_run = 0;
+    }
+
+    enc.byte(RECORD_FRAME);
+    for (uint16_t mask : frame.lut_masks)
+      enc.varint(mask == Fabric::LUT_PASSTHROUGH ? 0 : index[mask]);
+    enc.zero_runs(frame.dff_init.data(), frame.dff_init.size_bytes());
+    enc.zero_runs(frame.mux_selects.data(), frame.mux_selects.size_bytes());
+    enc.zero_runs(frame.bram_init.data(), frame.bram_init.size_bytes());
+  }
+  if (empty_run > 0) {
+    enc.byte(RECORD_EMPTY_RUN);
+    enc.varint(empty_run);
+  }
+
+  header.body_bytes = enc.size();
+  header.checksum = enc.digest();
+  std::streampos finish = out.tellp();
+  out.seekp(start);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.seekp(finish);
+  return static_cast<bool>(out);
+}
+
+std::optional<CompressedBitstreamHeader>
+BitstreamCompression::read_header(std::istream &in) {
+  CompressedBitstreamHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, CompressedBitstreamHeader::MAGIC,
+                  sizeof(header.magic)) != 0 ||
+      header.version != CompressedBitstreamHeader::VERSION ||
+      header.lut_inputs != Fabric::LUT_INPUTS ||
+      header.bram_depth != Fabric::BRAM_DEPTH || header.width <= 0 ||
+      header.height <= 0) {
+    std::cerr << "Not a compatible compressed bitstream" << std::endl;
+    return std::nullopt;
+  }
+  return header;
+}
+
+bool BitstreamCompression::decode_image(std::istream &in,
+                                        const CompressedBitstreamHeader &header,
+                                        std::byte *image,
+                                        bool verify_checksum) {
+  // Empty frames are simply left in the image's default state
+  try {
+    Decoder dec(in);
+    std::vector<uint16_t> dictionary(header.dictionary_size);
+    dec.bytes(dictionary.data(), dictionary.size() * sizeof(uint16_t));
+
+    int x = 0;
+    while (x < header.width) {
+      uint8_t record = dec.byte();
+      if (record == RECORD_EMPTY_RUN) {
+        uint64_t run = dec.varint();
+        if (run == 0 || run > static_cast<uint64_t>(header.width - x))
+          throw std::runtime_error("bad empty-frame run");
+        x += static_cast<int>(run);
+        continue;
+      }
+      if (record != RECORD_FRAME)
+        throw std::runtime_error("unknown record type");
+
+      Fabric::Frame frame =
+          Fabric::frame_of(image, header.width, header.height, x++);
+      for (uint16_t &mask : frame.lut_masks) {
+        uint64_t i = dec.varint();
+        if (i > dictionary.size())
+          throw std::runtime_error("LUT mask index out of range");
+        mask = i == 0 ? Fabric::LUT_PASSTHROUGH : dictionary[i - 1];
+      }
+      dec.zero_runs(frame.dff_init.data(), frame.dff_init.size_bytes());
+      dec.zero_runs(frame.mux_selects.data(), frame.mux_selects.size_bytes());
+      dec.zero_runs(frame.bram_init.data(), frame.bram_init.size_bytes());
+    }
+
+    if (dec.size() != header.body_bytes)
+      throw std::runtime_error("body size mismatch");
+    if (verify_checksum && dec.digest() != header.checksum)
+      throw std::runtime_error("checksum mismatch");
+  } catch (const std::exception &e) {
+    std::cerr << "Bad compressed bitstream: " << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool BitstreamCompression::decode(std::istream &in, Fabric &fabric,
+                                  bool verify_checksum) {
+  auto header = read_header(in);
+  if (!header)
+    return false;
+  if (header->width != fabric.width || header->height != fabric.height) {
+    std::cerr << "Compressed bitstream (" << header->width << "x"
+              << header->height << ") does not match the " << fabric.width
+              << "x" << fabric.height << " fabric" << std::endl;
+    return false;
+  }
+
+  Fabric::ConfigImage previous = fabric.clear_config();
+  if (!decode_image(in, *header, fabric.config_image().data(),
+                    verify_checksum)) {
+    fabric.attach_config(std::move(previous.owner), previous.base);
+    return false;
+  }
+  return true;
+}
+
+} // namespace vfpga
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Fabric.hpp"
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+
+namespace vfpga {
+
+// Compressed bitstream encoding for sparse fabrics.
+//
+// After the header comes a dictionary of the distinct non-default LUT masks
+// (most frequent first), then one record per run of frames:
+//   0x00 <varint n>  n consecutive frames in the default (empty) state
+//   0x01 <frame>     one frame:
+//                    LUT masks as varint dictionary indices (0 = default),
+//                    then DFF init, mux selects and BRAM init as zero-run
+//                    coded bytes: (<varint zeros> <varint n> <n bytes>)*
+// The checksum covers everything after the header, so it can be checked
+// while decoding.
+struct CompressedBitstreamHeader {
+  static constexpr char MAGIC[8] = {'V', 'F', 'P', 'G', 'A', 'C', 'B', '\0'};
+  static constexpr uint32_t VERSION = 1;
+
+  char magic[8];
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  uint32_t lut_inputs;
+  uint32_t bram_depth;
+  uint32_t dictionary_size;
+  uint64_t body_bytes;
+  uint64_t checksum; // FNV-1a of the body
+};
+
+class BitstreamCompression {
+public:
+  // Write a compressed bitstream. The stream must be seekable, since the
+  // header is patched once the body is written.
+  static bool encode(std::ostream &out, const Fabric &fabric);
+
+  // Decode a compressed bitstream (positioned at the header) frame by frame
+  // straight into a fresh configuration image of the fabric. On any error
+  // the fabric's previous configuration is restored.
+  static bool decode(std::istream &in, Fabric &fabric,
+                     bool verify_checksum = true);
+
+  // Lower-level halves of decode() for callers without a Fabric. The image
+  // must be laid out for the header's dimensions and hold the default state
+  // (Fabric::init_image).
+  static std::optional<CompressedBitstreamHeader> read_header(std::istream &in);
+  static bool decode_image(std::istream &in,
+                           const CompressedBitstreamHeader &header,
+                           std::byte *image, bool verify_checksum = true);
+};
+
+} // namespace vfpga
@@ -0,0 +1,80 @@
+#include "BitstreamDiff.hpp"
+#include "../utils/Hash.hpp"
+#include <cstring>
+
+namespace vfpga {
+
+namespace {
+
+uint64_t frame_digest(const Fabric::Frame &frame) {
+  uint64_t h = fast_hash(frame.lut_masks.data(), frame.lut_masks.size_bytes());
+  h = fast_hash(frame.dff_init.data(), frame.dff_init.size_bytes(), h);
+  h = fast_hash(frame.mux_selects.data(), frame.mux_selects.size_bytes(), h);
+  return fast_hash(frame.bram_init.data(), frame.bram_init.size_bytes(), h);
+}
+
+// Byte comparison of one frame whose digests differ
+void diff_frame(int x, const Fabric::Frame &a, const Fabric::Frame &b,
+                std::vector<ConfigDiff::TileDiff> &out) {
+  constexpr size_t pins = Fabric::LUT_INPUTS;
+  for (size_t y = 0; y < a.lut_masks.size(); ++y) {
+    ConfigDiff::TileDiff d{x, static_cast<int>(y)};
+    d.lut_mask = a.lut_masks[y] != b.lut_masks[y];
+    d.dff_init = a.dff_init[y] != b.dff_init[y];
+    d.routing = std::memcmp(&a.mux_selects[y * pins], &b.mux_selects[y * pins],
+                            pins * sizeof(int32_t)) != 0;
+    if (!a.bram_init.empty()) {
+      size_t word = y * Fabric::BRAM_DEPTH;
+      d.bram_init = std::memcmp(&a.bram_init[word], &b.bram_init[word],
+                                Fabric::BRAM_DEPTH) != 0;
+    }
+    if (d.lut_mask || d.dff_init || d.routing || d.bram_init)
+      out.push_back(d);
+  }
+}
+
+} // namespace
+
+std::vector<uint64_t>
+BitstreamDiff::frame_digests(const ConfigSnapshot &snapshot) {
+  std::vector<uint64_t> digests(snapshot.width);
+  for (int x = 0; x < snapshot.width; ++x)
+    digests[x] = frame_digest(snapshot.frame(x));
+  return digests;
+}
+
+ConfigDiff BitstreamDiff::compare(const ConfigSnapshot &a,
+                                  const ConfigSnapshot &b) {
+  if (a.width != b.width || a.height != b.height) {
+    ConfigDiff diff;
+    diff.compatible = false;
+    return diff;
+  }
+  return compare(a, frame_digests(a), b);
+}
+
+ConfigDiff BitstreamDiff::compare(const ConfigSnapshot &a,
+                                  const std::vector<uint64_t> &a_digests,
+                                  const ConfigSnapshot &b) {
+  ConfigDiff diff;
+  if (a.width != b.width || a.height != b.height ||
+      a_digests.size() != static_cast<size_t>(a.width)) {
+    diff.compatible = false;
+    return diff;
+  }
+
+  for (int x = 0; x < a.width; ++x) {
+    Fabric::Frame fb = b.frame(x);
+    ++diff.frames_compared;
+    if (frame_digest(fb) == a_digests[x])
+      continue;
+
+    size_t before = diff.tiles.size();
+    diff_frame(x, a.frame(x), fb, diff.tiles);
+    if (diff.tiles.size() != before)
+      ++diff.frames_different;
+  }
+  return diff;
+}
+
+} // namespace vfpga
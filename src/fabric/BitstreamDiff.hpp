@@ -0,0 +1,40 @@
+#pragma once
+
+#include "BitstreamLoader.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace vfpga {
+
+struct ConfigDiff {
+  struct TileDiff {
+    int x, y;
+    bool lut_mask = false;
+    bool dff_init = false;
+    bool routing = false;
+    bool bram_init = false;
+  };
+
+  bool compatible = true; // False if the dimensions differ
+  size_t frames_compared = 0;
+  size_t frames_different = 0;
+  std::vector<TileDiff> tiles; // Column-major order
+
+  bool identical() const { return compatible && frames_different == 0; }
+};
+
+// Frame-wise comparison of two configurations. Each frame is hashed first
+// and only frames whose digests differ are compared byte by byte, so the
+// cost is dominated by one pass of a fast word-wise hash. Digests can be
+// computed once for a reference and reused against many readbacks.
+class BitstreamDiff {
+public:
+  static std::vector<uint64_t> frame_digests(const ConfigSnapshot &snapshot);
+
+  static ConfigDiff compare(const ConfigSnapshot &a, const ConfigSnapshot &b);
+  static ConfigDiff compare(const ConfigSnapshot &a,
+                            const std::vector<uint64_t> &a_digests,
+                            const ConfigSnapshot &b);
+};
+
+} // namespace vfpga
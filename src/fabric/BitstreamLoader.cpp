@@ -1,33 +1,390 @@
 #include "BitstreamLoader.hpp"
+#include "BitstreamCompression.hpp"
+#include "../utils/Hash.hpp"
+#include "../utils/MappedFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
 
 namespace vfpga {
 
-bool BitstreamLoader::load(const std::string &filename, Fabric &fabric) {
-  std::ifstream file(filename, std::ios::binary);
-  if (!file.is_open()) {
-    std::cerr << "Failed to open bitstream file: " << filename << std::endl;
+namespace {
+
+// Header describing a fabric's layout; the checksum is left to the caller
+BitstreamHeader make_header(int width, int height) {
+  Fabric::ConfigLayout layout = Fabric::layout_for(width, height);
+
+  BitstreamHeader h{};
+  std::memcpy(h.magic, BitstreamHeader::MAGIC, sizeof(h.magic));
+  h.version = BitstreamHeader::VERSION;
+  h.header_size = BitstreamHeader::SIZE;
+  h.width = width;
+  h.height = height;
+  h.lut_inputs = Fabric::LUT_INPUTS;
+  h.bram_depth = Fabric::BRAM_DEPTH;
+  h.payload_bytes = layout.total_bytes;
+  h.sections[BitstreamHeader::LUT] = {layout.lut_offset, layout.lut_bytes};
+  h.sections[BitstreamHeader::DFF] = {layout.dff_offset, layout.dff_bytes};
+  h.sections[BitstreamHeader::ROUTING] = {layout.mux_offset, layout.mux_bytes};
+  h.sections[BitstreamHeader::BRAM_INIT] = {layout.bram_offset,
+                                            layout.bram_bytes};
+  return h;
+}
+
+// Everything except the checksum must match the expected layout
+bool compatible(const BitstreamHeader &file, const BitstreamHeader &expected) {
+  return std::memcmp(file.magic, expected.magic, sizeof(file.magic)) == 0 &&
+         file.version == expected.version &&
+         file.header_size == expected.header_size &&
+         file.width == expected.width && file.height == expected.height &&
+         file.lut_inputs == expected.lut_inputs &&
+         file.bram_depth == expected.bram_depth &&
+         file.payload_bytes == expected.payload_bytes &&
+         std::memcmp(file.sections, expected.sections,
+                     sizeof(file.sections)) == 0;
+}
+
+bool is_compressed(const std::string &filename) {
+  std::ifstream in(filename, std::ios::binary);
+  char magic[8] = {};
+  return in.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, CompressedBitstreamHeader::MAGIC, sizeof(magic)) ==
+             0;
+}
+
+struct MappedBitstream {
+  std::shared_ptr<MappedFile> file;
+  BitstreamHeader header;
+  std::byte *payload;
+};
+
+// Map an uncompressed bitstream copy-on-write and validate it on its own
+std::optional<MappedBitstream> map_bitstream(const std::string &filename,
+                                             bool verify_checksum) {
+  MappedBitstream m;
+  try {
+    m.file = std::make_shared<MappedFile>(filename,
+                                          MappedFile::Mode::COPY_ON_WRITE);
+  } catch (const std::exception &e) {
+    std::cerr << "Failed to open bitstream file: " << e.what() << std::endl;
+    return std::nullopt;
+  }
+
+  if (m.file->size() < BitstreamHeader::SIZE) {
+    std::cerr << "Bitstream too short: " << filename << std::endl;
+    return std::nullopt;
+  }
+  std::memcpy(&m.header, m.file->data(), sizeof(m.header));
+
+  const BitstreamHeader &h = m.header;
+  if (h.width <= 0 || h.height <= 0 ||
+      !compatible(h, make_header(h.width, h.height)) ||
+      m.file->size() < BitstreamHeader::SIZE + h.payload_bytes) {
+    std::cerr << "Not a compatible bitstream: " << filename << std::endl;
+    return std::nullopt;
+  }
+
+  m.payload = m.file->data() + BitstreamHeader::SIZE;
+  if (verify_checksum && fast_hash(m.payload, h.payload_bytes) != h.checksum) {
+    std::cerr << "Bitstream checksum mismatch: " << filename << std::endl;
+    return std::nullopt;
+  }
+  return m;
+}
+
+PartialBitstreamHeader make_partial_header(const Fabric &fabric) {
+  PartialBitstreamHeader h{};
+  std::memcpy(h.magic, PartialBitstreamHeader::MAGIC, sizeof(h.magic));
+  h.version = PartialBitstreamHeader::VERSION;
+  h.width = fabric.width;
+  h.height = fabric.height;
+  h.lut_inputs = Fabric::LUT_INPUTS;
+  h.bram_depth = Fabric::BRAM_DEPTH;
+  return h;
+}
+
+// Frame slices in file order
+template <typename Fn> void for_each_slice(const Fabric::Frame &frame, Fn &&fn) {
+  fn(frame.lut_masks.data(), frame.lut_masks.size_bytes());
+  fn(frame.dff_init.data(), frame.dff_init.size_bytes());
+  fn(frame.mux_selects.data(), frame.mux_selects.size_bytes());
+  fn(frame.bram_init.data(), frame.bram_init.size_bytes());
+}
+
+// Write through a temporary file so readers never see partial bitstreams;
+// the random suffix keeps concurrent writers of one file apart
+template <typename Fn>
+bool write_file(const std::string &filename, Fn &&fill) {
+  static thread_local std::mt19937_64 rng(std::random_device{}());
+  std::string tmp_name = filename + ".tmp" + to_hex(rng());
+  {
+    std::ofstream file(tmp_name, std::ios::binary);
+    if (!file.is_open()) {
+      std::cerr << "Failed to open file for writing: " << filename << std::endl;
+      return false;
+    }
+    fill(file);
+    if (!file) {
+      std::cerr << "Failed to write bitstream: " << filename << std::endl;
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_name, filename, ec);
+  if (ec) {
+    std::cerr << "Failed to write bitstream: " << filename << ": "
+              << ec.message() << std::endl;
+    std::filesystem::remove(tmp_name, ec);
     return false;
   }
+  return true;
+}
+
+} // namespace
+
+bool BitstreamLoader::load(const std::string &filename, Fabric &fabric,
+                           bool verify_checksum) {
+  if (is_compressed(filename)) {
+    std::ifstream in(filename, std::ios::binary);
+    return BitstreamCompression::decode(in, fabric, verify_checksum);
+  }
 
-  // TODO: Implement actual loading logic
-  // For example, read header (width, height), verify match with fabric
-  // Read LUT masks and switch settings
+  auto mapped = map_bitstream(filename, verify_checksum);
+  if (!mapped)
+    return false;
+  if (mapped->header.width != fabric.width ||
+      mapped->header.height != fabric.height) {
+    std::cerr << "Bitstream " << filename << " (" << mapped->header.width
+              << "x" << mapped->header.height << ") does not match the "
+              << fabric.width << "x" << fabric.height << " fabric"
+              << std::endl;
+    return false;
+  }
 
-  std::cout << "Loading bitstream from " << filename << " (Placeholder)"
-            << std::endl;
+  fabric.attach_config(mapped->file, mapped->payload);
   return true;
 }
 
-bool BitstreamLoader::save(const std::string &filename, const Fabric &fabric) {
-  std::ofstream file(filename, std::ios::binary);
-  if (!file.is_open()) {
-    std::cerr << "Failed to open file for writing: " << filename << std::endl;
+std::optional<ConfigSnapshot> BitstreamLoader::read(const std::string &filename,
+                                                    bool verify_checksum) {
+  ConfigSnapshot snap;
+  if (is_compressed(filename)) {
+    std::ifstream in(filename, std::ios::binary);
+    auto header = BitstreamCompression::read_header(in);
+    if (!header)
+      return std::nullopt;
+    snap.width = header->width;
+    snap.height = header->height;
+    size_t bytes = Fabric::layout_for(snap.width, snap.height).total_bytes;
+    auto image = std::make_shared<std::byte[]>(bytes);
+    Fabric::init_image(image.get(), snap.width, snap.height);
+    if (!BitstreamCompression::decode_image(in, *header, image.get(),
+                                            verify_checksum))
+      return std::nullopt;
+    snap.image = image.get();
+    snap.owner = std::move(image);
+    return snap;
+  }
+
+  auto mapped = map_bitstream(filename, verify_checksum);
+  if (!mapped)
+    return std::nullopt;
+  snap.width = mapped->header.width;
+  snap.height = mapped->header.height;
+  snap.image = mapped->payload;
+  snap.owner = std::move(mapped->file);
+  return snap;
+}
+
+ConfigSnapshot BitstreamLoader::snapshot(const Fabric &fabric,
+                                         bool capture_state) {
+  auto source = fabric.config_image();
+  auto image = std::make_shared<std::byte[]>(source.size());
+  std::memcpy(image.get(), source.data(), source.size());
+
+  ConfigSnapshot snap;
+  snap.width = fabric.width;
+  snap.height = fabric.height;
+  snap.image = image.get();
+  snap.owner = std::move(image);
+
+  if (capture_state) {
+    // Like a readback capture: current register and memory contents
+    // replace their initial values
+    for (int x = 0; x < fabric.width; ++x) {
+      Fabric::Frame frame = snap.frame(x);
+      size_t bram_word = 0;
+      for (int y = 0; y < fabric.height; ++y) {
+        const Tile &tile = fabric.get_tile(x, y);
+        frame.dff_init[y] =
+            static_cast<uint8_t>(tile.dff.get_output().state);
+        if (tile.type != TileType::BRAM)
+          continue;
+        for (int addr = 0; addr < Fabric::BRAM_DEPTH; ++addr, ++bram_word) {
+          uint8_t word = 0;
+          if (addr < tile.bram.depth)
+            for (int bit = 0; bit < std::min(tile.bram.width, 8); ++bit)
+              if (tile.bram.memory[addr][bit].is_1())
+                word |= static_cast<uint8_t>(1u << bit);
+          frame.bram_init[bram_word] = word;
+        }
+      }
+    }
+  }
+  return snap;
+}
+
+std::vector<std::byte> BitstreamLoader::readback(const Fabric &fabric,
+                                                 bool capture_state) {
+  ConfigSnapshot snap = snapshot(fabric, capture_state);
+  BitstreamHeader header = make_header(snap.width, snap.height);
+  header.checksum = fast_hash(snap.image, header.payload_bytes);
+
+  std::vector<std::byte> bytes(BitstreamHeader::SIZE + header.payload_bytes);
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  std::memcpy(bytes.data() + BitstreamHeader::SIZE, snap.image,
+              header.payload_bytes);
+  return bytes;
+}
+
+bool BitstreamLoader::save(const std::string &filename, const Fabric &fabric,
+                           bool compress) {
+  // Truncating a file that is still mapped (possibly by this very fabric)
+  // would invalidate the mapping, hence the rename in write_file().
+  return write_file(filename, [&](std::ofstream &file) {
+    if (compress) {
+      BitstreamCompression::encode(file, fabric);
+      return;
+    }
+    auto image = fabric.config_image();
+    BitstreamHeader header = make_header(fabric.width, fabric.height);
+    header.checksum = fast_hash(image.data(), image.size());
+    char header_bytes[BitstreamHeader::SIZE] = {};
+    std::memcpy(header_bytes, &header, sizeof(header));
+    file.write(header_bytes, sizeof(header_bytes));
+    file.write(reinterpret_cast<const char *>(image.data()), image.size());
+  });
+}
+
+bool BitstreamLoader::save_partial(const std::string &filename,
+                                   const Fabric &fabric,
+                                   const std::vector<int> &columns) {
+  for (int x : columns) {
+    if (x < 0 || x >= fabric.width) {
+      std::cerr << "Frame " << x << " out of range for a " << fabric.width
+                << "-column fabric" << std::endl;
+      return false;
+    }
+  }
+
+  return write_file(filename, [&](std::ofstream &file) {
+    PartialBitstreamHeader header = make_partial_header(fabric);
+    header.num_frames = static_cast<uint32_t>(columns.size());
+
+    Hasher checksum;
+    for (int x : columns) {
+      Fabric::Frame frame = fabric.frame(x);
+      PartialBitstreamHeader::FrameHeader fh{
+          static_cast<uint32_t>(x), static_cast<uint32_t>(frame.bytes())};
+      checksum.update(fh);
+      for_each_slice(frame, [&](const void *data, size_t bytes) {
+        checksum.update(data, bytes);
+      });
+    }
+    header.checksum = checksum.digest();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (int x : columns) {
+      Fabric::Frame frame = fabric.frame(x);
+      PartialBitstreamHeader::FrameHeader fh{
+          static_cast<uint32_t>(x), static_cast<uint32_t>(frame.bytes())};
+      file.write(reinterpret_cast<const char *>(&fh), sizeof(fh));
+      for_each_slice(frame, [&](const void *data, size_t bytes) {
+        file.write(static_cast<const char *>(data), bytes);
+      });
+    }
+  });
+}
+
+bool BitstreamLoader::apply_partial(const std::string &filename,
+                                    Fabric &fabric) {
+  std::unique_ptr<MappedFile> file;
+  try {
+    file = std::make_unique<MappedFile>(filename);
+  } catch (const std::exception &e) {
+    std::cerr << "Failed to open bitstream file: " << e.what() << std::endl;
+    return false;
+  }
+
+  PartialBitstreamHeader header;
+  if (file->size() < sizeof(header)) {
+    std::cerr << "Partial bitstream too short: " << filename << std::endl;
+    return false;
+  }
+  std::memcpy(&header, file->data(), sizeof(header));
+
+  PartialBitstreamHeader expected = make_partial_header(fabric);
+  if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+      header.version != expected.version || header.width != expected.width ||
+      header.height != expected.height ||
+      header.lut_inputs != expected.lut_inputs ||
+      header.bram_depth != expected.bram_depth) {
+    std::cerr << "Partial bitstream " << filename << " (" << header.width
+              << "x" << header.height << ") does not match the "
+              << fabric.width << "x" << fabric.height << " fabric"
+              << std::endl;
+    return false;
+  }
+
+  const std::byte *body = file->data() + sizeof(header);
+  size_t body_bytes = file->size() - sizeof(header);
+  if (hash_bytes(body, body_bytes) != header.checksum) {
+    std::cerr << "Partial bitstream checksum mismatch: " << filename
+              << std::endl;
     return false;
   }
 
-  // TODO: Implement saving logic
-  std::cout << "Saving bitstream to " << filename << " (Placeholder)"
-            << std::endl;
+  // Validate every frame before touching the fabric
+  struct PendingFrame {
+    int column;
+    const std::byte *data;
+  };
+  std::vector<PendingFrame> frames;
+  size_t offset = 0;
+  for (uint32_t i = 0; i < header.num_frames; ++i) {
+    PartialBitstreamHeader::FrameHeader fh;
+    if (body_bytes - offset < sizeof(fh)) {
+      std::cerr << "Partial bitstream truncated: " << filename << std::endl;
+      return false;
+    }
+    std::memcpy(&fh, body + offset, sizeof(fh));
+    offset += sizeof(fh);
+
+    if (fh.column >= static_cast<uint32_t>(fabric.width) ||
+        fh.bytes != fabric.frame(static_cast<int>(fh.column)).bytes() ||
+        body_bytes - offset < fh.bytes) {
+      std::cerr << "Bad frame " << fh.column << " in partial bitstream "
+                << filename << std::endl;
+      return false;
+    }
+    frames.push_back({static_cast<int>(fh.column), body + offset});
+    offset += fh.bytes;
+  }
+
+  for (const auto &pending : frames) {
+    const std::byte *src = pending.data;
+    for_each_slice(fabric.frame(pending.column),
+                   [&](void *data, size_t bytes) {
+                     std::memcpy(data, src, bytes);
+                     src += bytes;
+                   });
+    fabric.reset_column(pending.column);
+    fabric.invalidate_column(pending.column);
+  }
   return true;
 }
 
@@ -1,22 +1,116 @@
 #pragma once
 
 #include "Fabric.hpp"
-#include <fstream>
-#include <iostream>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace vfpga {
 
+// On-disk bitstream: a fixed-size header followed by the fabric's
+// configuration image (Fabric::ConfigLayout) byte for byte. Because the
+// payload is the in-memory layout, a mapped file can back the fabric's
+// configuration planes directly.
+struct BitstreamHeader {
+  static constexpr char MAGIC[8] = {'V', 'F', 'P', 'G', 'A', 'B', 'S', '\0'};
+  static constexpr uint32_t VERSION = 2;
+  static constexpr size_t SIZE = 128; // Payload offset, keeps planes aligned
+
+  enum Section { LUT, DFF, ROUTING, BRAM_INIT, NUM_SECTIONS };
+  struct SectionEntry {
+    uint64_t offset; // Relative to the start of the payload
+    uint64_t bytes;
+  };
+
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  int32_t width;
+  int32_t height;
+  uint32_t lut_inputs;
+  uint32_t bram_depth;
+  uint64_t payload_bytes;
+  uint64_t checksum; // fast_hash (MurmurHash64A) of the payload
+  SectionEntry sections[NUM_SECTIONS];
+};
+static_assert(sizeof(BitstreamHeader) <= BitstreamHeader::SIZE);
+
+// Partial bitstream: a header followed by frames. Each frame is a
+// FrameHeader and the column's plane slices in plane order (LUT masks, DFF
+// init, mux selects, BRAM init); its size follows from the fabric.
+struct PartialBitstreamHeader {
+  static constexpr char MAGIC[8] = {'V', 'F', 'P', 'G', 'A', 'P', 'R', '\0'};
+  static constexpr uint32_t VERSION = 1;
+
+  struct FrameHeader {
+    uint32_t column;
+    uint32_t bytes;
+  };
+
+  char magic[8];
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  uint32_t lut_inputs;
+  uint32_t bram_depth;
+  uint32_t num_frames;
+  uint64_t checksum; // FNV-1a of everything after the header
+};
+
+// A configuration image with its fabric dimensions, e.g. read back from a
+// fabric or from a bitstream file without instantiating a Fabric
+struct ConfigSnapshot {
+  int width = 0;
+  int height = 0;
+  std::shared_ptr<void> owner; // Keeps 'image' alive
+  std::byte *image = nullptr;
+
+  Fabric::Frame frame(int x) const {
+    return Fabric::frame_of(image, width, height, x);
+  }
+};
+
 class BitstreamLoader {
 public:
-  // Load configuration from a file into the Fabric
-  // For now, this is a placeholder. Real implementation will parse a custom
-  // binary format.
-  static bool load(const std::string &filename, Fabric &fabric);
+  // Map a bitstream and point the fabric's configuration planes at it
+  // without copying. The mapping is copy-on-write, so the fabric can still
+  // be reconfigured in memory; the file itself is never modified.
+  // Compressed bitstreams are recognised by their magic and decoded in a
+  // streaming fashion instead (see BitstreamCompression).
+  // The fabric dimensions must match the bitstream. Verifying the checksum
+  // reads the whole payload once; skip it for pure mmap cost.
+  static bool load(const std::string &filename, Fabric &fabric,
+                   bool verify_checksum = true);
+
+  // Save the current configuration, optionally compressed. Compressed
+  // files are much smaller for sparse fabrics but cannot be mapped.
+  static bool save(const std::string &filename, const Fabric &fabric,
+                   bool compress = false);
+
+  // Read a bitstream file (either format) without configuring a fabric
+  static std::optional<ConfigSnapshot> read(const std::string &filename,
+                                            bool verify_checksum = true);
+
+  // Readback: copy of the fabric's configuration. With capture_state the
+  // DFF and BRAM init sections hold the current register and memory
+  // contents instead, as after a readback capture on real devices.
+  static ConfigSnapshot snapshot(const Fabric &fabric,
+                                 bool capture_state = false);
+  // The same, serialized as an uncompressed bitstream
+  static std::vector<std::byte> readback(const Fabric &fabric,
+                                         bool capture_state = false);
+
+  // Save the frames of the given columns as a partial bitstream
+  static bool save_partial(const std::string &filename, const Fabric &fabric,
+                           const std::vector<int> &columns);
 
-  // Save current configuration to a file
-  static bool save(const std::string &filename, const Fabric &fabric);
+  // Rewrite only the frames contained in a partial bitstream. The affected
+  // columns are reset from their new configuration and their part of the
+  // simulation schedule is recompiled; every other tile keeps its state.
+  // The file is validated completely before any frame is applied.
+  static bool apply_partial(const std::string &filename, Fabric &fabric);
 };
 
 } // namespace vfpga
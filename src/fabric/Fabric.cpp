@@ -1,28 +1,201 @@
 #include "Fabric.hpp"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 namespace vfpga {
 
+namespace {
+
+size_t align_up(size_t offset) {
+  constexpr size_t a = Fabric::ConfigLayout::ALIGNMENT;
+  return (offset + a - 1) / a * a;
+}
+
+// Evaluate a LUT truth table. Unknown (X/Z) inputs only make the result X
+// if the output actually depends on them; missing inputs read as 0.
+LogicVal evaluate_lut(uint16_t mask, const std::vector<LogicVal> &inputs) {
+  unsigned known = 0, index = 0;
+  for (size_t i = 0; i < Fabric::LUT_INPUTS; ++i) {
+    LogicVal v = i < inputs.size() ? inputs[i] : LogicVal(LogicState::L0);
+    if (v.is_1())
+      index |= 1u << i;
+    if (v.is_0() || v.is_1())
+      known |= 1u << i;
+  }
+
+  int result = -1;
+  for (unsigned i = 0; i < (1u << Fabric::LUT_INPUTS); ++i) {
+    if ((i & known) != index)
+      continue;
+    int bit = (mask >> i) & 1;
+    if (result >= 0 && bit != result)
+      return LogicState::LX;
+    result = bit;
+  }
+  return LogicVal(result == 1);
+}
+
+} // namespace
+
+Fabric::ConfigLayout Fabric::ConfigLayout::compute(size_t tiles,
+                                                   size_t bram_tiles) {
+  ConfigLayout l;
+  l.lut_bytes = tiles * sizeof(uint16_t);
+  l.dff_offset = align_up(l.lut_offset + l.lut_bytes);
+  l.dff_bytes = tiles * sizeof(uint8_t);
+  l.mux_offset = align_up(l.dff_offset + l.dff_bytes);
+  l.mux_bytes = tiles * LUT_INPUTS * sizeof(int32_t);
+  l.bram_offset = align_up(l.mux_offset + l.mux_bytes);
+  l.bram_bytes = bram_tiles * BRAM_DEPTH * sizeof(uint8_t);
+  l.total_bytes = align_up(l.bram_offset + l.bram_bytes);
+  return l;
+}
+
+TileType Fabric::column_type(int x) {
+  // Columnar Layout:
+  // Col 3: BRAM
+  // Col 7: DSP
+  // Rest: CLB (default)
+  if (x == 3)
+    return TileType::BRAM;
+  if (x == 7)
+    return TileType::DSP;
+  return TileType::CLB;
+}
+
+Fabric::ConfigLayout Fabric::layout_for(int width, int height) {
+  size_t bram_tiles = 0;
+  for (int x = 0; x < width; ++x)
+    if (column_type(x) == TileType::BRAM)
+      bram_tiles += static_cast<size_t>(height);
+  return ConfigLayout::compute(static_cast<size_t>(width) * height,
+                               bram_tiles);
+}
+
 Fabric::Fabric(int w, int h) : width(w), height(h) {
   grid.resize(width * height);
   for (int y = 0; y < height; ++y) {
     for (int x = 0; x < width; ++x) {
       grid[y * width + x] = Tile(x, y);
-      Tile &tile = grid[y * width + x];
-
-      // Columnar Layout:
-      // Col 3: BRAM
-      // Col 7: DSP
-      // Rest: CLB (default)
-      if (x == 3) {
-        tile.type = TileType::BRAM;
-      } else if (x == 7) {
-        tile.type = TileType::DSP;
-      } else {
-        tile.type = TileType::CLB;
-      }
+      grid[y * width + x].type = column_type(x);
     }
   }
+
+  bram_slots.assign(grid.size(), -1);
+  for (int x = 0; x < width; ++x)
+    for (int y = 0; y < height; ++y)
+      if (get_tile(x, y).type == TileType::BRAM)
+        bram_slots[config_index(x, y)] = static_cast<int>(num_bram_tiles++);
+
+  layout = layout_for(width, height);
+  clear_config();
+}
+
+Fabric::Fabric(const Fabric &other)
+    : width(other.width), height(other.height), grid(other.grid),
+      nets(other.nets), layout(other.layout), bram_slots(other.bram_slots),
+      num_bram_tiles(other.num_bram_tiles) {
+  // Copies always own their configuration, even if 'other' is mapped
+  allocate_config();
+  std::memcpy(config_base, other.config_base, layout.total_bytes);
+}
+
+Fabric &Fabric::operator=(const Fabric &other) {
+  if (this != &other)
+    *this = Fabric(other);
+  return *this;
+}
+
+void Fabric::allocate_config() {
+  auto image = std::make_shared<std::byte[]>(layout.total_bytes);
+  attach_config(image, image.get());
+}
+
+Fabric::ConfigImage Fabric::clear_config() {
+  ConfigImage previous{std::move(config_owner), config_base};
+  allocate_config(); // Also marks the whole schedule for compilation
+  init_image(config_base, width, height);
+  return previous;
+}
+
+void Fabric::init_image(std::byte *image, int width, int height) {
+  ConfigLayout l = layout_for(width, height);
+  std::memset(image, 0, l.total_bytes); // DFF init L0, muxes open, BRAM 0
+  auto *masks = reinterpret_cast<uint16_t *>(image + l.lut_offset);
+  std::fill(masks, masks + l.lut_bytes / sizeof(uint16_t), LUT_PASSTHROUGH);
+}
+
+void Fabric::attach_config(std::shared_ptr<void> owner, std::byte *image) {
+  config_owner = std::move(owner);
+  config_base = image;
+  size_t tiles = grid.size();
+  lut_masks = {reinterpret_cast<uint16_t *>(image + layout.lut_offset), tiles};
+  dff_init = {reinterpret_cast<uint8_t *>(image + layout.dff_offset), tiles};
+  mux_selects = {reinterpret_cast<int32_t *>(image + layout.mux_offset),
+                 tiles * LUT_INPUTS};
+  bram_init = {reinterpret_cast<uint8_t *>(image + layout.bram_offset),
+               num_bram_tiles * BRAM_DEPTH};
+  invalidate_schedule();
+}
+
+Fabric::Frame Fabric::frame(int x) const {
+  if (x < 0 || x >= width)
+    throw std::out_of_range("Frame index out of bounds");
+  return frame_of(config_base, width, height, x);
+}
+
+Fabric::Frame Fabric::frame_of(std::byte *image, int width, int height,
+                               int x) {
+  ConfigLayout l = layout_for(width, height);
+  size_t h = static_cast<size_t>(height);
+  size_t first = static_cast<size_t>(x) * h;
+
+  // BRAM slots are numbered column-major, so a column's are contiguous
+  size_t bram_first = 0;
+  for (int c = 0; c < x; ++c)
+    if (column_type(c) == TileType::BRAM)
+      bram_first += h;
+  size_t bram_count = column_type(x) == TileType::BRAM ? h : 0;
+
+  return {{reinterpret_cast<uint16_t *>(image + l.lut_offset) + first, h},
+          {reinterpret_cast<uint8_t *>(image + l.dff_offset) + first, h},
+          {reinterpret_cast<int32_t *>(image + l.mux_offset) +
+               first * LUT_INPUTS,
+           h * LUT_INPUTS},
+          {reinterpret_cast<uint8_t *>(image + l.bram_offset) +
+               bram_first * BRAM_DEPTH,
+           bram_count * BRAM_DEPTH}};
+}
+
+void Fabric::invalidate_schedule() {
+  schedule.resize(width);
+  column_dirty.assign(width, 1);
+  schedule_dirty = true;
+}
+
+void Fabric::invalidate_column(int x) {
+  column_dirty.at(x) = 1;
+  schedule_dirty = true;
+}
+
+void Fabric::compile_column(int x) {
+  auto &loads = schedule[x];
+  loads.clear();
+  for (int y = 0; y < height; ++y) {
+    const int32_t *selects = &mux_selects[config_index(x, y) * LUT_INPUTS];
+    for (int pin = 0; pin < LUT_INPUTS; ++pin) {
+      // Out-of-range sources are treated as open
+      if (selects[pin] <= MUX_OPEN ||
+          static_cast<size_t>(selects[pin]) > grid.size())
+        continue;
+      size_t src = grid_index(static_cast<size_t>(selects[pin] - 1));
+      loads.push_back({static_cast<uint32_t>(y * width + x),
+                       static_cast<uint32_t>(pin),
+                       static_cast<uint32_t>(src)});
+    }
+  }
+  column_dirty[x] = 0;
 }
 
 Tile &Fabric::get_tile(int x, int y) {
@@ -61,21 +234,30 @@ void Fabric::step() {
     }
   }
 
+  // Configured input muxes take precedence over magic routing. Only
+  // columns whose frames changed since the last step are recompiled.
+  if (schedule_dirty) {
+    for (int x = 0; x < width; ++x)
+      if (column_dirty[x])
+        compile_column(x);
+    schedule_dirty = false;
+  }
+  for (const auto &loads : schedule) {
+    for (const auto &load : loads) {
+      Tile &dst = grid[load.tile];
+      if (dst.inputs.size() <= load.pin)
+        dst.inputs.resize(load.pin + 1, default_val);
+      dst.inputs[load.pin] = output_of(grid[load.source]);
+    }
+  }
+
   // 2. Evaluate Combinational Logic & Setup Registers
   for (auto &tile : grid) {
     if (tile.type == TileType::CLB) {
       // Inputs -> LUT -> DFF.D
-      // Assuming checking inputs[0]...
-      // For simple testing: Just pass input[0] to DFF.D (Bypass LUT)
-      // Or process LUT if configured.
-      LogicVal d_in = LogicState::L0;
-      if (!tile.inputs.empty())
-        d_in = tile.inputs[0];
-
-      // LUT Eval (TODO: Real LUT)
-      // d_in = tile.lut.evaluate(tile.inputs);
-
-      tile.dff.set_d_in(d_in);
+      // An unconfigured LUT is a passthrough of input 0.
+      uint16_t mask = lut_masks[config_index(tile.x, tile.y)];
+      tile.dff.props(evaluate_lut(mask, tile.inputs));
 
     } else if (tile.type == TileType::BRAM) {
       // inputs -> BRAM inputs
@@ -96,17 +278,39 @@ void Fabric::step() {
 }
 
 void Fabric::reset() {
-  for (auto &tile : grid) {
-    tile.dff.props(LogicVal(LogicState::L0), LogicVal(LogicState::L0),
-                   LogicVal(LogicState::L1));
+  for (int x = 0; x < width; ++x)
+    reset_column(x);
+}
+
+void Fabric::reset_column(int x) {
+  for (int y = 0; y < height; ++y) {
+    Tile &tile = get_tile(x, y);
+    size_t index = config_index(x, y);
+    tile.dff.props(LogicVal(static_cast<LogicState>(dff_init[index] & 3)));
     tile.dff.update();
-    // Reset BRAM/DSP if needed
+    // Reset DSP if needed
+
+    int slot = bram_slot(index);
+    if (slot < 0)
+      continue;
+    const uint8_t *words = &bram_init[static_cast<size_t>(slot) * BRAM_DEPTH];
+    for (int addr = 0; addr < std::min(tile.bram.depth, BRAM_DEPTH); ++addr)
+      for (int bit = 0; bit < std::min(tile.bram.width, 8); ++bit)
+        tile.bram.memory[addr][bit] = LogicVal(((words[addr] >> bit) & 1) != 0);
   }
 }
 
+// Force the registered state of a tile (used for GPI switches)
+void Fabric::set_input(int x, int y, LogicVal value) {
+  get_tile(x, y).dff.set_state(value);
+}
+
 // Helper to get the "Registered" output of a tile
 LogicVal Fabric::get_output(int x, int y) const {
-  const Tile &tile = get_tile(x, y);
+  return output_of(get_tile(x, y));
+}
+
+LogicVal Fabric::output_of(const Tile &tile) const {
   if (tile.type == TileType::CLB) {
     return tile.dff.get_output();
   } else if (tile.type == TileType::BRAM) {
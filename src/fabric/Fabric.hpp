@@ -1,6 +1,10 @@
 #pragma once
 
 #include "Tile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
@@ -13,6 +17,10 @@ public:
   std::vector<Tile> grid;
 
   Fabric(int w, int h);
+  Fabric(const Fabric &other);
+  Fabric &operator=(const Fabric &other);
+  Fabric(Fabric &&) = default;
+  Fabric &operator=(Fabric &&) = default;
 
   struct Point {
     int x, y;
@@ -23,6 +31,105 @@ public:
   };
   std::vector<Connectivity> nets;
 
+  // A CLB site is CLB_LES vertically adjacent CLB tiles (one LE each) of a
+  // column sharing local interconnect; together they read at most
+  // CLB_INPUTS distinct routed nets. The placer moves whole sites.
+  static constexpr int CLB_LES = 4;
+  static constexpr int CLB_INPUTS = 10;
+  static constexpr double HOP_DELAY_PS = 50.0; // Routing delay per tile hop
+
+  // --- Configuration memory ---
+  //
+  // Stored as structure-of-arrays planes indexed by config_index(x, y).
+  // Tiles are numbered column-major, so each fabric column is one contiguous
+  // slice of every plane. The planes live in a single configuration image
+  // (see ConfigLayout) that is either owned by the fabric or mapped straight
+  // from a bitstream file by BitstreamLoader.
+  static constexpr int LUT_INPUTS = 4;
+  static constexpr uint16_t LUT_PASSTHROUGH = 0xAAAA; // Y = I0
+  static constexpr int32_t MUX_OPEN = 0;
+  static constexpr int BRAM_DEPTH = BRAM::DEFAULT_DEPTH;
+
+  std::span<uint16_t> lut_masks;  // Bit i = LUT output for input index i
+  std::span<uint8_t> dff_init;    // LogicState loaded by reset()
+  std::span<int32_t> mux_selects; // LUT_INPUTS per tile: source index + 1
+  std::span<uint8_t> bram_init;   // BRAM_DEPTH words per BRAM tile
+
+  // Byte offsets of the planes inside the configuration image. Sections are
+  // aligned so they can be used in place from a mapped file.
+  struct ConfigLayout {
+    static constexpr size_t ALIGNMENT = 64;
+
+    size_t lut_offset = 0, lut_bytes = 0;
+    size_t dff_offset = 0, dff_bytes = 0;
+    size_t mux_offset = 0, mux_bytes = 0;
+    size_t bram_offset = 0, bram_bytes = 0;
+    size_t total_bytes = 0;
+
+    static ConfigLayout compute(size_t tiles, size_t bram_tiles);
+  };
+
+  size_t config_index(int x, int y) const {
+    return static_cast<size_t>(x) * height + y;
+  }
+  // BRAM init slot of a tile, -1 if it is not a BRAM tile
+  int bram_slot(size_t config_index) const { return bram_slots[config_index]; }
+  size_t bram_tile_count() const { return num_bram_tiles; }
+
+  const ConfigLayout &config_layout() const { return layout; }
+  std::span<const std::byte> config_image() const {
+    return {config_base, layout.total_bytes};
+  }
+  std::span<std::byte> config_image() {
+    return {config_base, layout.total_bytes};
+  }
+
+  // Point the planes at an external image laid out as config_layout().
+  // 'owner' keeps the memory alive for as long as the fabric uses it.
+  void attach_config(std::shared_ptr<void> owner, std::byte *image);
+
+  // Switch to a fresh, owned image in the default (unconfigured) state.
+  // Returns the previous image so it can be restored with attach_config().
+  struct ConfigImage {
+    std::shared_ptr<void> owner;
+    std::byte *base;
+  };
+  ConfigImage clear_config();
+
+  // A frame is one column's slice of every plane, the unit of partial
+  // reconfiguration. Like the planes themselves, the spans are writable.
+  struct Frame {
+    std::span<uint16_t> lut_masks;
+    std::span<uint8_t> dff_init;
+    std::span<int32_t> mux_selects;
+    std::span<uint8_t> bram_init;
+
+    size_t bytes() const {
+      return lut_masks.size_bytes() + dff_init.size_bytes() +
+             mux_selects.size_bytes() + bram_init.size_bytes();
+    }
+  };
+  size_t num_frames() const { return static_cast<size_t>(width); }
+  Frame frame(int x) const;
+
+  // Layout and frames of any image for a width x height fabric, without
+  // building one (e.g. to inspect bitstream files)
+  static TileType column_type(int x);
+  static ConfigLayout layout_for(int width, int height);
+  static Frame frame_of(std::byte *image, int width, int height, int x);
+  // Write the default (unconfigured) state into an image
+  static void init_image(std::byte *image, int width, int height);
+
+  // The simulation schedule is compiled from mux_selects per column and
+  // recompiled lazily by step(). Call these after writing mux_selects
+  // directly; loaders and the Assembler already do.
+  void invalidate_schedule();
+  void invalidate_column(int x);
+
+  // Reset the DFFs and BRAMs of one column from its frame, leaving the rest
+  // of the fabric untouched
+  void reset_column(int x);
+
   // Accessors
   Tile &get_tile(int x, int y);
   const Tile &get_tile(int x, int y) const;
@@ -31,11 +138,35 @@ public:
 
   // Simulation Control
   void step();  // Advance clock
-  void reset(); // Reset all DFFs
+  void reset(); // Reset DFFs to dff_init and load BRAM contents
 
   // IO Interaction
   void set_input(int x, int y, LogicVal value);
   LogicVal get_output(int x, int y) const;
+
+private:
+  ConfigLayout layout;
+  std::vector<int> bram_slots;
+  size_t num_bram_tiles = 0;
+  std::shared_ptr<void> config_owner;
+  std::byte *config_base = nullptr;
+
+  // Compiled input mux connections, as grid indices
+  struct MuxLoad {
+    uint32_t tile;
+    uint32_t pin;
+    uint32_t source;
+  };
+  std::vector<std::vector<MuxLoad>> schedule; // Per column
+  std::vector<uint8_t> column_dirty;
+  bool schedule_dirty = true;
+
+  void allocate_config();
+  void compile_column(int x);
+  size_t grid_index(size_t config_index) const {
+    return (config_index % height) * width + config_index / height;
+  }
+  LogicVal output_of(const Tile &tile) const;
 };
 
 } // namespace vfpga
@@ -3,7 +3,6 @@
 #include "../primitives/BRAM.hpp"
 #include "../primitives/DFF.hpp"
 #include "../primitives/DSP.hpp"
-#include "../primitives/LUT.hpp"
 #include <memory>
 #include <vector>
 
@@ -16,8 +15,8 @@ struct Tile {
   TileType type = TileType::CLB;
 
   // Resources (Union-like usage, though simpler to just keep all members for
-  // now) CLB
-  LUT<4> lut; // 4-input LUT
+  // now). A CLB's LUT mask and input routing live in the fabric's
+  // configuration planes (Fabric::lut_masks, Fabric::mux_selects).
   DFF dff;
 
   // Hard Blocks (Optional)
@@ -25,10 +24,6 @@ struct Tile {
   BRAM bram;
   DSP dsp;
 
-  // Switch Matrix (simplified)
-  // We need a way to store routing configuration.
-  std::vector<int> input_mux_selects;
-
   // Simulation Methods
   LogicVal evaluate_combinational() {
     if (type == TileType::CLB) {
@@ -39,7 +34,7 @@ struct Tile {
       return LogicState::LX;
     } else if (type == TileType::DSP) {
       // DSP evaluation
-      return dsp.evaluate(LogicState::L1, LogicState::L1); // Placeholder
+      return LogicVal(dsp.evaluate(1, 1) != 0); // Placeholder
     } else if (type == TileType::BRAM) {
       // BRAM read (async)
       // return bram.read(addr);
@@ -62,11 +57,9 @@ struct Tile {
     inputs = new_inputs;
   }
 
-  Tile() : x(0), y(0) { input_mux_selects.resize(4, 0); }
+  Tile() : x(0), y(0) {}
 
-  Tile(int x_pos, int y_pos) : x(x_pos), y(y_pos) {
-    input_mux_selects.resize(4, 0); // 4 inputs for LUT
-  }
+  Tile(int x_pos, int y_pos) : x(x_pos), y(y_pos) {}
 };
 
 } // namespace vfpga
@@ -0,0 +1,227 @@
+#include "Flow.hpp"
+#include "../analysis/TimingAnalyzer.hpp"
+#include "../cad/Assembler.hpp"
+#include "../cad/Optimizer.hpp"
+#include "../cad/Packer.hpp"
+#include "../cad/Parser.hpp"
+#include "../cad/Placer.hpp"
+#include "../cad/Router.hpp"
+#include "../cad/TechMapper.hpp"
+#include "../fabric/Fabric.hpp"
+#include "FlowCache.hpp"
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+
+namespace vfpga {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+// The JSON DOM built by the parser is roughly this many times the file size
+constexpr size_t PARSE_BYTES_PER_FILE_BYTE = 10;
+
+} // namespace
+
+size_t Flow::estimate_memory(int fabric_width, int fabric_height,
+                             size_t netlist_file_bytes) {
+  size_t tiles = static_cast<size_t>(fabric_width) * fabric_height;
+
+  // Every tile carries a BRAM instance with depth x width storage
+  BRAM bram;
+  size_t bram_bytes =
+      bram.depth * (sizeof(std::vector<LogicVal>) + bram.width * sizeof(LogicVal));
+  size_t tile_bytes = sizeof(Tile) + bram_bytes;
+
+  // Router graph: one node per tile plus up to 4 neighbour edges
+  size_t routing_bytes = sizeof(RoutingNode) + 4 * sizeof(int);
+
+  // Configuration planes (upper bound: as if every tile were a BRAM)
+  size_t config_bytes = Fabric::ConfigLayout::compute(tiles, tiles).total_bytes;
+
+  return tiles * (tile_bytes + routing_bytes) + config_bytes +
+         netlist_file_bytes * PARSE_BYTES_PER_FILE_BYTE;
+}
+
+FlowReport Flow::run(const FlowOptions &options) {
+  FlowReport report;
+
+  try {
+    std::error_code ec;
+    size_t file_bytes = std::filesystem::file_size(options.netlist_path, ec);
+    if (ec) {
+      report.error = "cannot stat netlist: " + options.netlist_path;
+      return report;
+    }
+
+    report.estimated_memory_bytes = estimate_memory(
+        options.fabric_width, options.fabric_height, file_bytes);
+    if (options.memory_cap_bytes != 0 &&
+        report.estimated_memory_bytes > options.memory_cap_bytes) {
+      report.error = "memory cap exceeded (estimated " +
+                     std::to_string(report.estimated_memory_bytes) +
+                     " bytes, cap " + std::to_string(options.memory_cap_bytes) +
+                     " bytes)";
+      return report;
+    }
+
+    // Every stage is deterministic (placement given its seed), so each
+    // artifact is keyed by its inputs; the cache is off without a
+    // directory or when the netlist cannot be hashed.
+    std::optional<FlowCache> cache;
+    uint64_t netlist_key = 0, pack_key = 0;
+    if (!options.cache_dir.empty()) {
+      if (auto netlist_hash = FlowCache::hash_file(options.netlist_path)) {
+        cache.emplace(options.cache_dir);
+        netlist_key = FlowCache::netlist_key(*netlist_hash);
+        pack_key = FlowCache::pack_key(*netlist_hash, options.techmap,
+                                       options.optimize);
+      }
+    }
+
+    // 1. Parse + 2. Map + 3. Optimize + 4. Pack (a cached pack skips
+    // parsing entirely, and a cached netlist image replaces it). The cached
+    // image is the netlist as parsed, so it serves all pass settings.
+    std::vector<LogicBlock> blocks;
+    std::optional<FlowCache::PackArtifact> packed;
+    if (cache)
+      packed = cache->load_pack(pack_key);
+    if (packed) {
+      report.pack_cached = true;
+      report.num_cells = packed->num_cells;
+      report.cells_removed = packed->cells_removed;
+      blocks = std::move(packed->blocks);
+    } else {
+      auto start = Clock::now();
+      std::optional<Netlist> netlist;
+      if (cache)
+        netlist = cache->load_netlist(netlist_key);
+      report.netlist_cached = netlist.has_value();
+      if (!netlist)
+        netlist = Parser::from_file(options.netlist_path);
+      report.parse_ms = elapsed_ms(start);
+      if (!netlist) {
+        report.error = "parse failed";
+        return report;
+      }
+      if (cache && !report.netlist_cached)
+        cache->store_netlist(netlist_key, *netlist);
+      report.num_cells = netlist->num_cells();
+
+      if (options.techmap) {
+        start = Clock::now();
+        netlist = TechMapper::map(*netlist);
+        report.map_ms = elapsed_ms(start);
+      }
+
+      if (options.optimize) {
+        start = Clock::now();
+        OptimizerStats stats;
+        netlist = Optimizer::optimize(*netlist, {}, &stats);
+        report.optimize_ms = elapsed_ms(start);
+        report.cells_removed = stats.cells_removed();
+      }
+
+      start = Clock::now();
+      blocks = Packer::pack(*netlist);
+      report.pack_ms = elapsed_ms(start);
+      if (cache)
+        cache->store_pack(pack_key,
+                          {report.num_cells, report.cells_removed, blocks});
+    }
+    report.num_blocks = blocks.size();
+    ClusterStats cluster_stats;
+    std::vector<Cluster> clusters = Packer::cluster(blocks, {}, &cluster_stats);
+    report.num_clusters = clusters.size();
+    report.cluster_path_gain = cluster_stats.path_gain();
+
+    bool stage_cache = cache.has_value();
+    uint64_t place_key =
+        stage_cache ? FlowCache::place_key(pack_key, options.fabric_width,
+                                           options.fabric_height, options.seed)
+                    : 0;
+    uint64_t route_key = stage_cache ? FlowCache::route_key(place_key) : 0;
+
+    // 5. Place
+    Fabric fabric(options.fabric_width, options.fabric_height);
+    std::optional<std::map<int, std::pair<int, int>>> placement;
+    if (stage_cache)
+      placement = cache->load_placement(place_key);
+    if (placement) {
+      report.place_cached = true;
+    } else {
+      auto start = Clock::now();
+      placement = Placer::place(fabric, blocks, options.seed, clusters);
+      report.place_ms = elapsed_ms(start);
+      if (stage_cache)
+        cache->store_placement(place_key, *placement);
+    }
+    report.hpwl = Placer::calculate_cost(blocks, *placement);
+
+    // 6. Route
+    Router router;
+    std::optional<FlowCache::RouteArtifact> routed_nets;
+    if (stage_cache)
+      routed_nets = cache->load_route(route_key);
+    if (routed_nets) {
+      report.route_cached = true;
+      router.nets = std::move(routed_nets->nets);
+      router.iterations = routed_nets->iterations;
+    } else {
+      auto start = Clock::now();
+      bool routed = router.route(fabric, blocks, *placement);
+      report.route_ms = elapsed_ms(start);
+      if (!routed) {
+        report.routing_iterations = router.iterations;
+        report.error = "routing failed";
+        return report;
+      }
+      if (stage_cache)
+        cache->store_route(route_key, {router.iterations, router.nets});
+    }
+    report.routing_iterations = router.iterations;
+
+    // 7. Timing
+    auto start = Clock::now();
+    TimingAnalyzer analyzer(fabric, router);
+    report.fmax_mhz = analyzer.analyze().fmax_mhz;
+    report.timing_ms = elapsed_ms(start);
+
+    // 8. Simulate: configure LUT masks and input muxes, and drive the
+    // fabric with the routed connectivity
+    Assembler::assemble(fabric, blocks, *placement);
+    for (const auto &net : router.nets) {
+      Fabric::Connectivity conn;
+      conn.source = {net.source.x, net.source.y};
+      for (const auto &sink : net.sinks)
+        conn.sinks.push_back({sink.x, sink.y});
+      fabric.nets.push_back(conn);
+    }
+    fabric.reset();
+    start = Clock::now();
+    for (int cycle = 0; cycle < options.sim_cycles; ++cycle)
+      fabric.step();
+    report.sim_ms = elapsed_ms(start);
+    if (report.sim_ms > 0)
+      report.sim_cycles_per_sec = options.sim_cycles * 1000.0 / report.sim_ms;
+    for (const auto &block : blocks)
+      if (block.use_dff) {
+        auto [x, y] = placement->at(block.id);
+        report.sim_registers_high += fabric.get_output(x, y).is_1();
+      }
+
+    report.success = true;
+  } catch (const std::exception &e) {
+    report.error = e.what();
+  }
+
+  return report;
+}
+
+} // namespace vfpga
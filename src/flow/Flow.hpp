@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vfpga {
+
+struct FlowOptions {
+  std::string netlist_path;
+  int fabric_width = 10;
+  int fabric_height = 10;
+  uint32_t seed = 1;           // Placer seed (Placer::DEFAULT_SEED)
+  int sim_cycles = 1000;       // Clock cycles to simulate after routing
+  size_t memory_cap_bytes = 0; // Per-job memory budget, 0 = unlimited
+  std::string cache_dir;       // Artifact cache directory, empty = disabled
+  bool techmap = true;         // Map gates and narrow LUTs into 4-LUTs
+  bool optimize = true;        // Logic optimization before packing
+};
+
+// Result of one parse -> map -> optimize -> pack -> place -> route -> time -> simulate run
+struct FlowReport {
+  bool success = false;
+  std::string error;
+
+  // Wall time per stage in milliseconds
+  double parse_ms = 0.0;
+  double map_ms = 0.0;
+  double optimize_ms = 0.0;
+  double pack_ms = 0.0;
+  double place_ms = 0.0;
+  double route_ms = 0.0;
+  double timing_ms = 0.0;
+  double sim_ms = 0.0;
+
+  size_t num_cells = 0;     // As parsed
+  size_t cells_removed = 0; // By the optimizer
+  size_t num_blocks = 0;
+  size_t num_clusters = 0;        // Placement units (Packer::cluster)
+  double cluster_path_gain = 0.0; // Estimated critical path saved (fraction)
+  double hpwl = 0.0;
+  int routing_iterations = 0;
+  double fmax_mhz = 0.0;
+  double sim_cycles_per_sec = 0.0;
+  size_t sim_registers_high = 0; // Register outputs at 1 after simulating
+  size_t estimated_memory_bytes = 0;
+
+  // Stages whose artifacts were loaded from the cache instead of recomputed
+  bool netlist_cached = false;
+  bool pack_cached = false;
+  bool place_cached = false;
+  bool route_cached = false;
+};
+
+class Flow {
+public:
+  // Run the full flow. Never throws: failures are reported in the result.
+  static FlowReport run(const FlowOptions &options);
+
+  // Upper-bound estimate of the memory a run needs, used to enforce
+  // FlowOptions::memory_cap_bytes before anything large is allocated.
+  static size_t estimate_memory(int fabric_width, int fabric_height,
+                                size_t netlist_file_bytes);
+};
+
+} // namespace vfpga
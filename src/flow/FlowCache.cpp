@@ -0,0 +1,302 @@
+#include "FlowCache.hpp"
+#include "../utils/BinaryIO.hpp"
+#include "../utils/Hash.hpp"
+#include "../utils/MappedFile.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace vfpga {
+
+namespace {
+
+constexpr uint32_t NETLIST_MAGIC = 0x4E504656; // "VFPN"
+constexpr uint32_t PACK_MAGIC = 0x4B504656;  // "VFPK"
+constexpr uint32_t PLACE_MAGIC = 0x4C504656; // "VFPL"
+constexpr uint32_t ROUTE_MAGIC = 0x52504656; // "VFPR"
+
+// Bump when a stage's algorithm or artifact layout changes so stale cache
+// entries are never reused.
+constexpr uint32_t NETLIST_VERSION = 2;
+constexpr uint32_t PACK_VERSION = 6;
+constexpr uint32_t PLACE_VERSION = 7;
+constexpr uint32_t ROUTE_VERSION = 1;
+
+void write_header(BinaryWriter &w, uint32_t magic, uint32_t version,
+                  uint64_t key) {
+  w.write(magic);
+  w.write(version);
+  w.write(key);
+}
+
+// For BinaryReader and MemoryReader
+template <typename Reader>
+void check_header(Reader &r, uint32_t magic, uint32_t version,
+                  uint64_t key) {
+  if (r.template read<uint32_t>() != magic ||
+      r.template read<uint32_t>() != version ||
+      r.template read<uint64_t>() != key)
+    throw std::runtime_error("stale or foreign cache entry");
+}
+
+// Write through a temporary file so readers never see partial artifacts
+template <typename Fn>
+bool write_atomically(const std::string &path, Fn &&fill) {
+  static thread_local std::mt19937_64 rng(std::random_device{}());
+  std::string tmp_path = path + ".tmp" + to_hex(rng());
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    if (!file.is_open())
+      return false;
+    BinaryWriter w(file);
+    fill(w);
+    if (!w.good())
+      return false;
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+template <typename T, typename Fn>
+std::optional<T> read_cached(const std::string &path, Fn &&parse) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return std::nullopt; // Plain cache miss
+  try {
+    BinaryReader r(file);
+    return parse(r);
+  } catch (const std::exception &e) {
+    std::cerr << "Warning: ignoring cache entry " << path << ": " << e.what()
+              << std::endl;
+    return std::nullopt;
+  }
+}
+
+// Like read_cached(), for large artifacts: the file is mapped and arrays are
+// copied straight out of the mapping
+template <typename T, typename Fn>
+std::optional<T> read_mapped(const std::string &path, Fn &&parse) {
+  std::error_code ec;
+  if (!std::filesystem::exists(path, ec))
+    return std::nullopt; // Plain cache miss
+  try {
+    MappedFile file(path);
+    MemoryReader r(file.data(), file.size());
+    return parse(r);
+  } catch (const std::exception &e) {
+    std::cerr << "Warning: ignoring cache entry " << path << ": " << e.what()
+              << std::endl;
+    return std::nullopt;
+  }
+}
+
+} // namespace
+
+FlowCache::FlowCache(std::string dir) : directory(std::move(dir)) {
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+}
+
+std::string FlowCache::path_for(uint64_t key, const char *extension) const {
+  return (std::filesystem::path(directory) / (to_hex(key) + extension))
+      .string();
+}
+
+std::optional<uint64_t> FlowCache::hash_file(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return std::nullopt;
+
+  Hasher h;
+  std::vector<char> buffer(1 << 16);
+  while (file) {
+    file.read(buffer.data(), buffer.size());
+    h.update(buffer.data(), static_cast<size_t>(file.gcount()));
+  }
+  return h.digest();
+}
+
+uint64_t FlowCache::netlist_key(uint64_t netlist_hash) {
+  return Hasher().update(NETLIST_VERSION).update(netlist_hash).digest();
+}
+
+uint64_t FlowCache::pack_key(uint64_t netlist_hash, bool mapped,
+                             bool optimized) {
+  return Hasher()
+      .update(PACK_VERSION)
+      .update(netlist_hash)
+      .update(mapped)
+      .update(optimized)
+      .digest();
+}
+
+uint64_t FlowCache::place_key(uint64_t pack_key, int fabric_width,
+                              int fabric_height, uint32_t seed) {
+  return Hasher()
+      .update(PLACE_VERSION)
+      .update(pack_key)
+      .update(fabric_width)
+      .update(fabric_height)
+      .update(seed)
+      .digest();
+}
+
+uint64_t FlowCache::route_key(uint64_t place_key) {
+  return Hasher().update(ROUTE_VERSION).update(place_key).digest();
+}
+
+// --- Parsed netlist ---
+
+bool FlowCache::store_netlist(uint64_t key, const Netlist &netlist) const {
+  return write_atomically(path_for(key, ".netlist"), [&](BinaryWriter &w) {
+    write_header(w, NETLIST_MAGIC, NETLIST_VERSION, key);
+    netlist.write(w);
+  });
+}
+
+std::optional<Netlist> FlowCache::load_netlist(uint64_t key) const {
+  return read_mapped<Netlist>(path_for(key, ".netlist"), [&](MemoryReader &r) {
+    check_header(r, NETLIST_MAGIC, NETLIST_VERSION, key);
+    return Netlist::read(r);
+  });
+}
+
+// --- Packed blocks ---
+
+bool FlowCache::store_pack(uint64_t key, const PackArtifact &artifact) const {
+  return write_atomically(path_for(key, ".pack"), [&](BinaryWriter &w) {
+    write_header(w, PACK_MAGIC, PACK_VERSION, key);
+    w.write<uint64_t>(artifact.num_cells);
+    w.write<uint64_t>(artifact.cells_removed);
+    w.write<uint64_t>(artifact.blocks.size());
+    for (const auto &b : artifact.blocks) {
+      w.write<int32_t>(b.id);
+      w.write_string(b.name);
+      w.write<uint8_t>(static_cast<uint8_t>(b.type));
+      w.write<uint8_t>(b.use_lut);
+      w.write<uint8_t>(b.use_dff);
+      w.write<uint16_t>(b.lut_mask);
+      w.write_vector(b.input_nets);
+      w.write<NetId>(b.output_net);
+      w.write<NetId>(b.clock_net);
+    }
+  });
+}
+
+std::optional<FlowCache::PackArtifact> FlowCache::load_pack(uint64_t key) const {
+  return read_cached<PackArtifact>(path_for(key, ".pack"), [&](BinaryReader &r) {
+    check_header(r, PACK_MAGIC, PACK_VERSION, key);
+    PackArtifact artifact;
+    artifact.num_cells = r.read<uint64_t>();
+    artifact.cells_removed = r.read<uint64_t>();
+    uint64_t count = r.read<uint64_t>();
+    for (uint64_t i = 0; i < count; ++i) {
+      int id = r.read<int32_t>();
+      LogicBlock b(id, r.read_string());
+      b.type = static_cast<TileType>(r.read<uint8_t>());
+      b.use_lut = r.read<uint8_t>();
+      b.use_dff = r.read<uint8_t>();
+      b.lut_mask = r.read<uint16_t>();
+      b.input_nets = r.read_vector<NetId>();
+      b.output_net = r.read<NetId>();
+      b.clock_net = r.read<NetId>();
+      artifact.blocks.push_back(std::move(b));
+    }
+    return artifact;
+  });
+}
+
+// --- Placement ---
+
+bool FlowCache::store_placement(
+    uint64_t key, const std::map<int, std::pair<int, int>> &placement) const {
+  return write_atomically(path_for(key, ".place"), [&](BinaryWriter &w) {
+    write_header(w, PLACE_MAGIC, PLACE_VERSION, key);
+    w.write<uint64_t>(placement.size());
+    for (const auto &[id, pos] : placement) {
+      w.write<int32_t>(id);
+      w.write<int32_t>(pos.first);
+      w.write<int32_t>(pos.second);
+    }
+  });
+}
+
+std::optional<std::map<int, std::pair<int, int>>>
+FlowCache::load_placement(uint64_t key) const {
+  using Placement = std::map<int, std::pair<int, int>>;
+  return read_cached<Placement>(path_for(key, ".place"), [&](BinaryReader &r) {
+    check_header(r, PLACE_MAGIC, PLACE_VERSION, key);
+    Placement placement;
+    uint64_t count = r.read<uint64_t>();
+    for (uint64_t i = 0; i < count; ++i) {
+      int id = r.read<int32_t>();
+      int x = r.read<int32_t>();
+      int y = r.read<int32_t>();
+      placement[id] = {x, y};
+    }
+    return placement;
+  });
+}
+
+// --- Routing ---
+
+namespace {
+
+void write_points(BinaryWriter &w, const std::vector<Router::Net::Point> &pts) {
+  w.write<uint32_t>(static_cast<uint32_t>(pts.size()));
+  for (const auto &p : pts) {
+    w.write<int32_t>(p.x);
+    w.write<int32_t>(p.y);
+  }
+}
+
+std::vector<Router::Net::Point> read_points(BinaryReader &r) {
+  std::vector<Router::Net::Point> pts(r.read<uint32_t>());
+  for (auto &p : pts) {
+    p.x = r.read<int32_t>();
+    p.y = r.read<int32_t>();
+  }
+  return pts;
+}
+
+} // namespace
+
+bool FlowCache::store_route(uint64_t key, const RouteArtifact &artifact) const {
+  return write_atomically(path_for(key, ".route"), [&](BinaryWriter &w) {
+    write_header(w, ROUTE_MAGIC, ROUTE_VERSION, key);
+    w.write<int32_t>(artifact.iterations);
+    w.write<uint64_t>(artifact.nets.size());
+    for (const auto &net : artifact.nets) {
+      w.write<int32_t>(net.source.x);
+      w.write<int32_t>(net.source.y);
+      write_points(w, net.sinks);
+      write_points(w, net.path);
+    }
+  });
+}
+
+std::optional<FlowCache::RouteArtifact> FlowCache::load_route(uint64_t key) const {
+  return read_cached<RouteArtifact>(path_for(key, ".route"), [&](BinaryReader &r) {
+    check_header(r, ROUTE_MAGIC, ROUTE_VERSION, key);
+    RouteArtifact artifact;
+    artifact.iterations = r.read<int32_t>();
+    uint64_t count = r.read<uint64_t>();
+    for (uint64_t i = 0; i < count; ++i) {
+      Router::Net net;
+      net.source.x = r.read<int32_t>();
+      net.source.y = r.read<int32_t>();
+      net.sinks = read_points(r);
+      net.path = read_points(r);
+      artifact.nets.push_back(std::move(net));
+    }
+    return artifact;
+  });
+}
+
+} // namespace vfpga
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../cad/LogicBlock.hpp"
+#include "../cad/Netlist.hpp"
+#include "../cad/Router.hpp"
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vfpga {
+
+// On-disk cache of intermediate CAD artifacts, keyed by content hashes.
+// Each stage key chains the previous stage's key with that stage's options,
+// so changing e.g. the placer seed invalidates placement and routing but
+// reuses the packed netlist.
+//
+// Files are written to a temporary name and renamed into place, so several
+// processes (or vfpga_batch jobs) can share one cache directory.
+class FlowCache {
+public:
+  explicit FlowCache(std::string directory);
+
+  // Hash of a file's contents; nullopt if it cannot be read
+  static std::optional<uint64_t> hash_file(const std::string &path);
+
+  // Stage keys
+  static uint64_t netlist_key(uint64_t netlist_hash);
+  static uint64_t pack_key(uint64_t netlist_hash, bool mapped, bool optimized);
+  static uint64_t place_key(uint64_t pack_key, int fabric_width,
+                            int fabric_height, uint32_t seed);
+  static uint64_t route_key(uint64_t place_key);
+
+  struct PackArtifact {
+    size_t num_cells = 0;
+    size_t cells_removed = 0;
+    std::vector<LogicBlock> blocks;
+  };
+  struct RouteArtifact {
+    int iterations = 0;
+    std::vector<Router::Net> nets;
+  };
+
+  // The parsed netlist, as a binary image that is memory-mapped on load
+  std::optional<Netlist> load_netlist(uint64_t key) const;
+  bool store_netlist(uint64_t key, const Netlist &netlist) const;
+
+  std::optional<PackArtifact> load_pack(uint64_t key) const;
+  bool store_pack(uint64_t key, const PackArtifact &artifact) const;
+
+  std::optional<std::map<int, std::pair<int, int>>>
+  load_placement(uint64_t key) const;
+  bool store_placement(uint64_t key,
+                       const std::map<int, std::pair<int, int>> &placement) const;
+
+  std::optional<RouteArtifact> load_route(uint64_t key) const;
+  bool store_route(uint64_t key, const RouteArtifact &artifact) const;
+
+private:
+  std::string directory;
+
+  std::string path_for(uint64_t key, const char *extension) const;
+};
+
+} // namespace vfpga
@@ -0,0 +1,477 @@
+#include "DesignGenerator.hpp"
+#include "YosysJsonWriter.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace vfpga {
+
+namespace {
+
+using Writer = YosysJsonWriter;
+
+// Common LUT masks (bit i = output for input index i, input 0 is the LSB)
+constexpr uint64_t MASK_NOT1 = 0x1;
+constexpr uint64_t MASK_AND2 = 0x8;
+constexpr uint64_t MASK_XOR2 = 0x6;
+constexpr uint64_t MASK_XOR3 = 0x96;
+constexpr uint64_t MASK_MAJ3 = 0xE8;
+
+// Odd/even parity over 'width' inputs
+uint64_t parity_mask(int width, bool invert) {
+  uint64_t mask = 0;
+  for (uint64_t i = 0; i < (uint64_t{1} << width); ++i) {
+    bool odd = std::popcount(i) & 1;
+    if (odd != invert)
+      mask |= uint64_t{1} << i;
+  }
+  return mask;
+}
+
+// Allocates nets and writes primitive cells with unique names
+class Builder {
+public:
+  Builder(std::ostream &out, const std::string &module)
+      : writer(out, module) {}
+
+  int net() { return next_net++; }
+  std::vector<int> nets(size_t n) {
+    std::vector<int> bits(n);
+    for (auto &b : bits)
+      b = net();
+    return bits;
+  }
+
+  void input(const std::string &name, const std::vector<int> &bits) {
+    writer.add_port(name, false, bits);
+  }
+  void output(const std::string &name, const std::vector<int> &bits) {
+    writer.add_port(name, true, bits);
+  }
+
+  void lut_to(uint64_t mask, const std::vector<int> &inputs, int out) {
+    int width = static_cast<int>(inputs.size());
+    writer.add_cell("lut_" + std::to_string(luts++), "$lut",
+                    {Writer::int_param("WIDTH", width),
+                     Writer::lut_param(mask, width)},
+                    {{"A", false, inputs}, {"Y", true, {out}}});
+  }
+  int lut(uint64_t mask, const std::vector<int> &inputs) {
+    int out = net();
+    lut_to(mask, inputs, out);
+    return out;
+  }
+
+  void dff_to(int clk, int d, int q) {
+    writer.add_cell("dff_" + std::to_string(dffs++), "DFF", {},
+                    {{"C", false, {clk}}, {"D", false, {d}}, {"Q", true, {q}}});
+  }
+  int dff(int clk, int d) {
+    int q = net();
+    dff_to(clk, d, q);
+    return q;
+  }
+
+  void mul_to(const std::vector<int> &a, const std::vector<int> &b,
+              const std::vector<int> &y) {
+    writer.add_cell("mul_" + std::to_string(muls++), "$mul",
+                    {Writer::int_param("A_SIGNED", 0),
+                     Writer::int_param("A_WIDTH", a.size()),
+                     Writer::int_param("B_SIGNED", 0),
+                     Writer::int_param("B_WIDTH", b.size()),
+                     Writer::int_param("Y_WIDTH", y.size())},
+                    {{"A", false, a}, {"B", false, b}, {"Y", true, y}});
+  }
+
+  void bram_to(int clk, const std::vector<int> &addr,
+               const std::vector<int> &data, int we,
+               const std::vector<int> &out) {
+    writer.add_cell("bram_" + std::to_string(brams++), "BRAM",
+                    {Writer::int_param("ABITS", addr.size()),
+                     Writer::int_param("WIDTH", data.size())},
+                    {{"CLK", false, {clk}},
+                     {"ADDR", false, addr},
+                     {"DATA", false, data},
+                     {"WE", false, {we}},
+                     {"OUT", true, out}});
+  }
+
+  // Sum of two bit vectors (LSB first). A -1 entry means "no bit here",
+  // which lets callers add vectors of different lengths without emitting
+  // cells for constant zeros. Returns max(len) + 1 bits (top may be -1).
+  std::vector<int> add(const std::vector<int> &x, const std::vector<int> &y) {
+    size_t n = std::max(x.size(), y.size());
+    std::vector<int> sum(n + 1, -1);
+    int carry = -1;
+    for (size_t i = 0; i < n; ++i) {
+      std::vector<int> ops;
+      if (i < x.size() && x[i] >= 0)
+        ops.push_back(x[i]);
+      if (i < y.size() && y[i] >= 0)
+        ops.push_back(y[i]);
+      if (carry >= 0)
+        ops.push_back(carry);
+
+      if (ops.size() == 1) {
+        sum[i] = ops[0];
+        carry = -1;
+      } else if (ops.size() == 2) {
+        sum[i] = lut(MASK_XOR2, ops);
+        carry = lut(MASK_AND2, ops);
+      } else if (ops.size() == 3) {
+        sum[i] = lut(MASK_XOR3, ops);
+        carry = lut(MASK_MAJ3, ops);
+      }
+    }
+    sum[n] = carry;
+    return sum;
+  }
+
+  Writer writer;
+
+private:
+  int next_net = Writer::FIRST_NET;
+  size_t luts = 0, dffs = 0, muls = 0, brams = 0;
+};
+
+// Replace absent (-1) bits with a constant zero for port declarations
+std::vector<int> port_bits(std::vector<int> bits) {
+  for (auto &b : bits)
+    if (b < 0)
+      b = Writer::CONST0;
+  return bits;
+}
+
+// Draws wire lengths from P(l) ~ l^(2p - 2) on [1, n] by inverting the CDF
+// of the continuous power law.
+class RentSampler {
+public:
+  RentSampler(double rent_exponent, uint64_t seed)
+      : exponent(2.0 * rent_exponent - 1.0), rng(seed) {}
+
+  // Pick an index in [lo, hi) near position frac (0..1) of the range
+  int pick(int lo, int hi, double frac) {
+    int n = hi - lo;
+    if (n <= 0)
+      throw std::logic_error("RentSampler: empty range");
+    if (n == 1)
+      return lo;
+
+    double u = uniform(rng);
+    double len;
+    if (std::abs(exponent) < 1e-9) {
+      len = std::pow(static_cast<double>(n), u);
+    } else {
+      len = std::pow((std::pow(static_cast<double>(n), exponent) - 1.0) * u +
+                         1.0,
+                     1.0 / exponent);
+    }
+    int offset = static_cast<int>(len) - 1; // 0 = the nearest cell
+    if (coin(rng))
+      offset = -offset - 1;
+
+    int center = static_cast<int>(frac * n);
+    int idx = ((center + offset) % n + n) % n;
+    return lo + idx;
+  }
+
+  std::mt19937_64 &engine() { return rng; }
+
+private:
+  double exponent;
+  std::mt19937_64 rng;
+  std::uniform_real_distribution<double> uniform{0.0, 1.0};
+  std::bernoulli_distribution coin{0.5};
+};
+
+} // namespace
+
+std::vector<int> DesignGenerator::lfsr_taps(int bits) {
+  // Maximal-length XNOR taps (Xilinx XAPP052), at most 4 so one LUT suffices
+  switch (bits) {
+  case 2: return {2, 1};
+  case 3: return {3, 2};
+  case 4: return {4, 3};
+  case 5: return {5, 3};
+  case 6: return {6, 5};
+  case 7: return {7, 6};
+  case 8: return {8, 6, 5, 4};
+  case 9: return {9, 5};
+  case 10: return {10, 7};
+  case 11: return {11, 9};
+  case 12: return {12, 6, 4, 1};
+  case 13: return {13, 4, 3, 1};
+  case 14: return {14, 5, 3, 1};
+  case 15: return {15, 14};
+  case 16: return {16, 15, 13, 4};
+  case 17: return {17, 14};
+  case 18: return {18, 11};
+  case 19: return {19, 6, 2, 1};
+  case 20: return {20, 17};
+  case 24: return {24, 23, 22, 17};
+  case 32: return {32, 22, 2, 1};
+  case 48: return {48, 47, 21, 20};
+  case 64: return {64, 63, 61, 60};
+  default: return {bits, bits - 1}; // Not maximal, but still cycles
+  }
+}
+
+void DesignGenerator::random(std::ostream &out,
+                             const GeneratorOptions &options) {
+  if (options.lut_width < 1 || options.lut_width > 6)
+    throw std::invalid_argument("lut_width must be in [1, 6]");
+  if (options.logic_depth < 1)
+    throw std::invalid_argument("logic_depth must be >= 1");
+  if (options.lut_dff_ratio < 0)
+    throw std::invalid_argument("lut_dff_ratio must be >= 0");
+
+  constexpr int BRAM_ABITS = 10;
+  constexpr int BRAM_WIDTH = 8;
+  constexpr int DSP_WIDTH = 8;
+
+  size_t num_dff = static_cast<size_t>(
+      std::llround(options.num_cells / (1.0 + options.lut_dff_ratio)));
+  size_t num_lut = options.num_cells - std::min(num_dff, options.num_cells);
+  size_t num_inputs = std::max<size_t>(1, options.num_inputs);
+  int depth = options.logic_depth;
+
+  Builder b(out, "top");
+  RentSampler sampler(options.rent_exponent, options.seed);
+  auto &rng = sampler.engine();
+
+  // Net layout (contiguous so ranges can be sampled directly):
+  // clk | primary inputs | DFF Q | BRAM out | DSP out | LUT level 1..depth
+  int clk = b.net();
+  std::vector<int> pi = b.nets(num_inputs);
+  std::vector<int> dff_q = b.nets(num_dff);
+  std::vector<int> bram_out = b.nets(options.num_brams * BRAM_WIDTH);
+  std::vector<int> dsp_out = b.nets(options.num_dsps * 2 * DSP_WIDTH);
+  int source_lo = pi.front();
+
+  std::vector<int> level_start(depth + 1);
+  int lut_lo = b.net();
+  level_start[0] = lut_lo;
+  for (int k = 0; k < depth; ++k) {
+    size_t size = num_lut / depth + (static_cast<size_t>(k) < num_lut % depth);
+    level_start[k + 1] = level_start[k] + static_cast<int>(size);
+  }
+  int lut_hi = level_start[depth];
+  for (int id = lut_lo + 1; id < lut_hi; ++id)
+    b.net(); // Reserve the remaining LUT output IDs
+  if (num_lut == 0)
+    lut_hi = lut_lo;
+
+  auto frac = [](size_t i, size_t n) { return n ? double(i) / n : 0.0; };
+
+  // Anything that has been computed: sources plus LUT outputs. Falls back to
+  // primary inputs when there is no logic at all.
+  auto pick_logic = [&](double pos) {
+    if (lut_hi > lut_lo)
+      return sampler.pick(lut_lo, lut_hi, pos);
+    return sampler.pick(source_lo, lut_lo, pos);
+  };
+
+  // Ports
+  b.input("clk", {clk});
+  b.input("in", pi);
+  std::vector<int> po(options.num_outputs);
+  int last_lo = lut_lo;
+  for (int k = depth - 1; k >= 0; --k) {
+    if (level_start[k + 1] > level_start[k]) {
+      last_lo = level_start[k];
+      break;
+    }
+  }
+  for (size_t i = 0; i < po.size(); ++i) {
+    double pos = frac(i, po.size());
+    po[i] = lut_hi > last_lo ? sampler.pick(last_lo, lut_hi, pos)
+                             : sampler.pick(source_lo, lut_lo, pos);
+  }
+  if (!po.empty())
+    b.output("out", po);
+
+  // Registers sample LUT outputs
+  for (size_t i = 0; i < num_dff; ++i)
+    b.dff_to(clk, pick_logic(frac(i, num_dff)), dff_q[i]);
+
+  // Hard blocks read from the logic cloud and feed it as sources
+  for (size_t i = 0; i < options.num_brams; ++i) {
+    double pos = frac(i, options.num_brams);
+    std::vector<int> addr(BRAM_ABITS), data(BRAM_WIDTH);
+    for (auto &a : addr)
+      a = pick_logic(pos);
+    for (auto &d : data)
+      d = pick_logic(pos);
+    std::vector<int> q(bram_out.begin() + i * BRAM_WIDTH,
+                       bram_out.begin() + (i + 1) * BRAM_WIDTH);
+    b.bram_to(clk, addr, data, pick_logic(pos), q);
+  }
+  for (size_t i = 0; i < options.num_dsps; ++i) {
+    double pos = frac(i, options.num_dsps);
+    std::vector<int> x(DSP_WIDTH), y(DSP_WIDTH);
+    for (auto &v : x)
+      v = pick_logic(pos);
+    for (auto &v : y)
+      v = pick_logic(pos);
+    std::vector<int> p(dsp_out.begin() + i * 2 * DSP_WIDTH,
+                       dsp_out.begin() + (i + 1) * 2 * DSP_WIDTH);
+    b.mul_to(x, y, p);
+  }
+
+  // LUT levels: input 0 comes from the previous level to pin the depth,
+  // the rest from anything computed earlier.
+  std::uniform_int_distribution<uint64_t> mask_dist;
+  uint64_t mask_bits = (uint64_t{1} << (1u << options.lut_width)) - 1;
+  if (options.lut_width == 6)
+    mask_bits = ~uint64_t{0};
+
+  for (int k = 0; k < depth; ++k) {
+    int lo = level_start[k];
+    int hi = level_start[k + 1];
+    for (int id = lo; id < hi; ++id) {
+      double pos = frac(id - lo, hi - lo);
+      std::vector<int> inputs(options.lut_width);
+      inputs[0] = k == 0 ? sampler.pick(source_lo, lut_lo, pos)
+                         : sampler.pick(level_start[k - 1], lo, pos);
+      for (int j = 1; j < options.lut_width; ++j)
+        inputs[j] = sampler.pick(source_lo, lo, pos);
+
+      uint64_t mask = mask_dist(rng) & mask_bits;
+      if (mask == 0 || mask == mask_bits)
+        mask ^= 1; // Keep every LUT non-constant
+      b.lut_to(mask, inputs, id);
+    }
+  }
+}
+
+void DesignGenerator::counter(std::ostream &out, int bits) {
+  if (bits < 1)
+    throw std::invalid_argument("counter needs at least 1 bit");
+
+  Builder b(out, "counter");
+  int clk = b.net();
+  std::vector<int> q = b.nets(bits);
+
+  // q0 toggles; q_i toggles when all lower bits are 1
+  int carry = q[0];
+  b.dff_to(clk, b.lut(MASK_NOT1, {q[0]}), q[0]);
+  for (int i = 1; i < bits; ++i) {
+    b.dff_to(clk, b.lut(MASK_XOR2, {q[i], carry}), q[i]);
+    if (i + 1 < bits)
+      carry = b.lut(MASK_AND2, {q[i], carry});
+  }
+
+  b.input("clk", {clk});
+  b.output("count", q);
+}
+
+void DesignGenerator::lfsr(std::ostream &out, int bits) {
+  if (bits < 2)
+    throw std::invalid_argument("lfsr needs at least 2 bits");
+
+  Builder b(out, "lfsr");
+  int clk = b.net();
+  std::vector<int> q = b.nets(bits);
+
+  std::vector<int> taps;
+  for (int t : lfsr_taps(bits))
+    taps.push_back(q[t - 1]);
+  int feedback = b.lut(parity_mask(taps.size(), true), taps); // XNOR
+
+  b.dff_to(clk, feedback, q[0]);
+  for (int i = 1; i < bits; ++i)
+    b.dff_to(clk, q[i - 1], q[i]);
+
+  b.input("clk", {clk});
+  b.output("q", q);
+}
+
+void DesignGenerator::adder(std::ostream &out, int bits) {
+  if (bits < 1)
+    throw std::invalid_argument("adder needs at least 1 bit");
+
+  Builder b(out, "adder");
+  std::vector<int> x = b.nets(bits);
+  std::vector<int> y = b.nets(bits);
+  std::vector<int> sum = b.add(x, y);
+
+  b.input("a", x);
+  b.input("b", y);
+  b.output("s", port_bits(sum));
+}
+
+void DesignGenerator::multiplier(std::ostream &out, int bits) {
+  if (bits < 1)
+    throw std::invalid_argument("multiplier needs at least 1 bit");
+
+  Builder b(out, "multiplier");
+  std::vector<int> x = b.nets(bits);
+  std::vector<int> y = b.nets(bits);
+
+  // Partial products, one row per bit of y, accumulated row by row
+  auto row = [&](int i) {
+    std::vector<int> pp(bits);
+    for (int j = 0; j < bits; ++j)
+      pp[j] = b.lut(MASK_AND2, {x[j], y[i]});
+    return pp;
+  };
+
+  std::vector<int> product;
+  std::vector<int> acc = row(0);
+  for (int i = 1; i < bits; ++i) {
+    product.push_back(acc[0]);
+    std::vector<int> upper(acc.begin() + 1, acc.end());
+    acc = b.add(upper, row(i));
+  }
+  product.insert(product.end(), acc.begin(), acc.end());
+  product.resize(2 * bits, -1);
+
+  b.input("a", x);
+  b.input("b", y);
+  b.output("p", port_bits(product));
+}
+
+void DesignGenerator::fir(std::ostream &out, int taps, int width) {
+  if (taps < 1 || width < 1)
+    throw std::invalid_argument("fir needs at least 1 tap and 1 bit");
+
+  Builder b(out, "fir");
+  int clk = b.net();
+  std::vector<int> x = b.nets(width);
+
+  // Delay line: stage k holds x delayed by k cycles
+  std::vector<std::vector<int>> stages{x};
+  for (int k = 1; k < taps; ++k) {
+    std::vector<int> stage(width);
+    for (int i = 0; i < width; ++i)
+      stage[i] = b.dff(clk, stages.back()[i]);
+    stages.push_back(stage);
+  }
+
+  // One DSP multiplier per tap with a constant coefficient, then an adder
+  // chain accumulating the products
+  std::vector<int> acc;
+  for (int k = 0; k < taps; ++k) {
+    uint64_t coeff = (2 * k + 1) & ((uint64_t{1} << width) - 1);
+    std::vector<int> c(width);
+    for (int i = 0; i < width; ++i)
+      c[i] = ((coeff >> i) & 1) ? Writer::CONST1 : Writer::CONST0;
+
+    std::vector<int> prod = b.nets(2 * width);
+    b.mul_to(stages[k], c, prod);
+    acc = acc.empty() ? prod : b.add(acc, prod);
+  }
+
+  // Registered output
+  std::vector<int> y;
+  for (int bit : acc)
+    y.push_back(bit >= 0 ? b.dff(clk, bit) : -1);
+
+  b.input("clk", {clk});
+  b.input("x", x);
+  b.output("y", port_bits(y));
+}
+
+} // namespace vfpga
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vfpga {
+
+struct GeneratorOptions {
+  size_t num_cells = 1000;     // LUTs + DFFs (hard blocks are extra)
+  double rent_exponent = 0.6;  // 0.5 = very local wiring, 1.0 = random
+  double lut_dff_ratio = 4.0;  // LUTs per DFF
+  size_t num_brams = 0;
+  size_t num_dsps = 0;
+  int logic_depth = 6;         // LUT levels between register stages
+  int lut_width = 4;           // Inputs per LUT (K)
+  size_t num_inputs = 16;
+  size_t num_outputs = 16;
+  uint64_t seed = 1;
+};
+
+// Generates Yosys-style JSON netlists for tests and benchmarks.
+// Everything is streamed, so million-cell designs need no intermediate DOM.
+class DesignGenerator {
+public:
+  // Random design with controllable size, locality, register ratio, hard
+  // block usage and logic depth.
+  //
+  // Locality: cells are laid out in one dimension and each fanin is drawn
+  // at distance l with P(l) ~ l^(2p - 2), the wire-length distribution of a
+  // linear placement of a circuit with Rent exponent p.
+  // Depth: LUTs are split into logic_depth levels; every LUT at level k
+  // reads at least one LUT at level k - 1, so the longest register-to-
+  // register path is exactly logic_depth LUTs.
+  static void random(std::ostream &out, const GeneratorOptions &options);
+
+  // Classic circuits (clock input "clk" where sequential)
+  static void counter(std::ostream &out, int bits);
+  static void lfsr(std::ostream &out, int bits);
+  static void adder(std::ostream &out, int bits);      // Ripple-carry
+  static void multiplier(std::ostream &out, int bits); // Array multiplier
+  static void fir(std::ostream &out, int taps, int width); // DSP taps
+
+  // Maximal-length tap positions (1-based) used by lfsr()
+  static std::vector<int> lfsr_taps(int bits);
+};
+
+} // namespace vfpga
@@ -0,0 +1,154 @@
+#include "YosysJsonWriter.hpp"
+
+namespace vfpga {
+
+YosysJsonWriter::YosysJsonWriter(std::ostream &out,
+                                 const std::string &module_name,
+                                 const std::string &creator)
+    : out(out) {
+  out << "{\n  \"creator\": ";
+  write_string(out, creator);
+  out << ",\n  \"modules\": {\n    ";
+  write_string(out, module_name);
+  out << ": {\n      \"attributes\": { \"top\": 1 }";
+}
+
+YosysJsonWriter::~YosysJsonWriter() { finish(); }
+
+void YosysJsonWriter::add_port(const std::string &name, bool is_output,
+                               const std::vector<int> &bits) {
+  if (!enter(Section::PORTS))
+    return;
+
+  out << (first_in_section ? "\n" : ",\n") << "        ";
+  first_in_section = false;
+  write_string(out, name);
+  out << ": { \"direction\": \"" << (is_output ? "output" : "input")
+      << "\", \"bits\": ";
+  write_bits(bits);
+  out << " }";
+}
+
+bool YosysJsonWriter::enter(Section next) {
+  if (section == next)
+    return true;
+  if (section == Section::DONE)
+    return false;
+  if ((next == Section::PORTS && ports_done) ||
+      (next == Section::CELLS && cells_done))
+    return false;
+
+  if (section == Section::PORTS || section == Section::CELLS)
+    out << "\n      }";
+  if (section == Section::PORTS)
+    ports_done = true;
+  if (section == Section::CELLS)
+    cells_done = true;
+
+  if (next == Section::PORTS)
+    out << ",\n      \"ports\": {";
+  else if (next == Section::CELLS)
+    out << ",\n      \"cells\": {";
+  section = next;
+  first_in_section = true;
+  return true;
+}
+
+void YosysJsonWriter::add_cell(const std::string &name,
+                               const std::string &type,
+                               const std::vector<Parameter> &parameters,
+                               const std::vector<Connection> &connections) {
+  if (!enter(Section::CELLS))
+    return;
+
+  out << (first_in_section ? "\n" : ",\n") << "        ";
+  first_in_section = false;
+  write_string(out, name);
+  out << ": {\n          \"type\": ";
+  write_string(out, type);
+
+  out << ",\n          \"parameters\": {";
+  for (size_t i = 0; i < parameters.size(); ++i) {
+    out << (i ? ", " : " ");
+    write_string(out, parameters[i].name);
+    out << ": ";
+    if (parameters[i].is_string)
+      write_string(out, parameters[i].value);
+    else
+      out << parameters[i].value;
+  }
+  out << (parameters.empty() ? "}" : " }");
+
+  out << ",\n          \"port_directions\": {";
+  for (size_t i = 0; i < connections.size(); ++i) {
+    out << (i ? ", " : " ");
+    write_string(out, connections[i].port);
+    out << (connections[i].is_output ? ": \"output\"" : ": \"input\"");
+  }
+  out << (connections.empty() ? "}" : " }");
+
+  out << ",\n          \"connections\": {";
+  for (size_t i = 0; i < connections.size(); ++i) {
+    out << (i ? ", " : " ");
+    write_string(out, connections[i].port);
+    out << ": ";
+    write_bits(connections[i].bits);
+  }
+  out << (connections.empty() ? "}" : " }") << "\n        }";
+  ++cells_written;
+}
+
+void YosysJsonWriter::finish() {
+  if (section == Section::DONE)
+    return;
+  // Always emit both sections so readers can rely on them
+  if (!ports_done)
+    enter(Section::PORTS);
+  if (!cells_done)
+    enter(Section::CELLS);
+  out << "\n      }\n    }\n  }\n}\n";
+  out.flush();
+  section = Section::DONE;
+}
+
+void YosysJsonWriter::write_bits(const std::vector<int> &bits) {
+  out << '[';
+  for (size_t i = 0; i < bits.size(); ++i) {
+    if (i)
+      out << ", ";
+    if (bits[i] == CONST0)
+      out << "\"0\"";
+    else if (bits[i] == CONST1)
+      out << "\"1\"";
+    else
+      out << bits[i];
+  }
+  out << ']';
+}
+
+void YosysJsonWriter::write_string(std::ostream &os, const std::string &s) {
+  os << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      os << '\\';
+    os << c;
+  }
+  os << '"';
+}
+
+YosysJsonWriter::Parameter YosysJsonWriter::int_param(const std::string &name,
+                                                      long long value) {
+  return {name, std::to_string(value), false};
+}
+
+YosysJsonWriter::Parameter YosysJsonWriter::lut_param(uint64_t mask,
+                                                      int width) {
+  size_t bits = size_t{1} << width;
+  std::string value(bits, '0');
+  for (size_t i = 0; i < bits; ++i)
+    if ((mask >> i) & 1)
+      value[bits - 1 - i] = '1';
+  return {"LUT", value, true};
+}
+
+} // namespace vfpga
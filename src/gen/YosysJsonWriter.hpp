@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vfpga {
+
+// Streams a single-module Yosys-style JSON netlist without building a DOM,
+// so generated designs with millions of cells can be written in O(1) memory.
+//
+// Bits follow Yosys conventions: net IDs start at 2, and the IDs 0 and 1 are
+// written as the constant strings "0" and "1".
+class YosysJsonWriter {
+public:
+  static constexpr int CONST0 = 0;
+  static constexpr int CONST1 = 1;
+  static constexpr int FIRST_NET = 2;
+
+  struct Connection {
+    std::string port;
+    bool is_output;
+    std::vector<int> bits;
+  };
+
+  // A parameter is written verbatim if it looks numeric, quoted otherwise
+  struct Parameter {
+    std::string name;
+    std::string value;
+    bool is_string;
+  };
+
+  YosysJsonWriter(std::ostream &out, const std::string &module_name,
+                  const std::string &creator = "vfpga_gen");
+
+  // Ports and cells may be added in either order, but each section is
+  // written once: all ports together and all cells together.
+  void add_port(const std::string &name, bool is_output,
+                const std::vector<int> &bits);
+
+  void add_cell(const std::string &name, const std::string &type,
+                const std::vector<Parameter> &parameters,
+                const std::vector<Connection> &connections);
+
+  // Closes all open objects. Called automatically by the destructor.
+  void finish();
+
+  ~YosysJsonWriter();
+
+  size_t cell_count() const { return cells_written; }
+
+  // Convenience helpers for common parameter kinds
+  static Parameter int_param(const std::string &name, long long value);
+  // Yosys writes LUT masks as binary strings, MSB (highest index) first
+  static Parameter lut_param(uint64_t mask, int width);
+
+private:
+  enum class Section { NONE, PORTS, CELLS, DONE };
+
+  std::ostream &out;
+  Section section = Section::NONE;
+  bool ports_done = false;
+  bool cells_done = false;
+  bool first_in_section = true;
+  size_t cells_written = 0;
+
+  // Close the open section (if any) and open 'next'. Returns false if
+  // 'next' was already written and closed.
+  bool enter(Section next);
+  void write_bits(const std::vector<int> &bits);
+  static void write_string(std::ostream &os, const std::string &s);
+};
+
+} // namespace vfpga
@@ -25,12 +25,12 @@ int main() {
   // Block 0: LUT (Source) at (2,2)
   blocks.emplace_back(0, "lut0");
   blocks.back().type = TileType::CLB;
-  blocks.back().output_net = "net_a";
+  blocks.back().output_net = 0;
 
   // Block 1: DFF (Sink) at (5,5)
   blocks.emplace_back(1, "dff0");
   blocks.back().type = TileType::CLB;
-  blocks.back().input_nets.push_back("net_a");
+  blocks.back().input_nets.push_back(0);
 
   std::map<int, std::pair<int, int>> placement;
   placement[0] = {2, 2};
@@ -13,8 +13,10 @@ public:
   std::vector<std::vector<LogicVal>> memory;
 
   static constexpr int DELAY_READ_PS = 1000; // 1ns read delay
+  static constexpr int DEFAULT_DEPTH = 1024;
+  static constexpr int DEFAULT_WIDTH = 8;
 
-  BRAM(int d = 1024, int w = 8) : depth(d), width(w) {
+  BRAM(int d = DEFAULT_DEPTH, int w = DEFAULT_WIDTH) : depth(d), width(w) {
     memory.resize(depth,
                   std::vector<LogicVal>(width, LogicVal(LogicState::L0)));
   }
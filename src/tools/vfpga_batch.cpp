@@ -0,0 +1,252 @@
+// vfpga_batch: run many designs/seeds through the full flow in parallel.
+//
+// Usage: vfpga_batch <manifest.json> [-j threads] [-o summary.json]
+//                    [--cache dir] [-v]
+//
+// Manifest format:
+// {
+//   "seed": 1,                                   // base seed (optional)
+//   "cache_dir": ".vfpga_cache",                 // artifact cache (optional)
+//   "defaults": { "fabric": [10, 10], "cycles": 1000,
+//                 "memory_cap_mb": 1024, "seeds": 1,
+//                 "techmap": true, "optimize": true },
+//   "designs": [
+//     { "name": "blinky", "netlist": "tests/data/test_design.json",
+//       "seeds": [1, 2, 3] },                     // explicit seeds, or
+//     { "name": "big", "netlist": "big.json", "seeds": 4 } // derived seeds
+//   ]
+// }
+// Netlist paths are relative to the manifest. Derived seeds depend only on
+// the base seed, design name and index, so a manifest always maps to the same
+// set of placements regardless of thread count or scheduling order.
+// With a cache directory, re-running a manifest only redoes the stages whose
+// inputs changed (e.g. new seeds reuse the packed netlist).
+
+#include "flow/Flow.hpp"
+#include "utils/ThreadPool.hpp"
+#include "utils/json.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+using namespace vfpga;
+
+namespace {
+
+struct Job {
+  std::string design;
+  FlowOptions options;
+};
+
+// Discards everything written to it (silences per-stage library logging)
+class NullBuffer : public std::streambuf {
+protected:
+  int overflow(int c) override { return c; }
+};
+
+uint64_t splitmix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+uint32_t derive_seed(uint64_t base, const std::string &design, size_t index) {
+  uint64_t h = 0xCBF29CE484222325ULL; // FNV-1a
+  for (unsigned char c : design)
+    h = (h ^ c) * 0x100000001B3ULL;
+  return static_cast<uint32_t>(splitmix64(base ^ splitmix64(h + index)));
+}
+
+std::vector<Job> load_manifest(const std::string &path,
+                               const std::string &cache_override) {
+  std::ifstream file(path);
+  if (!file.is_open())
+    throw std::runtime_error("Could not open manifest " + path);
+
+  json manifest;
+  file >> manifest;
+
+  std::filesystem::path base_dir = std::filesystem::path(path).parent_path();
+  uint64_t base_seed = manifest.value("seed", 1ULL);
+  json defaults = manifest.value("defaults", json::object());
+
+  std::string cache_dir = cache_override;
+  if (cache_dir.empty() && manifest.contains("cache_dir")) {
+    std::filesystem::path dir = manifest["cache_dir"].get<std::string>();
+    cache_dir = (dir.is_relative() ? base_dir / dir : dir).string();
+  }
+
+  std::vector<Job> jobs;
+  for (const auto &design : manifest.at("designs")) {
+    json cfg = defaults;
+    cfg.update(design);
+
+    std::string name = cfg.at("name");
+    std::filesystem::path netlist = cfg.at("netlist").get<std::string>();
+    if (netlist.is_relative())
+      netlist = base_dir / netlist;
+
+    FlowOptions options;
+    options.netlist_path = netlist.string();
+    if (cfg.contains("fabric")) {
+      options.fabric_width = cfg["fabric"].at(0);
+      options.fabric_height = cfg["fabric"].at(1);
+    }
+    options.sim_cycles = cfg.value("cycles", options.sim_cycles);
+    options.memory_cap_bytes =
+        cfg.value("memory_cap_mb", size_t{0}) * 1024 * 1024;
+    options.cache_dir = cache_dir;
+    options.techmap = cfg.value("techmap", options.techmap);
+    options.optimize = cfg.value("optimize", options.optimize);
+
+    std::vector<uint32_t> seeds;
+    json seeds_cfg = cfg.value("seeds", json(1));
+    if (seeds_cfg.is_array()) {
+      for (const auto &s : seeds_cfg)
+        seeds.push_back(s.get<uint32_t>());
+    } else {
+      for (size_t i = 0; i < seeds_cfg.get<size_t>(); ++i)
+        seeds.push_back(derive_seed(base_seed, name, i));
+    }
+
+    for (uint32_t seed : seeds) {
+      Job job{name, options};
+      job.options.seed = seed;
+      jobs.push_back(job);
+    }
+  }
+  return jobs;
+}
+
+json report_to_json(const Job &job, const FlowReport &r) {
+  json j;
+  j["design"] = job.design;
+  j["netlist"] = job.options.netlist_path;
+  j["seed"] = job.options.seed;
+  j["fabric"] = {job.options.fabric_width, job.options.fabric_height};
+  j["status"] = r.success ? "pass" : "fail";
+  if (!r.success)
+    j["error"] = r.error;
+  j["cached"] = {{"netlist", r.netlist_cached},
+                 {"pack", r.pack_cached},
+                 {"place", r.place_cached},
+                 {"route", r.route_cached}};
+  j["stages_ms"] = {{"parse", r.parse_ms},       {"map", r.map_ms},
+                    {"optimize", r.optimize_ms}, {"pack", r.pack_ms},
+                    {"place", r.place_ms},       {"route", r.route_ms},
+                    {"timing", r.timing_ms},     {"simulate", r.sim_ms}};
+  j["cells"] = r.num_cells;
+  j["cells_removed"] = r.cells_removed;
+  j["blocks"] = r.num_blocks;
+  j["clusters"] = r.num_clusters;
+  j["cluster_path_gain"] = r.cluster_path_gain;
+  j["hpwl"] = r.hpwl;
+  j["routing_iterations"] = r.routing_iterations;
+  j["fmax_mhz"] = r.fmax_mhz;
+  j["sim_cycles"] = job.options.sim_cycles;
+  j["sim_cycles_per_sec"] = r.sim_cycles_per_sec;
+  j["sim_registers_high"] = r.sim_registers_high;
+  j["estimated_memory_bytes"] = r.estimated_memory_bytes;
+  return j;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string manifest_path;
+  std::string output_path;
+  std::string cache_dir;
+  size_t threads = 0;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      threads = std::stoul(argv[++i]);
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_path = argv[++i];
+    } else if (arg == "--cache" && i + 1 < argc) {
+      cache_dir = argv[++i];
+    } else if (arg == "-v") {
+      verbose = true;
+    } else if (manifest_path.empty()) {
+      manifest_path = arg;
+    } else {
+      std::cerr << "Unexpected argument: " << arg << std::endl;
+      return 2;
+    }
+  }
+  if (manifest_path.empty()) {
+    std::cerr << "Usage: vfpga_batch <manifest.json> [-j threads] "
+                 "[-o summary.json] [--cache dir] [-v]"
+              << std::endl;
+    return 2;
+  }
+
+  std::vector<Job> jobs;
+  try {
+    jobs = load_manifest(manifest_path, cache_dir);
+  } catch (const std::exception &e) {
+    std::cerr << "Error: bad manifest: " << e.what() << std::endl;
+    return 2;
+  }
+
+  NullBuffer null_buffer;
+  std::streambuf *saved_cout = std::cout.rdbuf();
+  if (!verbose)
+    std::cout.rdbuf(&null_buffer);
+
+  std::vector<FlowReport> reports(jobs.size());
+  auto start = std::chrono::steady_clock::now();
+  size_t pool_size;
+  {
+    ThreadPool pool(threads);
+    pool_size = pool.size();
+    pool.parallel_for(0, jobs.size(), [&](size_t i) {
+      reports[i] = Flow::run(jobs[i].options);
+      std::cerr << "[" << (reports[i].success ? "PASS" : "FAIL") << "] "
+                << jobs[i].design << " seed=" << jobs[i].options.seed
+                << (reports[i].success ? "" : " (" + reports[i].error + ")")
+                << std::endl;
+    });
+  }
+  double total_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  std::cout.rdbuf(saved_cout);
+
+  // Results are emitted in manifest order, independent of completion order
+  json summary;
+  summary["threads"] = pool_size;
+  summary["total_ms"] = total_ms;
+  summary["jobs"] = json::array();
+  size_t failed = 0;
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    summary["jobs"].push_back(report_to_json(jobs[i], reports[i]));
+    if (!reports[i].success)
+      ++failed;
+  }
+  summary["passed"] = jobs.size() - failed;
+  summary["failed"] = failed;
+
+  if (output_path.empty()) {
+    std::cout << summary.dump(2) << std::endl;
+  } else {
+    std::ofstream out(output_path);
+    if (!out.is_open()) {
+      std::cerr << "Error: could not write " << output_path << std::endl;
+      return 2;
+    }
+    out << summary.dump(2) << std::endl;
+  }
+
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// vfpga_bitdiff: compare two bitstreams frame by frame.
+//
+// Usage: vfpga_bitdiff <a.bit> <b.bit> [--max N] [--no-verify]
+// Either file may be compressed. Prints one line per differing tile (at
+// most N, default 50) and exits with 0 if the configurations are
+// identical, 1 if they differ and 2 on errors.
+
+#include "fabric/BitstreamDiff.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace vfpga;
+
+int main(int argc, char **argv) {
+  std::string paths[2];
+  int num_paths = 0;
+  size_t max_lines = 50;
+  bool verify = true;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--max" && i + 1 < argc) {
+      max_lines = std::stoul(argv[++i]);
+    } else if (arg == "--no-verify") {
+      verify = false;
+    } else if (num_paths < 2) {
+      paths[num_paths++] = arg;
+    } else {
+      std::cerr << "Unexpected argument: " << arg << std::endl;
+      return 2;
+    }
+  }
+  if (num_paths != 2) {
+    std::cerr << "Usage: vfpga_bitdiff <a.bit> <b.bit> [--max N] [--no-verify]"
+              << std::endl;
+    return 2;
+  }
+
+  auto a = BitstreamLoader::read(paths[0], verify);
+  auto b = BitstreamLoader::read(paths[1], verify);
+  if (!a || !b)
+    return 2;
+
+  auto start = std::chrono::steady_clock::now();
+  ConfigDiff diff = BitstreamDiff::compare(*a, *b);
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+
+  if (!diff.compatible) {
+    std::cout << "Different fabrics: " << a->width << "x" << a->height
+              << " vs " << b->width << "x" << b->height << std::endl;
+    return 1;
+  }
+
+  for (size_t i = 0; i < diff.tiles.size() && i < max_lines; ++i) {
+    const auto &t = diff.tiles[i];
+    std::cout << "(" << t.x << ", " << t.y << "):"
+              << (t.lut_mask ? " lut" : "") << (t.dff_init ? " dff" : "")
+              << (t.routing ? " routing" : "") << (t.bram_init ? " bram" : "")
+              << std::endl;
+  }
+  if (diff.tiles.size() > max_lines)
+    std::cout << "... " << diff.tiles.size() - max_lines << " more"
+              << std::endl;
+
+  std::cout << diff.frames_different << " of " << diff.frames_compared
+            << " frames differ, " << diff.tiles.size() << " tiles ("
+            << ms << " ms)" << std::endl;
+  return diff.identical() ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+// vfpga_gen: write synthetic Yosys-style JSON netlists.
+//
+// Usage: vfpga_gen <kind> [options] [-o out.json]
+//   random      --cells N --rent P --lut-dff-ratio R --brams N --dsps N
+//               --depth D --lut-width K --inputs N --outputs N --seed S
+//   counter     --width N
+//   lfsr        --width N
+//   adder       --width N
+//   multiplier  --width N
+//   fir         --taps N --width N
+// Without -o the netlist is written to stdout.
+
+#include "gen/DesignGenerator.hpp"
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+using namespace vfpga;
+
+namespace {
+
+void usage() {
+  std::cerr << "Usage: vfpga_gen <random|counter|lfsr|adder|multiplier|fir> "
+               "[options] [-o out.json]\n"
+               "  random:  --cells N --rent P --lut-dff-ratio R --brams N "
+               "--dsps N --depth D\n"
+               "           --lut-width K --inputs N --outputs N --seed S\n"
+               "  counter|lfsr|adder|multiplier:  --width N\n"
+               "  fir:     --taps N --width N"
+            << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    usage();
+    return 2;
+  }
+
+  std::string kind = argv[1];
+  std::string output_path;
+  std::map<std::string, std::string> args;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      usage();
+      return 2;
+    }
+    if (arg == "-o")
+      output_path = argv[++i];
+    else if (arg.rfind("--", 0) == 0)
+      args[arg.substr(2)] = argv[++i];
+    else {
+      std::cerr << "Unexpected argument: " << arg << std::endl;
+      usage();
+      return 2;
+    }
+  }
+
+  auto get_int = [&](const std::string &key, long long def) {
+    return args.count(key) ? std::stoll(args[key]) : def;
+  };
+  auto get_double = [&](const std::string &key, double def) {
+    return args.count(key) ? std::stod(args[key]) : def;
+  };
+
+  std::ofstream file;
+  if (!output_path.empty()) {
+    file.open(output_path);
+    if (!file.is_open()) {
+      std::cerr << "Error: could not write " << output_path << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &out = output_path.empty() ? std::cout : file;
+
+  try {
+    int width = static_cast<int>(get_int("width", 8));
+    if (kind == "random") {
+      GeneratorOptions options;
+      options.num_cells = get_int("cells", options.num_cells);
+      options.rent_exponent = get_double("rent", options.rent_exponent);
+      options.lut_dff_ratio = get_double("lut-dff-ratio", options.lut_dff_ratio);
+      options.num_brams = get_int("brams", options.num_brams);
+      options.num_dsps = get_int("dsps", options.num_dsps);
+      options.logic_depth = get_int("depth", options.logic_depth);
+      options.lut_width = get_int("lut-width", options.lut_width);
+      options.num_inputs = get_int("inputs", options.num_inputs);
+      options.num_outputs = get_int("outputs", options.num_outputs);
+      options.seed = get_int("seed", options.seed);
+      DesignGenerator::random(out, options);
+    } else if (kind == "counter") {
+      DesignGenerator::counter(out, width);
+    } else if (kind == "lfsr") {
+      DesignGenerator::lfsr(out, width);
+    } else if (kind == "adder") {
+      DesignGenerator::adder(out, width);
+    } else if (kind == "multiplier") {
+      DesignGenerator::multiplier(out, width);
+    } else if (kind == "fir") {
+      DesignGenerator::fir(out, get_int("taps", 8), width);
+    } else {
+      std::cerr << "Unknown design kind: " << kind << std::endl;
+      usage();
+      return 2;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace vfpga {
+
+// Little helpers for compact binary files. Values are written in host byte
+// order; files carry a magic/version header and are not meant to be moved
+// between machines of different endianness.
+class BinaryWriter {
+public:
+  explicit BinaryWriter(std::ostream &out) : out(out) {}
+
+  template <typename T> void write(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void write_string(const std::string &s) {
+    write<uint32_t>(static_cast<uint32_t>(s.size()));
+    out.write(s.data(), s.size());
+  }
+
+  template <typename T> void write_vector(const std::vector<T> &v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    write<uint64_t>(v.size());
+    out.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+  }
+
+  bool good() const { return out.good(); }
+
+private:
+  std::ostream &out;
+};
+
+// Throws std::runtime_error on truncated or corrupt input
+class BinaryReader {
+public:
+  explicit BinaryReader(std::istream &in) : in(in) {}
+
+  template <typename T> T read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    read_raw(&value, sizeof(T));
+    return value;
+  }
+
+  std::string read_string() {
+    uint32_t size = read<uint32_t>();
+    std::string s(size, '\0');
+    read_raw(s.data(), size);
+    return s;
+  }
+
+  template <typename T> std::vector<T> read_vector(uint64_t max_size = 1ULL << 32) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    uint64_t size = read<uint64_t>();
+    if (size > max_size)
+      throw std::runtime_error("BinaryReader: vector size out of range");
+    std::vector<T> v(size);
+    read_raw(v.data(), size * sizeof(T));
+    return v;
+  }
+
+private:
+  std::istream &in;
+
+  void read_raw(void *dst, size_t size) {
+    in.read(static_cast<char *>(dst), size);
+    if (static_cast<size_t>(in.gcount()) != size)
+      throw std::runtime_error("BinaryReader: unexpected end of file");
+  }
+};
+
+// BinaryReader over bytes already in memory, e.g. a MappedFile, so large
+// arrays are copied straight out of the page cache.
+// Throws std::runtime_error on truncated input.
+class MemoryReader {
+public:
+  MemoryReader(const std::byte *data, size_t size)
+      : pos(data), end(data + size) {}
+
+  template <typename T> T read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    read_raw(&value, sizeof(T));
+    return value;
+  }
+
+  std::string read_string() {
+    uint32_t size = read<uint32_t>();
+    check(size);
+    std::string s(reinterpret_cast<const char *>(pos), size);
+    pos += size;
+    return s;
+  }
+
+  template <typename T> std::vector<T> read_vector() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    uint64_t size = read<uint64_t>();
+    if (size > remaining() / sizeof(T))
+      throw std::runtime_error("MemoryReader: vector size out of range");
+    std::vector<T> v(size);
+    read_raw(v.data(), size * sizeof(T));
+    return v;
+  }
+
+  size_t remaining() const { return static_cast<size_t>(end - pos); }
+
+private:
+  const std::byte *pos, *end;
+
+  void check(size_t size) const {
+    if (size > remaining())
+      throw std::runtime_error("MemoryReader: unexpected end of data");
+  }
+
+  void read_raw(void *dst, size_t size) {
+    check(size);
+    if (size)
+      std::memcpy(dst, pos, size);
+    pos += size;
+  }
+};
+
+} // namespace vfpga
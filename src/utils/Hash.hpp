@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace vfpga {
+
+// Incremental 64-bit FNV-1a hash. Used for content keys and checksums; not
+// cryptographic.
+class Hasher {
+public:
+  static constexpr uint64_t OFFSET_BASIS = 0xCBF29CE484222325ULL;
+  static constexpr uint64_t PRIME = 0x100000001B3ULL;
+
+  Hasher &update(const void *data, size_t size) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+      state = (state ^ bytes[i]) * PRIME;
+    return *this;
+  }
+
+  Hasher &update(std::string_view s) {
+    update<uint64_t>(s.size()); // Length prefix keeps fields unambiguous
+    return update(s.data(), s.size());
+  }
+
+  template <typename T> Hasher &update(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return update(&value, sizeof(T));
+  }
+
+  uint64_t digest() const { return state; }
+
+private:
+  uint64_t state = OFFSET_BASIS;
+};
+
+inline uint64_t hash_bytes(const void *data, size_t size) {
+  return Hasher().update(data, size).digest();
+}
+
+// Word-at-a-time 64-bit hash (MurmurHash64A) for bulk data such as
+// configuration frames, where byte-wise FNV would dominate the run time.
+inline uint64_t fast_hash(const void *data, size_t size, uint64_t seed = 0) {
+  constexpr uint64_t m = 0xC6A4A7935BD1E995ULL;
+  constexpr int r = 47;
+  uint64_t h = seed ^ (size * m);
+
+  const auto *bytes = static_cast<const unsigned char *>(data);
+  size_t words = size / 8;
+  for (size_t i = 0; i < words; ++i) {
+    uint64_t k;
+    std::memcpy(&k, bytes + i * 8, 8);
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+
+  size_t tail = size & 7;
+  if (tail) {
+    uint64_t k = 0;
+    std::memcpy(&k, bytes + words * 8, tail);
+    h ^= k;
+    h *= m;
+  }
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+// Fixed-width lowercase hex, e.g. for cache file names
+inline std::string to_hex(uint64_t value) {
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016llx",
+                static_cast<unsigned long long>(value));
+  return buf;
+}
+
+} // namespace vfpga
@@ -0,0 +1,69 @@
+#include "MappedFile.hpp"
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VFPGA_HAVE_MMAP 1
+#else
+#include <fstream>
+#endif
+
+namespace vfpga {
+
+#ifdef VFPGA_HAVE_MMAP
+
+MappedFile::MappedFile(const std::string &path, Mode mode) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Cannot open " + path);
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot stat " + path);
+  }
+  length = static_cast<size_t>(st.st_size);
+
+  if (length > 0) {
+    int prot = PROT_READ | (mode == Mode::COPY_ON_WRITE ? PROT_WRITE : 0);
+    void *addr = ::mmap(nullptr, length, prot, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Cannot map " + path);
+    }
+    base = static_cast<std::byte *>(addr);
+    mapped = true;
+  }
+  ::close(fd); // The mapping keeps its own reference to the file
+}
+
+MappedFile::~MappedFile() {
+  if (mapped)
+    ::munmap(base, length);
+  else
+    delete[] base;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path, Mode) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open())
+    throw std::runtime_error("Cannot open " + path);
+  length = static_cast<size_t>(file.tellg());
+  file.seekg(0);
+  base = new std::byte[length];
+  if (!file.read(reinterpret_cast<char *>(base), length)) {
+    delete[] base;
+    throw std::runtime_error("Cannot read " + path);
+  }
+}
+
+MappedFile::~MappedFile() { delete[] base; }
+
+#endif
+
+} // namespace vfpga
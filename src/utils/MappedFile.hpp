@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace vfpga {
+
+// Read-only or copy-on-write view of a whole file.
+// On POSIX systems the file is mmap'ed, so clean pages are shared between
+// processes mapping the same file and nothing is read until it is touched.
+// Elsewhere the file is read into a heap buffer with the same interface.
+//
+// Throws std::runtime_error if the file cannot be opened or mapped.
+class MappedFile {
+public:
+  enum class Mode {
+    READ_ONLY,     // Writes through data() are undefined
+    COPY_ON_WRITE, // Writable; changes stay private to this process
+  };
+
+  explicit MappedFile(const std::string &path, Mode mode = Mode::READ_ONLY);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  std::byte *data() { return base; }
+  const std::byte *data() const { return base; }
+  size_t size() const { return length; }
+
+private:
+  std::byte *base = nullptr;
+  size_t length = 0;
+  bool mapped = false; // false: base was allocated with new[]
+};
+
+} // namespace vfpga
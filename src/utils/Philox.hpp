@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace vfpga {
+
+// Counter-based random numbers (Philox4x32-10, Salmon et al., "Parallel
+// Random Numbers: As Easy as 1, 2, 3"). Every output is a pure function of
+// (key, stream, position), so any number of independent streams can be
+// drawn from one seed in any order or on any thread, without sharing or
+// splitting generator state. Meets UniformRandomBitGenerator.
+class Philox {
+public:
+  using result_type = uint32_t;
+
+  explicit Philox(uint64_t key = 0, uint64_t stream = 0)
+      : key{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)},
+        stream(stream) {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    if (next == 4) {
+      block = generate({static_cast<uint32_t>(position),
+                        static_cast<uint32_t>(position >> 32),
+                        static_cast<uint32_t>(stream),
+                        static_cast<uint32_t>(stream >> 32)},
+                       key);
+      ++position;
+      next = 0;
+    }
+    return block[next++];
+  }
+
+  // The ten-round bijection of one counter block under a key
+  static std::array<uint32_t, 4> generate(std::array<uint32_t, 4> counter,
+                                          std::array<uint32_t, 2> key) {
+    constexpr uint64_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+    constexpr uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+    for (int round = 0; round < 10; ++round) {
+      if (round > 0) {
+        key[0] += W0;
+        key[1] += W1;
+      }
+      uint64_t p0 = M0 * counter[0], p1 = M1 * counter[2];
+      counter = {static_cast<uint32_t>(p1 >> 32) ^ counter[1] ^ key[0],
+                 static_cast<uint32_t>(p1),
+                 static_cast<uint32_t>(p0 >> 32) ^ counter[3] ^ key[1],
+                 static_cast<uint32_t>(p0)};
+    }
+    return counter;
+  }
+
+private:
+  std::array<uint32_t, 2> key;
+  uint64_t stream;
+  uint64_t position = 0; // Next counter block
+  std::array<uint32_t, 4> block{};
+  int next = 4; // Outputs of 'block' used
+};
+
+} // namespace vfpga
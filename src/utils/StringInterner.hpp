@@ -0,0 +1,130 @@
+#pragma once
+
+#include "BinaryIO.hpp"
+#include "Hash.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vfpga {
+
+using NameId = int32_t;
+
+// Maps strings to dense integer IDs (in first-seen order) and back.
+// All characters live in one buffer and the index is an open-addressing
+// table of IDs, so there is no per-string allocation and the interner is a
+// plain value type (copies need no fix-up). Each slot also keeps 32 bits of
+// the string's hash, so probes rarely touch the characters and growing the
+// table never rehashes them.
+class StringInterner {
+public:
+  NameId intern(std::string_view s) {
+    if ((offsets.size() + 1) * 2 > slots.size())
+      grow();
+    uint32_t h = hash(s);
+    size_t i = slot_of(s, h);
+    if (slots[i].id != EMPTY)
+      return slots[i].id;
+
+    NameId id = static_cast<NameId>(size());
+    chars.append(s);
+    offsets.push_back(static_cast<uint32_t>(chars.size()));
+    slots[i] = {id, h};
+    return id;
+  }
+
+  std::optional<NameId> find(std::string_view s) const {
+    if (slots.empty())
+      return std::nullopt;
+    NameId id = slots[slot_of(s, hash(s))].id;
+    if (id == EMPTY)
+      return std::nullopt;
+    return id;
+  }
+
+  // Valid until the next intern()
+  std::string_view str(NameId id) const {
+    uint32_t begin = id == 0 ? 0 : offsets[id - 1];
+    return std::string_view(chars).substr(begin, offsets[id] - begin);
+  }
+
+  size_t size() const { return offsets.size(); }
+  size_t bytes() const {
+    return chars.capacity() + offsets.capacity() * sizeof(uint32_t) +
+           slots.capacity() * sizeof(Slot);
+  }
+
+  // Serialized as its three arrays, so loading needs no rehashing.
+  // read() throws std::runtime_error on inconsistent input.
+  void write(BinaryWriter &w) const {
+    w.write_string(chars);
+    w.write_vector(offsets);
+    w.write_vector(slots);
+  }
+  static StringInterner read(MemoryReader &r) {
+    StringInterner s;
+    s.chars = r.read_string();
+    s.offsets = r.read_vector<uint32_t>();
+    s.slots = r.read_vector<Slot>();
+
+    bool ok = (s.slots.size() & (s.slots.size() - 1)) == 0 &&
+              (s.slots.empty() || s.slots.size() >= 2 * s.size());
+    uint32_t prev = 0;
+    for (uint32_t end : s.offsets) {
+      ok = ok && end >= prev && end <= s.chars.size();
+      prev = end;
+    }
+    size_t occupied = 0; // Leaves empty slots, so probing terminates
+    for (const Slot &slot : s.slots) {
+      ok = ok && slot.id >= EMPTY && slot.id < static_cast<NameId>(s.size());
+      occupied += slot.id != EMPTY;
+    }
+    if (!ok || occupied != s.size())
+      throw std::runtime_error("StringInterner: corrupt table");
+    return s;
+  }
+
+private:
+  static constexpr NameId EMPTY = -1;
+
+  struct Slot {
+    NameId id = EMPTY;
+    uint32_t hash = 0;
+  };
+
+  std::string chars;              // All strings back to back
+  std::vector<uint32_t> offsets;  // End of string i in 'chars'
+  std::vector<Slot> slots;        // Power-of-two sized, linear probing
+
+  static uint32_t hash(std::string_view s) {
+    return static_cast<uint32_t>(fast_hash(s.data(), s.size()));
+  }
+
+  // Slot holding 's', or the empty slot where it would go
+  size_t slot_of(std::string_view s, uint32_t h) const {
+    size_t mask = slots.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask)
+      if (slots[i].id == EMPTY ||
+          (slots[i].hash == h && str(slots[i].id) == s))
+        return i;
+  }
+
+  void grow() {
+    std::vector<Slot> old(std::max<size_t>(64, slots.size() * 2));
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const Slot &slot : old) {
+      if (slot.id == EMPTY)
+        continue;
+      size_t i = slot.hash & mask;
+      while (slots[i].id != EMPTY)
+        i = (i + 1) & mask;
+      slots[i] = slot;
+    }
+  }
+};
+
+} // namespace vfpga
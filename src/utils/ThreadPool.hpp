@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vfpga {
+
+// Work-stealing thread pool.
+// Each worker owns a deque. Tasks submitted from a worker go to the back of
+// its own deque (LIFO, cache friendly for nested work); tasks submitted from
+// outside are distributed round-robin. Idle workers steal from the front of
+// other workers' deques.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t num_threads = 0) {
+    if (num_threads == 0)
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    queues.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i)
+      queues.push_back(std::make_unique<WorkQueue>());
+
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i)
+      workers.emplace_back([this, i] { worker_loop(i); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers)
+      w.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t size() const { return workers.size(); }
+
+  // Queue a task and get a future for its result
+  template <typename F> auto submit(F &&fn) -> std::future<decltype(fn())> {
+    using R = decltype(fn());
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+    std::future<R> result = task->get_future();
+
+    size_t target = (current_worker_pool == this)
+                        ? current_worker_index
+                        : next_queue.fetch_add(1) % queues.size();
+    // Count the task before publishing it so a fast thief can never
+    // decrement 'pending' ahead of the increment.
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex);
+      ++pending;
+    }
+    {
+      std::lock_guard<std::mutex> lock(queues[target]->mutex);
+      queues[target]->tasks.emplace_back([task] { (*task)(); });
+    }
+    wake.notify_one();
+    return result;
+  }
+
+  // Run fn(i) for i in [begin, end) across the pool and wait for completion.
+  // Safe to call from inside a pool task: the caller helps drain the queues
+  // instead of blocking a worker.
+  template <typename F> void parallel_for(size_t begin, size_t end, F &&fn) {
+    std::vector<std::future<void>> futures;
+    futures.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i)
+      futures.push_back(submit([&fn, i] { fn(i); }));
+    for (auto &f : futures)
+      wait_helping(f);
+  }
+
+  // Wait on a future, executing queued tasks while it is not ready
+  template <typename T> void wait_helping(std::future<T> &f) {
+    while (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      if (!run_one(current_worker_pool == this ? current_worker_index : 0))
+        std::this_thread::yield();
+    }
+  }
+
+private:
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkQueue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> next_queue{0};
+
+  std::mutex wake_mutex;
+  std::condition_variable wake;
+  size_t pending = 0;
+  bool stopping = false;
+
+  static inline thread_local ThreadPool *current_worker_pool = nullptr;
+  static inline thread_local size_t current_worker_index = 0;
+
+  // Pop from own queue (back), else steal from others (front)
+  bool try_pop(size_t index, std::function<void()> &out) {
+    {
+      WorkQueue &own = *queues[index];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.tasks.empty()) {
+        out = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        return true;
+      }
+    }
+    for (size_t k = 1; k < queues.size(); ++k) {
+      WorkQueue &victim = *queues[(index + k) % queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        out = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool run_one(size_t index) {
+    std::function<void()> task;
+    if (!try_pop(index, task))
+      return false;
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex);
+      --pending;
+    }
+    task();
+    return true;
+  }
+
+  void worker_loop(size_t index) {
+    current_worker_pool = this;
+    current_worker_index = index;
+    while (true) {
+      if (run_one(index))
+        continue;
+      std::unique_lock<std::mutex> lock(wake_mutex);
+      wake.wait(lock, [this] { return stopping || pending > 0; });
+      if (stopping && pending == 0)
+        return;
+    }
+  }
+};
+
+} // namespace vfpga
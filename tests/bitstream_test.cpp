@@ -0,0 +1,333 @@
+#include "../src/cad/Assembler.hpp"
+#include "../src/cad/LogicBlock.hpp"
+#include "../src/fabric/BitstreamCompression.hpp"
+#include "../src/fabric/BitstreamDiff.hpp"
+#include "../src/fabric/BitstreamLoader.hpp"
+#include "../src/fabric/Fabric.hpp"
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace vfpga;
+
+// Two-tile oscillator: blk0 = NOT(blk1), blk1 = blk0
+void configure_oscillator(Fabric &fabric) {
+  std::vector<LogicBlock> blocks;
+  blocks.emplace_back(0, "inv");
+  blocks.back().use_lut = true;
+  blocks.back().use_dff = true;
+  blocks.back().lut_mask = Assembler::encode_mask(
+      {LogicState::L1, LogicState::L0}); // Y = !A
+  blocks.back().input_nets = {1};
+  blocks.back().output_net = 0;
+
+  blocks.emplace_back(1, "buf");
+  blocks.back().use_dff = true;
+  blocks.back().input_nets = {0};
+  blocks.back().output_net = 1;
+
+  std::map<int, std::pair<int, int>> placement = {{0, {0, 1}}, {1, {2, 4}}};
+  Assembler::assemble(fabric, blocks, placement);
+}
+
+void test_config_planes() {
+  std::cout << "Testing Config Planes..." << std::endl;
+
+  Fabric fabric(5, 5);
+  assert(fabric.lut_masks.size() == 25);
+  assert(fabric.mux_selects.size() == 25 * Fabric::LUT_INPUTS);
+  assert(fabric.bram_tile_count() == 5); // Column 3
+  assert(fabric.bram_slot(fabric.config_index(3, 2)) == 2);
+  assert(fabric.bram_slot(fabric.config_index(0, 0)) == -1);
+
+  configure_oscillator(fabric);
+  assert(fabric.lut_masks[fabric.config_index(0, 1)] == 0x5555);
+  assert(fabric.mux_selects[fabric.config_index(0, 1) * Fabric::LUT_INPUTS] ==
+         static_cast<int32_t>(fabric.config_index(2, 4) + 1));
+
+  fabric.reset();
+  LogicVal prev = fabric.get_output(0, 1);
+  assert(prev.is_0());
+  for (int cycle = 0; cycle < 6; ++cycle) {
+    fabric.step();
+    LogicVal a = fabric.get_output(0, 1);
+    // The ring holds two registers, so the inverter output has period 4
+    if (cycle % 2 == 0)
+      assert(a != prev);
+    else
+      assert(a == prev);
+    prev = a;
+  }
+
+  std::cout << "Config Planes Passed!" << std::endl;
+}
+
+void test_bitstream_roundtrip() {
+  std::cout << "Testing Bitstream Round Trip..." << std::endl;
+
+  std::string path =
+      (std::filesystem::temp_directory_path() / "vfpga_bitstream_test.bit")
+          .string();
+
+  Fabric original(5, 5);
+  configure_oscillator(original);
+  original.dff_init[original.config_index(2, 4)] =
+      static_cast<uint8_t>(LogicState::L1);
+  original.bram_init[2 * Fabric::BRAM_DEPTH + 7] = 0xA5;
+  assert(BitstreamLoader::save(path, original));
+
+  Fabric loaded(5, 5);
+  assert(BitstreamLoader::load(path, loaded));
+  auto a = original.config_image();
+  auto b = loaded.config_image();
+  assert(a.size() == b.size());
+  assert(std::memcmp(a.data(), b.data(), a.size()) == 0);
+
+  // Same behaviour after reset, including DFF and BRAM init
+  original.reset();
+  loaded.reset();
+  assert(loaded.get_output(2, 4).is_1());
+  assert(loaded.get_tile(3, 2).bram.memory[7][0].is_1());
+  assert(loaded.get_tile(3, 2).bram.memory[7][1].is_0());
+  for (int cycle = 0; cycle < 8; ++cycle) {
+    original.step();
+    loaded.step();
+    assert(original.get_output(0, 1) == loaded.get_output(0, 1));
+    assert(original.get_output(2, 4) == loaded.get_output(2, 4));
+  }
+
+  // Mapped planes are copy-on-write: editing them leaves the file alone
+  loaded.lut_masks[0] = 0x1234;
+  Fabric reloaded(5, 5);
+  assert(BitstreamLoader::load(path, reloaded));
+  assert(reloaded.lut_masks[0] == Fabric::LUT_PASSTHROUGH);
+
+  // Copies own their configuration
+  Fabric copy = loaded;
+  copy.lut_masks[0] = 0;
+  assert(loaded.lut_masks[0] == 0x1234);
+
+  // Saving over the file a fabric is mapped from is safe
+  assert(BitstreamLoader::save(path, loaded));
+  assert(loaded.lut_masks[0] == 0x1234);
+  assert(BitstreamLoader::load(path, reloaded));
+  assert(reloaded.lut_masks[0] == 0x1234);
+
+  // Dimension mismatch
+  Fabric other(6, 5);
+  assert(!BitstreamLoader::load(path, other));
+
+  // Corrupt payload
+  {
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(BitstreamHeader::SIZE);
+    f.put('\x7f');
+  }
+  assert(!BitstreamLoader::load(path, reloaded));
+  assert(BitstreamLoader::load(path, reloaded, false));
+
+  std::filesystem::remove(path);
+  std::cout << "Bitstream Round Trip Passed!" << std::endl;
+}
+
+void test_partial_reconfiguration() {
+  std::cout << "Testing Partial Reconfiguration..." << std::endl;
+
+  std::string path =
+      (std::filesystem::temp_directory_path() / "vfpga_partial_test.pbit")
+          .string();
+
+  // Running fabric: oscillator in columns 0 and 2
+  Fabric fabric(5, 5);
+  configure_oscillator(fabric);
+  fabric.reset();
+  fabric.step(); // inv = 1, buf = 0
+
+  // New region for column 4: a register following the inverter, reset to 1
+  Fabric region(5, 5);
+  Fabric::Frame frame = region.frame(4);
+  assert(frame.lut_masks.size() == 5);
+  assert(frame.bram_init.empty());
+  assert(region.frame(3).bram_init.size() == 5 * Fabric::BRAM_DEPTH);
+  frame.mux_selects[0] = static_cast<int32_t>(region.config_index(0, 1) + 1);
+  frame.dff_init[0] = static_cast<uint8_t>(LogicState::L1);
+  assert(BitstreamLoader::save_partial(path, region, {4}));
+
+  assert(BitstreamLoader::apply_partial(path, fabric));
+  assert(fabric.mux_selects[fabric.config_index(4, 0) * Fabric::LUT_INPUTS] ==
+         static_cast<int32_t>(fabric.config_index(0, 1) + 1));
+  // Only the reconfigured column was reset
+  assert(fabric.get_output(4, 0).is_1());
+  assert(fabric.get_output(0, 1).is_1());
+  assert(fabric.get_output(2, 4).is_0());
+
+  // The oscillator keeps running and the new register follows it
+  for (int cycle = 0; cycle < 6; ++cycle) {
+    LogicVal inv = fabric.get_output(0, 1);
+    fabric.step();
+    assert(fabric.get_output(4, 0) == inv);
+  }
+
+  // Mismatched fabrics and out-of-range frames are rejected untouched
+  Fabric other(6, 5);
+  assert(!BitstreamLoader::apply_partial(path, other));
+  assert(!BitstreamLoader::save_partial(path, region, {5}));
+
+  std::filesystem::remove(path);
+  std::cout << "Partial Reconfiguration Passed!" << std::endl;
+}
+
+void test_compressed_bitstream() {
+  std::cout << "Testing Compressed Bitstream..." << std::endl;
+
+  auto dir = std::filesystem::temp_directory_path();
+  std::string raw_path = (dir / "vfpga_raw_test.bit").string();
+  std::string packed_path = (dir / "vfpga_compressed_test.bit").string();
+
+  // Sparse 40x40 fabric: the oscillator, a few repeated masks and a BRAM
+  Fabric original(40, 40);
+  configure_oscillator(original);
+  for (int y = 0; y < 40; y += 3)
+    original.lut_masks[original.config_index(20, y)] = 0x8000;
+  original.lut_masks[original.config_index(21, 5)] = 0x6996;
+  original.dff_init[original.config_index(22, 7)] =
+      static_cast<uint8_t>(LogicState::L1);
+  original.bram_init[3 * Fabric::BRAM_DEPTH + 100] = 0x5A;
+  original.bram_init[3 * Fabric::BRAM_DEPTH + 101] = 0x01;
+
+  assert(BitstreamLoader::save(raw_path, original));
+  assert(BitstreamLoader::save(packed_path, original, true));
+  auto raw_size = std::filesystem::file_size(raw_path);
+  auto packed_size = std::filesystem::file_size(packed_path);
+  std::cout << "Raw " << raw_size << " bytes, compressed " << packed_size
+            << " bytes" << std::endl;
+  assert(packed_size * 20 < raw_size);
+
+  // Decoding reproduces the image exactly
+  Fabric loaded(40, 40);
+  loaded.lut_masks[0] = 0x1234; // Stale configuration must not survive
+  assert(BitstreamLoader::load(packed_path, loaded));
+  auto a = original.config_image();
+  auto b = loaded.config_image();
+  assert(std::memcmp(a.data(), b.data(), a.size()) == 0);
+
+  original.reset();
+  loaded.reset();
+  for (int cycle = 0; cycle < 4; ++cycle) {
+    original.step();
+    loaded.step();
+    assert(original.get_output(0, 1) == loaded.get_output(0, 1));
+  }
+
+  // Empty and fully dense fabrics round-trip too
+  Fabric empty(12, 12), dense(12, 12);
+  for (size_t i = 0; i < dense.lut_masks.size(); ++i) {
+    dense.lut_masks[i] = static_cast<uint16_t>(i * 7919);
+    dense.dff_init[i] = static_cast<uint8_t>(i % 3);
+  }
+  for (size_t i = 0; i < dense.mux_selects.size(); ++i)
+    dense.mux_selects[i] = static_cast<int32_t>(i % 145);
+  for (Fabric *f : {&empty, &dense}) {
+    Fabric copy(12, 12);
+    assert(BitstreamLoader::save(packed_path, *f, true));
+    assert(BitstreamLoader::load(packed_path, copy));
+    assert(std::memcmp(f->config_image().data(), copy.config_image().data(),
+                       f->config_image().size()) == 0);
+  }
+
+  // A corrupt body leaves the previous configuration in place
+  {
+    std::fstream f(packed_path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(static_cast<std::streamoff>(sizeof(CompressedBitstreamHeader)) + 40);
+    f.put('\x55');
+  }
+  Fabric target(12, 12);
+  target.lut_masks[5] = 0x4242;
+  assert(!BitstreamLoader::load(packed_path, target));
+  assert(target.lut_masks[5] == 0x4242);
+
+  std::filesystem::remove(raw_path);
+  std::filesystem::remove(packed_path);
+  std::cout << "Compressed Bitstream Passed!" << std::endl;
+}
+
+void test_readback_and_diff() {
+  std::cout << "Testing Readback and Diff..." << std::endl;
+
+  auto dir = std::filesystem::temp_directory_path();
+  std::string raw_path = (dir / "vfpga_readback_test.bit").string();
+  std::string packed_path = (dir / "vfpga_readback_test.cbit").string();
+
+  Fabric fabric(9, 6);
+  configure_oscillator(fabric);
+
+  // Readback bytes are a valid bitstream of the current configuration
+  std::vector<std::byte> bytes = BitstreamLoader::readback(fabric);
+  {
+    std::ofstream out(raw_path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+  }
+  assert(BitstreamLoader::save(packed_path, fabric, true));
+
+  auto from_raw = BitstreamLoader::read(raw_path);
+  auto from_packed = BitstreamLoader::read(packed_path);
+  assert(from_raw && from_packed);
+  assert(from_raw->width == 9 && from_raw->height == 6);
+  assert(BitstreamDiff::compare(*from_raw, *from_packed).identical());
+
+  ConfigSnapshot reference = BitstreamLoader::snapshot(fabric);
+  ConfigDiff same = BitstreamDiff::compare(reference, *from_raw);
+  assert(same.identical());
+  assert(same.frames_compared == 9);
+
+  // Reconfigure a LUT, a route and a BRAM word; only those tiles differ
+  fabric.lut_masks[fabric.config_index(5, 2)] = 0x0001;
+  fabric.mux_selects[fabric.config_index(8, 5) * Fabric::LUT_INPUTS + 3] = 1;
+  fabric.frame(3).bram_init[4 * Fabric::BRAM_DEPTH + 9] = 0xFF;
+  auto digests = BitstreamDiff::frame_digests(reference);
+  ConfigDiff diff = BitstreamDiff::compare(
+      reference, digests, BitstreamLoader::snapshot(fabric));
+  assert(!diff.identical());
+  assert(diff.frames_different == 3);
+  assert(diff.tiles.size() == 3);
+  assert(diff.tiles[0].x == 3 && diff.tiles[0].y == 4 &&
+         diff.tiles[0].bram_init && !diff.tiles[0].lut_mask);
+  assert(diff.tiles[1].x == 5 && diff.tiles[1].y == 2 &&
+         diff.tiles[1].lut_mask && !diff.tiles[1].routing);
+  assert(diff.tiles[2].x == 8 && diff.tiles[2].y == 5 &&
+         diff.tiles[2].routing && !diff.tiles[2].dff_init);
+
+  // State capture records the running registers in the DFF section. After
+  // one cycle the inverter at (0, 1) and the constant-1 LUT at (5, 2) hold 1.
+  fabric.reset();
+  fabric.step();
+  ConfigDiff captured = BitstreamDiff::compare(
+      BitstreamLoader::snapshot(fabric),
+      BitstreamLoader::snapshot(fabric, true));
+  assert(captured.tiles.size() == 2);
+  assert(captured.tiles[0].x == 0 && captured.tiles[0].y == 1 &&
+         captured.tiles[0].dff_init);
+  assert(captured.tiles[1].x == 5 && captured.tiles[1].y == 2 &&
+         captured.tiles[1].dff_init);
+
+  // Different dimensions are reported, not compared
+  assert(!BitstreamDiff::compare(reference,
+                                 BitstreamLoader::snapshot(Fabric(9, 7)))
+              .compatible);
+
+  std::filesystem::remove(raw_path);
+  std::filesystem::remove(packed_path);
+  std::cout << "Readback and Diff Passed!" << std::endl;
+}
+
+int main() {
+  test_config_planes();
+  test_bitstream_roundtrip();
+  test_partial_reconfiguration();
+  test_compressed_bitstream();
+  test_readback_and_diff();
+  return 0;
+}
@@ -3,7 +3,13 @@
 #include "../src/cad/Placer.hpp"
 #include "../src/cad/Router.hpp"
 #include "../src/fabric/Fabric.hpp"
+#include "../src/flow/Flow.hpp"
+#include "../src/flow/FlowCache.hpp"
+#include "../src/utils/ThreadPool.hpp"
+#include <algorithm>
 #include <cassert>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
 using namespace vfpga;
@@ -21,7 +27,7 @@ void test_full_flow() {
   }
   assert(netlist_opt.has_value());
   const Netlist &netlist = netlist_opt.value();
-  std::cout << "[Step 1] Parsed " << netlist.cells.size() << " cells."
+  std::cout << "[Step 1] Parsed " << netlist.num_cells() << " cells."
             << std::endl;
 
   // 3. Pack
@@ -45,7 +51,223 @@ void test_full_flow() {
   std::cout << "Full CAD Flow Passed!" << std::endl;
 }
 
+void test_flow_driver() {
+  std::cout << "Testing Flow Driver..." << std::endl;
+
+  FlowOptions options;
+  options.netlist_path = "tests/data/test_design.json";
+  if (!std::filesystem::exists(options.netlist_path)) {
+    options.netlist_path = "../tests/data/test_design.json";
+  }
+  options.seed = 42;
+  options.sim_cycles = 100;
+  options.optimize = false; // The optimizer folds the whole design away
+
+  // Same seed must give the same placement, even when run concurrently
+  ThreadPool pool(4);
+  auto a = pool.submit([&] { return Flow::run(options); });
+  auto b = pool.submit([&] { return Flow::run(options); });
+  FlowReport ra = a.get();
+  FlowReport rb = b.get();
+  assert(ra.success && rb.success);
+  assert(ra.hpwl == rb.hpwl);
+  assert(ra.num_blocks == 2);
+  assert(ra.routing_iterations >= 1);
+  assert(ra.fmax_mhz > 0);
+
+  // Optimized, nothing drives the output but a constant
+  options.optimize = true;
+  FlowReport optimized = Flow::run(options);
+  assert(optimized.success);
+  assert(optimized.num_cells == 2 && optimized.cells_removed == 2);
+  assert(optimized.num_blocks == 0);
+
+  // A tiny memory cap rejects the job before anything is built
+  options.memory_cap_bytes = 1024;
+  FlowReport capped = Flow::run(options);
+  assert(!capped.success);
+  assert(capped.error.find("memory cap") != std::string::npos);
+
+  std::cout << "Flow Driver Passed!" << std::endl;
+}
+
+void test_flow_configures_luts() {
+  std::cout << "Testing Flow LUT Configuration..." << std::endl;
+
+  // A register fed back through a NOT LUT toggles every cycle, which it
+  // only does if the flow writes the LUT mask and input mux into the fabric
+  FlowOptions options;
+  options.netlist_path = "tests/data/toggle_design.json";
+  if (!std::filesystem::exists(options.netlist_path)) {
+    options.netlist_path = "../tests/data/toggle_design.json";
+  }
+  options.seed = 3;
+
+  options.sim_cycles = 1;
+  FlowReport odd = Flow::run(options);
+  assert(odd.success);
+  assert(odd.num_blocks == 1);
+  assert(odd.sim_registers_high == 1);
+
+  options.sim_cycles = 2;
+  FlowReport even = Flow::run(options);
+  assert(even.success);
+  assert(even.sim_registers_high == 0);
+
+  std::cout << "Flow LUT Configuration Passed!" << std::endl;
+}
+
+void test_flow_constant_register() {
+  std::cout << "Testing Flow Constant Register..." << std::endl;
+
+  // A register with D tied to 1 loads it on the first clock, optimized or
+  // not
+  FlowOptions options;
+  options.netlist_path = "tests/data/const_design.json";
+  if (!std::filesystem::exists(options.netlist_path)) {
+    options.netlist_path = "../tests/data/const_design.json";
+  }
+  options.seed = 3;
+  options.sim_cycles = 10;
+  for (bool optimize : {true, false}) {
+    options.optimize = optimize;
+    FlowReport report = Flow::run(options);
+    assert(report.success);
+    assert(report.num_blocks == 1);
+    assert(report.sim_registers_high == 1);
+  }
+
+  std::cout << "Flow Constant Register Passed!" << std::endl;
+}
+
+void test_flow_cache() {
+  std::cout << "Testing Flow Cache..." << std::endl;
+
+  FlowOptions options;
+  options.netlist_path = "tests/data/test_design.json";
+  if (!std::filesystem::exists(options.netlist_path)) {
+    options.netlist_path = "../tests/data/test_design.json";
+  }
+  options.seed = 7;
+  options.sim_cycles = 10;
+  options.cache_dir =
+      (std::filesystem::temp_directory_path() / "vfpga_flow_cache_test")
+          .string();
+  std::filesystem::remove_all(options.cache_dir);
+
+  // Cold cache: every stage runs
+  FlowReport cold = Flow::run(options);
+  assert(cold.success);
+  assert(!cold.netlist_cached && !cold.pack_cached && !cold.place_cached &&
+         !cold.route_cached);
+
+  // Warm cache: identical results without recomputing anything
+  FlowReport warm = Flow::run(options);
+  assert(warm.success);
+  assert(warm.pack_cached && warm.place_cached && warm.route_cached);
+  assert(warm.num_cells == cold.num_cells);
+  assert(warm.num_blocks == cold.num_blocks);
+  assert(warm.hpwl == cold.hpwl);
+  assert(warm.routing_iterations == cold.routing_iterations);
+
+  // A new seed reuses the packed netlist but re-places and re-routes
+  options.seed = 8;
+  FlowReport reseeded = Flow::run(options);
+  assert(reseeded.success);
+  assert(reseeded.pack_cached && !reseeded.place_cached &&
+         !reseeded.route_cached);
+
+  // Without the packed blocks, the netlist image replaces parsing
+  for (const auto &entry :
+       std::filesystem::directory_iterator(options.cache_dir))
+    if (entry.path().extension() == ".pack")
+      std::filesystem::remove(entry.path());
+  FlowReport repacked = Flow::run(options);
+  assert(repacked.success);
+  assert(repacked.netlist_cached && !repacked.pack_cached);
+  assert(repacked.num_blocks == reseeded.num_blocks);
+  assert(repacked.hpwl == reseeded.hpwl);
+
+  std::filesystem::remove_all(options.cache_dir);
+  std::cout << "Flow Cache Passed!" << std::endl;
+}
+
+void test_netlist_image() {
+  std::cout << "Testing Netlist Image..." << std::endl;
+
+  auto parsed = Parser::from_json("tests/data/test_design.json");
+  if (!parsed)
+    parsed = Parser::from_json("../tests/data/test_design.json");
+  assert(parsed);
+  const Netlist &a = *parsed;
+
+  std::string dir =
+      (std::filesystem::temp_directory_path() / "vfpga_netlist_image_test")
+          .string();
+  std::filesystem::remove_all(dir);
+  FlowCache cache(dir);
+  assert(!cache.load_netlist(1)); // Plain miss
+  assert(cache.store_netlist(1, a));
+  auto loaded = cache.load_netlist(1);
+  assert(loaded);
+  const Netlist &b = *loaded;
+
+  assert(b.inputs == a.inputs && b.outputs == a.outputs);
+  assert(b.num_cells() == a.num_cells() && b.num_pins() == a.num_pins() &&
+         b.num_nets() == a.num_nets());
+  for (CellId c = 0; c < static_cast<CellId>(a.num_cells()); ++c) {
+    assert(b.cell_name(c) == a.cell_name(c));
+    assert(b.cell_type(c) == a.cell_type(c));
+    assert(b.find_cell(a.cell_name(c)) == c);
+    assert(b.params(c).size() == a.params(c).size());
+    for (const auto &p : a.params(c))
+      assert(*b.param(c, a.name(p.key)) == p.value);
+    for (PinId p = a.first_pin(c); p < a.end_pin(c); ++p) {
+      assert(b.pin_name(p) == a.pin_name(p));
+      assert(std::ranges::equal(b.nets_of(p), a.nets_of(p)));
+    }
+  }
+  for (NetId n = 0; n < static_cast<NetId>(a.num_nets()); ++n) {
+    assert(b.net_bit(n) == a.net_bit(n) && b.find_net(a.net_bit(n)) == n);
+    assert(b.driver(n) == a.driver(n) && b.fanout(n) == a.fanout(n));
+    std::vector<PinId> sa, sb;
+    for (PinId p : a.sinks(n))
+      sa.push_back(p);
+    for (PinId p : b.sinks(n))
+      sb.push_back(p);
+    assert(sa == sb);
+  }
+  // The loaded netlist is an ordinary one that can still grow
+  Netlist grown = b;
+  grown.add_cell("extra", "DFF");
+  assert(grown.find_cell("extra") && !b.find_cell("extra"));
+
+  // Truncated or corrupted images are rejected, not trusted
+  std::string path;
+  for (const auto &entry : std::filesystem::directory_iterator(dir))
+    path = entry.path().string();
+  auto size = std::filesystem::file_size(path);
+  std::filesystem::resize_file(path, size / 2);
+  assert(!cache.load_netlist(1));
+  assert(cache.store_netlist(1, a));
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(size - 16));
+    const char junk[8] = {0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f};
+    file.write(junk, sizeof(junk));
+  }
+  assert(!cache.load_netlist(1));
+
+  std::filesystem::remove_all(dir);
+  std::cout << "Netlist Image Passed!" << std::endl;
+}
+
 int main() {
   test_full_flow();
+  test_flow_driver();
+  test_flow_configures_luts();
+  test_flow_constant_register();
+  test_flow_cache();
+  test_netlist_image();
   return 0;
 }
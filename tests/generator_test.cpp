@@ -0,0 +1,124 @@
+#include "../src/cad/Packer.hpp"
+#include "../src/cad/Parser.hpp"
+#include "../src/gen/DesignGenerator.hpp"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace vfpga;
+
+namespace {
+
+// Round-trip generated JSON through the real parser via a temp file
+Netlist parse_generated(const std::string &json_text, const std::string &tag) {
+  auto path = std::filesystem::temp_directory_path() /
+              ("vfpga_generator_test_" + tag + ".json");
+  {
+    std::ofstream out(path);
+    out << json_text;
+  }
+  auto netlist = Parser::from_json(path.string());
+  std::filesystem::remove(path);
+  assert(netlist.has_value());
+  return *netlist;
+}
+
+size_t count_type(const Netlist &netlist, const std::string &type) {
+  size_t n = 0;
+  for (CellId c = 0; c < static_cast<CellId>(netlist.num_cells()); ++c)
+    if (netlist.cell_type(c) == type)
+      ++n;
+  return n;
+}
+
+} // namespace
+
+void test_random_design() {
+  std::cout << "Testing Random Design Generator..." << std::endl;
+
+  GeneratorOptions options;
+  options.num_cells = 500;
+  options.lut_dff_ratio = 4.0;
+  options.num_brams = 2;
+  options.num_dsps = 3;
+  options.logic_depth = 5;
+  options.seed = 7;
+
+  std::ostringstream a, b;
+  DesignGenerator::random(a, options);
+  DesignGenerator::random(b, options);
+  assert(a.str() == b.str()); // Deterministic for a given seed
+
+  Netlist netlist = parse_generated(a.str(), "random");
+  assert(netlist.num_cells() == 500 + 2 + 3);
+  assert(count_type(netlist, "DFF") == 100);
+  assert(count_type(netlist, "$lut") == 400);
+  assert(count_type(netlist, "BRAM") == 2);
+  assert(count_type(netlist, "$mul") == 3);
+  assert(netlist.inputs.size() == 2); // clk + in
+  assert(netlist.outputs.size() == 1);
+
+  // Every LUT has all K inputs connected
+  for (CellId c = 0; c < static_cast<CellId>(netlist.num_cells()); ++c) {
+    if (netlist.cell_type(c) == "$lut") {
+      assert(*netlist.param(c, "WIDTH") == "4");
+      assert(netlist.param(c, "LUT")->size() == 16);
+      assert(netlist.nets_of(*netlist.find_pin(c, "A")).size() == 4);
+      assert(netlist.net_of(*netlist.find_pin(c, "Y")) != NO_NET);
+    }
+  }
+
+  // A register fed only by a LUT shares the LUT's block
+  std::vector<LogicBlock> blocks = Packer::pack(netlist);
+  size_t fused = 0;
+  for (const auto &block : blocks)
+    fused += block.use_lut && block.use_dff;
+  assert(blocks.size() + fused == netlist.num_cells());
+  PackerOptions separate;
+  separate.fuse_lut_dff = false;
+  assert(Packer::pack(netlist, separate).size() == netlist.num_cells());
+
+  std::cout << "Random Design Generator Passed!" << std::endl;
+}
+
+void test_classic_circuits() {
+  std::cout << "Testing Classic Circuits..." << std::endl;
+
+  std::ostringstream counter;
+  DesignGenerator::counter(counter, 8);
+  Netlist c = parse_generated(counter.str(), "counter");
+  assert(count_type(c, "DFF") == 8);
+  assert(count_type(c, "$lut") == 8 + 6); // 8 next-state + 6 carry
+
+  std::ostringstream lfsr;
+  DesignGenerator::lfsr(lfsr, 16);
+  Netlist l = parse_generated(lfsr.str(), "lfsr");
+  assert(count_type(l, "DFF") == 16);
+  assert(count_type(l, "$lut") == 1);
+
+  std::ostringstream adder;
+  DesignGenerator::adder(adder, 8);
+  Netlist a = parse_generated(adder.str(), "adder");
+  assert(count_type(a, "$lut") == 2 * 8); // Half adder + 7 full adders
+
+  std::ostringstream mult;
+  DesignGenerator::multiplier(mult, 4);
+  Netlist m = parse_generated(mult.str(), "mult");
+  assert(count_type(m, "$lut") > 16); // 16 partial products plus adders
+
+  std::ostringstream fir;
+  DesignGenerator::fir(fir, 4, 8);
+  Netlist f = parse_generated(fir.str(), "fir");
+  assert(count_type(f, "$mul") == 4);
+  assert(count_type(f, "DFF") >= 3 * 8);
+
+  std::cout << "Classic Circuits Passed!" << std::endl;
+}
+
+int main() {
+  test_random_design();
+  test_classic_circuits();
+  return 0;
+}
@@ -18,16 +18,13 @@ void test_hard_block_placement() {
   Netlist netlist;
 
   // BRAM Cell
-  std::shared_ptr<Cell> bram_cell = std::make_shared<Cell>("my_bram", "$mem");
-  netlist.cells["my_bram"] = bram_cell;
+  netlist.add_cell("my_bram", "$mem");
 
   // DSP Cell
-  std::shared_ptr<Cell> dsp_cell = std::make_shared<Cell>("my_dsp", "$mul");
-  netlist.cells["my_dsp"] = dsp_cell;
+  netlist.add_cell("my_dsp", "$mul");
 
   // CLB Cell
-  std::shared_ptr<Cell> clb_cell = std::make_shared<Cell>("my_lut", "$lut");
-  netlist.cells["my_lut"] = clb_cell;
+  netlist.add_cell("my_lut", "$lut");
 
   // 3. Pack
   Packer packer;
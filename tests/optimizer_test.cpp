@@ -0,0 +1,173 @@
+#include "../src/cad/LutMask.hpp"
+#include "../src/cad/Optimizer.hpp"
+#include "../src/cad/Parser.hpp"
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace vfpga;
+
+void add_lut(Netlist &n, const std::string &name, std::vector<int> inputs,
+             const std::string &mask, int output) {
+  CellId c = n.add_cell(name, "$lut");
+  n.add_param(c, "WIDTH", std::to_string(inputs.size()));
+  n.add_param(c, "LUT", mask);
+  n.add_pin(c, "A", PortDirection::INPUT, inputs);
+  n.add_pin(c, "Y", PortDirection::OUTPUT, std::vector<int>{output});
+}
+
+// Values of the output port bits of a netlist of LUTs listed in
+// topological order, for input port bits taken from 'inputs'
+std::vector<bool> evaluate(const Netlist &n, unsigned inputs) {
+  std::map<int, bool> value{{0, false}, {1, true}};
+  int next_input = 0;
+  for (size_t i = 0; i < n.num_ports(); ++i)
+    if (n.port(i).direction == PortDirection::INPUT)
+      for (NetId net : n.port_nets(i))
+        value[n.net_bit(net)] = (inputs >> next_input++) & 1;
+
+  auto bit_of = [&](NetId net) {
+    return net == CONST0_NET ? 0 : net == CONST1_NET ? 1 : n.net_bit(net);
+  };
+  for (CellId c = 0; c < static_cast<CellId>(n.num_cells()); ++c) {
+    if (n.cell_type(c) != "$lut")
+      continue;
+    auto a = n.find_pin(c, "A");
+    auto nets = a ? n.nets_of(*a) : std::span<const NetId>();
+    uint64_t mask = *LutMask::parse(*n.param(c, "LUT"), nets.size());
+    uint64_t index = 0;
+    for (size_t k = 0; k < nets.size(); ++k)
+      index |= uint64_t{value.at(bit_of(nets[k]))} << k;
+    value[bit_of(n.nets_of(*n.find_pin(c, "Y"))[0])] = (mask >> index) & 1;
+  }
+
+  std::vector<bool> out;
+  for (size_t i = 0; i < n.num_ports(); ++i)
+    if (n.port(i).direction == PortDirection::OUTPUT)
+      for (NetId net : n.port_nets(i))
+        out.push_back(value.at(bit_of(net)));
+  return out;
+}
+
+void test_lut_mask() {
+  std::cout << "Testing LUT Masks..." << std::endl;
+
+  assert(LutMask::parse("0110", 2) == 0b0110u);
+  assert(LutMask::parse("6", 2) == 0b0110u); // JSON number
+  assert(LutMask::parse("00000110", 2) == 0b0110u);
+  assert(!LutMask::parse("01x0", 2));
+  assert(!LutMask::parse("0", 7));
+  assert(LutMask::format(0b1000, 2) == "1000");
+
+  const uint64_t XOR2 = 0b0110, AND2 = 0b1000, MUX = 0b11001010;
+  assert(LutMask::cofactor(XOR2, 2, 1, true) == 0b01); // NOT
+  assert(LutMask::cofactor(AND2, 2, 0, false) == 0);
+  assert(LutMask::depends_on(MUX, 3, 2) && LutMask::depends_on(MUX, 3, 0));
+  assert(!LutMask::depends_on(0b1010, 2, 1));
+  assert(LutMask::merge_inputs(XOR2, 2, 0, 1) == 0);    // a ^ a
+  assert(LutMask::merge_inputs(AND2, 2, 0, 1) == 0b10); // a & a
+  // s ? b : a with a and b exchanged is s ? a : b
+  assert(LutMask::swap_inputs(MUX, 3, 0) == 0b10101100);
+
+  std::cout << "LUT Masks Passed!" << std::endl;
+}
+
+void test_optimizer() {
+  std::cout << "Testing Optimizer..." << std::endl;
+
+  Netlist n;
+  n.add_port("a", PortDirection::INPUT, std::vector<int>{2});
+  n.add_port("b", PortDirection::INPUT, std::vector<int>{3});
+  n.add_port("c", PortDirection::INPUT, std::vector<int>{4});
+  add_lut(n, "and_one", {2, 1}, "1000", 5);  // a & 1 = a
+  add_lut(n, "and_zero", {2, 0}, "1000", 6); // a & 0 = 0
+  add_lut(n, "or", {5, 6}, "1110", 7);        // a | 0 = a
+  add_lut(n, "twice", {3, 3}, "1000", 8);    // b & b = b
+  add_lut(n, "ignore", {8, 4}, "1010", 9);   // b regardless of c
+  add_lut(n, "xor1", {7, 9}, "0110", 10);
+  add_lut(n, "xor2", {9, 7}, "0110", 11); // Same function as xor1
+  add_lut(n, "mux", {10, 11, 4}, "11001010", 12); // c ? xor2 : xor1
+  add_lut(n, "dead", {2, 3}, "0001", 13);
+  CellId ff = n.add_cell("dead_ff", "DFF");
+  n.add_pin(ff, "D", PortDirection::INPUT, std::vector<int>{13});
+  n.add_pin(ff, "C", PortDirection::INPUT, std::vector<int>{2});
+  n.add_pin(ff, "Q", PortDirection::OUTPUT, std::vector<int>{14});
+  add_lut(n, "observed", {2, 3}, "0111", 15);
+  CellId custom = n.add_cell("probe", "CUSTOM"); // Unknown types are kept
+  n.add_pin(custom, "I", PortDirection::INPUT, std::vector<int>{15});
+  n.add_port("y", PortDirection::OUTPUT, std::vector<int>{12, 11, 6});
+
+  OptimizerStats stats;
+  Netlist opt = Optimizer::optimize(n, {}, &stats);
+  assert(stats.cells_before == 12);
+  assert(stats.constant_inputs == 3); // and_one, and_zero, or
+  assert(stats.constant_luts == 1);   // and_zero
+  assert(stats.pruned_inputs == 5);   // and_zero, twice, ignore, mux (2)
+  assert(stats.buffers == 5);         // and_one, or, twice, ignore, mux
+  assert(stats.merged_luts == 1);     // xor2
+  assert(stats.swept_cells == 2);     // dead, dead_ff
+  assert(stats.cells_after == 3 && opt.num_cells() == 3);
+  assert(stats.cells_removed() == 9);
+
+  // xor1 survives with its inputs rewired to the ports; the output port
+  // bits follow the merged and constant nets
+  CellId x = *opt.find_cell("xor1");
+  auto inputs = opt.nets_of(*opt.find_pin(x, "A"));
+  assert(inputs.size() == 2);
+  assert(opt.net_bit(inputs[0]) == 2 && opt.net_bit(inputs[1]) == 3);
+  assert(*opt.param(x, "LUT") == "0110" && *opt.param(x, "WIDTH") == "2");
+  auto y = opt.port_nets(opt.num_ports() - 1);
+  assert(opt.net_bit(y[0]) == 10 && opt.net_bit(y[1]) == 10);
+  assert(y[2] == CONST0_NET);
+  assert(opt.find_cell("observed") && opt.find_cell("probe"));
+
+  // Same function on every input vector
+  for (unsigned v = 0; v < 8; ++v)
+    assert(evaluate(n, v) == evaluate(opt, v));
+
+  // Every pass can be turned off
+  OptimizerOptions off;
+  off.constant_propagation = off.remove_buffers = off.prune_inputs =
+      off.structural_hashing = off.sweep = false;
+  Netlist same = Optimizer::optimize(n, off, &stats);
+  assert(same.num_cells() == n.num_cells() && stats.cells_removed() == 0);
+
+  OptimizerOptions hash_only = off;
+  hash_only.structural_hashing = true;
+  Netlist hashed = Optimizer::optimize(n, hash_only, &stats);
+  assert(stats.merged_luts == 1); // xor2
+  assert(hashed.num_cells() == 11);
+  for (unsigned v = 0; v < 8; ++v)
+    assert(evaluate(n, v) == evaluate(hashed, v));
+
+  // The test design's LUT computes clk ^ clk, which leaves nothing for the
+  // observed output but a constant
+  auto design = Parser::from_json("tests/data/test_design.json");
+  if (!design)
+    design = Parser::from_json("../tests/data/test_design.json");
+  assert(design);
+  Netlist folded = Optimizer::optimize(*design, {}, &stats);
+  assert(stats.constant_luts == 1 && stats.swept_cells == 1);
+  assert(folded.num_cells() == 0);
+  assert(folded.num_ports() == 2 && folded.port_name(1) == "led");
+  assert(folded.port_nets(1)[0] == CONST0_NET);
+
+  // The toggle design's register has no port_directions, so its Q pin is
+  // inout; it drives the output and keeps the LUT feeding it alive
+  auto toggle = Parser::from_json("tests/data/toggle_design.json");
+  if (!toggle)
+    toggle = Parser::from_json("../tests/data/toggle_design.json");
+  assert(toggle);
+  Netlist kept = Optimizer::optimize(*toggle, {}, &stats);
+  assert(stats.cells_removed() == 0);
+  assert(kept.num_cells() == 2 && kept.find_cell("fd"));
+
+  std::cout << "Optimizer Passed!" << std::endl;
+}
+
+int main() {
+  test_lut_mask();
+  test_optimizer();
+  return 0;
+}
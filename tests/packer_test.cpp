@@ -1,7 +1,12 @@
+#include "../src/cad/Assembler.hpp"
 #include "../src/cad/Packer.hpp"
 #include "../src/cad/Parser.hpp"
+#include "../src/cad/Placer.hpp"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
 
 using namespace vfpga;
 
@@ -21,6 +26,11 @@ void test_packer() {
 
   assert(blocks.size() == 2);
 
+  // Nets are identified by their Yosys bit number
+  NetId net_2 = *netlist.find_net(2);
+  NetId net_3 = *netlist.find_net(3);
+  NetId net_4 = *netlist.find_net(4);
+
   bool found_lut = false;
   bool found_dff = false;
 
@@ -30,18 +40,16 @@ void test_packer() {
       // The LUT in test_design.json connects A to net_2 (clk)
       // But wait, in test_design.json: "A": [ 2, 2 ]
       // net[2] is "clk".
-      // So input_nets should contain "net_2".
-
-      // Note: In parsing, connections are mapped to "net_2" strings.
+      // So input_nets should contain net_2.
       bool has_net_2 = false;
       for (const auto &net : block.input_nets) {
-        if (net == "net_2")
+        if (net == net_2)
           has_net_2 = true;
       }
       assert(has_net_2);
 
       // Output Y -> net_3
-      assert(block.output_net == "net_3");
+      assert(block.output_net == net_3);
     }
 
     if (block.use_dff) {
@@ -49,12 +57,12 @@ void test_packer() {
       // DFF connects D -> net_3, Q -> net_4, C -> net_2
       bool d_is_net_3 = false;
       for (const auto &net : block.input_nets) {
-        if (net == "net_3")
+        if (net == net_3)
           d_is_net_3 = true;
       }
       assert(d_is_net_3);
-      assert(block.output_net == "net_4");
-      assert(block.clock_net == "net_2");
+      assert(block.output_net == net_4);
+      assert(block.clock_net == net_2);
     }
   }
 
@@ -64,7 +72,259 @@ void test_packer() {
   std::cout << "Packer Tests Passed!" << std::endl;
 }
 
+void add_lut(Netlist &n, const std::string &name, std::vector<int> inputs,
+             int output, const std::string &mask = "0110") {
+  CellId c = n.add_cell(name, "$lut");
+  n.add_param(c, "LUT", mask);
+  n.add_pin(c, "A", PortDirection::INPUT, inputs);
+  n.add_pin(c, "Y", PortDirection::OUTPUT, std::vector<int>{output});
+}
+
+void add_dff(Netlist &n, const std::string &name, int d, int q) {
+  CellId c = n.add_cell(name, "DFF");
+  n.add_pin(c, "C", PortDirection::INPUT, std::vector<int>{2});
+  n.add_pin(c, "D", PortDirection::INPUT, std::vector<int>{d});
+  n.add_pin(c, "Q", PortDirection::OUTPUT, std::vector<int>{q});
+}
+
+void test_lut_dff_fusion() {
+  std::cout << "Testing LUT+DFF Fusion..." << std::endl;
+
+  Netlist n;
+  n.add_port("in", PortDirection::INPUT, std::vector<int>{3, 4});
+  add_lut(n, "l0", {3, 4}, 5);
+  add_dff(n, "r0", 5, 6); // Only reader of l0: one LE
+  add_lut(n, "l1", {6, 3}, 7);
+  add_dff(n, "r1", 7, 8);
+  add_lut(n, "l2", {7, 8}, 9); // Also reads l1
+  add_lut(n, "l3", {6, 9}, 10);
+  add_dff(n, "r3", 10, 11); // l3 is observed at a port
+  n.add_port("out", PortDirection::OUTPUT, std::vector<int>{10, 11});
+
+  std::vector<LogicBlock> blocks = Packer::pack(n);
+  assert(blocks.size() == 6);
+  const LogicBlock &le = blocks[0];
+  assert(le.name == "r0" && le.use_lut && le.use_dff);
+  assert(!le.input_nets.empty());
+  for (NetId net : le.input_nets) // The LUT's inputs
+    assert(net == *n.find_net(3) || net == *n.find_net(4));
+  assert(le.output_net == *n.find_net(6));
+  assert(le.clock_net == *n.find_net(2));
+  for (size_t i = 1; i < blocks.size(); ++i)
+    assert(blocks[i].use_lut != blocks[i].use_dff);
+  for (size_t i = 0; i < blocks.size(); ++i)
+    assert(blocks[i].id == static_cast<int>(i));
+
+  PackerOptions separate;
+  separate.fuse_lut_dff = false;
+  assert(Packer::pack(n, separate).size() == n.num_cells());
+
+  std::cout << "LUT+DFF Fusion Passed!" << std::endl;
+}
+
+void test_clustering() {
+  std::cout << "Testing Clustering..." << std::endl;
+
+  // Three groups of four LEs; each group shares its own nets
+  std::vector<LogicBlock> blocks;
+  for (int group = 0; group < 3; ++group) {
+    NetId base = 100 * group;
+    for (int k = 0; k < 4; ++k) {
+      LogicBlock b(static_cast<int>(blocks.size()), "le");
+      b.use_lut = true;
+      b.input_nets = {base, static_cast<NetId>(base + 1 + k)};
+      if (k > 0)
+        b.input_nets.push_back(base + 10 + k - 1);
+      b.output_net = base + 10 + k;
+      blocks.push_back(std::move(b));
+    }
+  }
+  LogicBlock ram(static_cast<int>(blocks.size()), "ram");
+  ram.type = TileType::BRAM;
+  ram.input_nets = {10};
+  blocks.push_back(std::move(ram));
+
+  auto check_partition = [&](const std::vector<Cluster> &clusters,
+                             size_t max_les, size_t max_inputs) {
+    std::vector<int> seen(blocks.size(), 0);
+    for (const Cluster &c : clusters) {
+      assert(!c.blocks.empty() && c.blocks.size() <= max_les);
+      assert(c.blocks.size() == 1 || c.inputs.size() <= max_inputs);
+      for (int b : c.blocks) {
+        ++seen[b];
+        assert(c.blocks.size() == 1 || blocks[b].type == TileType::CLB);
+      }
+    }
+    assert(std::all_of(seen.begin(), seen.end(), [](int k) { return k == 1; }));
+  };
+
+  std::vector<Cluster> clusters = Packer::cluster(blocks);
+  check_partition(clusters, 4, 10);
+  assert(clusters.size() == 4);
+  for (const Cluster &c : clusters) {
+    if (c.blocks.size() == 1) {
+      assert(blocks[c.blocks[0]].name == "ram");
+      continue;
+    }
+    // A whole group: its shared net and four private ones come from outside
+    assert(c.blocks.size() == 4 && c.inputs.size() == 5);
+    for (int b : c.blocks)
+      assert(b / 4 == c.blocks[0] / 4);
+  }
+
+  // Input pins bound the cluster before its size does
+  PackerOptions narrow;
+  narrow.cluster_inputs = 3;
+  std::vector<Cluster> small = Packer::cluster(blocks, narrow);
+  check_partition(small, 4, 3);
+  assert(small.size() > clusters.size());
+
+  PackerOptions single;
+  single.cluster_les = 1;
+  assert(Packer::cluster(blocks, single).size() == blocks.size());
+
+  std::cout << "Clustering Passed!" << std::endl;
+}
+
+void test_timing_driven_clustering() {
+  std::cout << "Testing Timing-Driven Clustering..." << std::endl;
+
+  // r0 -> c1 -> ... -> c6 -> r7 is the critical path. Each c_k also reads
+  // two primary inputs shared with a LUT d_k off the path, which area-only
+  // attraction prefers.
+  std::vector<LogicBlock> blocks;
+  auto add = [&](const std::string &name, bool lut, bool dff,
+                 std::vector<NetId> inputs, NetId output) {
+    blocks.emplace_back(static_cast<int>(blocks.size()), name);
+    blocks.back().use_lut = lut;
+    blocks.back().use_dff = dff;
+    blocks.back().input_nets = std::move(inputs);
+    blocks.back().output_net = output;
+  };
+  add("r0", false, true, {}, 10);
+  for (NetId k = 1; k <= 6; ++k) {
+    add("c" + std::to_string(k), true, false, {9 + k, 100 + k, 200 + k},
+        10 + k);
+    add("d" + std::to_string(k), true, false, {100 + k, 200 + k}, 300 + k);
+  }
+  add("r7", false, true, {16}, 17);
+
+  std::vector<double> crit = Packer::net_criticality(blocks);
+  assert(crit[10] == 1.0 && crit[13] == 1.0 && crit[16] == 1.0);
+  assert(crit[301] < 0.5 && crit[101] == 0.0);
+
+  PackerOptions area;
+  area.timing_tradeoff = 0;
+  ClusterStats timing_stats, area_stats;
+  std::vector<Cluster> timed = Packer::cluster(blocks, {}, &timing_stats);
+  Packer::cluster(blocks, area, &area_stats);
+
+  // clk-to-q, then six LUTs and seven connections of CLB_LES hops, setup
+  double global = Fabric::CLB_LES * Fabric::HOP_DELAY_PS;
+  assert(timing_stats.path_ps == 100 + 6 * (global + 300) + global + 50);
+  assert(area_stats.path_ps == timing_stats.path_ps);
+  assert(timing_stats.critical_absorbed > area_stats.critical_absorbed);
+  assert(timing_stats.clustered_path_ps < area_stats.clustered_path_ps);
+  assert(timing_stats.path_gain() > area_stats.path_gain());
+  assert(timing_stats.clusters == timed.size());
+
+  // The chain is packed in runs: c1's cluster holds c2 or r0
+  for (const Cluster &c : timed) {
+    if (std::find(c.blocks.begin(), c.blocks.end(), 1) == c.blocks.end())
+      continue;
+    assert(std::find(c.blocks.begin(), c.blocks.end(), 3) != c.blocks.end() ||
+           std::find(c.blocks.begin(), c.blocks.end(), 0) != c.blocks.end());
+  }
+
+  std::cout << "Timing-Driven Clustering Passed!" << std::endl;
+}
+
+void test_lut_decoding() {
+  std::cout << "Testing LUT Decoding..." << std::endl;
+
+  Netlist n;
+  n.add_port("in", PortDirection::INPUT, std::vector<int>{3, 4, 5, 6, 7});
+  add_lut(n, "and3", {3, 4, 5}, 10, "10000000");
+  add_lut(n, "sel", {3, 4, 5}, 11, "11001010"); // 5 ? 4 : 3
+  add_lut(n, "and_one", {4, 1}, 12, "1000");    // 4 & 1 = 4
+  add_lut(n, "twice", {5, 5}, 13, "6");         // 5 ^ 5 = 0 (JSON number)
+  add_lut(n, "or4", {3, 4, 5, 6}, 14, "1111111111111110");
+  n.add_port("out", PortDirection::OUTPUT,
+             std::vector<int>{10, 11, 12, 13, 14});
+
+  std::vector<LogicBlock> blocks = Packer::pack(n);
+  assert(blocks.size() == 5);
+  auto net = [&](int bit) { return *n.find_net(bit); };
+  // Narrow tables repeat over the unused high inputs
+  assert(blocks[0].lut_mask == 0x8080);
+  assert((blocks[0].input_nets == std::vector<NetId>{net(3), net(4), net(5)}));
+  assert(blocks[1].lut_mask == 0xCACA);
+  assert(blocks[2].lut_mask == Fabric::LUT_PASSTHROUGH);
+  assert(blocks[2].input_nets == std::vector<NetId>{net(4)});
+  assert(blocks[3].lut_mask == 0 && blocks[3].input_nets.size() == 1);
+  assert(blocks[4].lut_mask == 0xFFFE && blocks[4].input_nets.size() == 4);
+  for (const auto &b : blocks)
+    assert(b.use_lut && !b.use_dff);
+
+  // Masks the fabric cannot hold are errors, not silently wrong blocks
+  auto rejects = [](Netlist bad) {
+    try {
+      Packer::pack(bad);
+    } catch (const std::runtime_error &) {
+      return true;
+    }
+    return false;
+  };
+  Netlist wide = n;
+  add_lut(wide, "or5", {3, 4, 5, 6, 7}, 15, std::string(31, '1') + "0");
+  assert(rejects(wide));
+  Netlist garbled = n;
+  add_lut(garbled, "bad", {3, 4}, 15, "01x0");
+  assert(rejects(garbled));
+  Netlist mismatch = n;
+  add_lut(mismatch, "narrow", {3, 4}, 15, "1000");
+  mismatch.add_param(*mismatch.find_cell("narrow"), "WIDTH", "3");
+  assert(rejects(mismatch));
+
+  std::cout << "LUT Decoding Passed!" << std::endl;
+}
+
+void test_packed_counter() {
+  std::cout << "Testing Packed Counter Simulation..." << std::endl;
+
+  // 2-bit counter: q0' = !q0, q1' = q1 ^ q0, one LE per bit
+  Netlist n;
+  n.add_port("clk", PortDirection::INPUT, std::vector<int>{2});
+  add_lut(n, "inc0", {3}, 5, "01");
+  add_dff(n, "q0", 5, 3);
+  add_lut(n, "inc1", {4, 3}, 6, "0110");
+  add_dff(n, "q1", 6, 4);
+  n.add_port("count", PortDirection::OUTPUT, std::vector<int>{3, 4});
+
+  std::vector<LogicBlock> blocks = Packer::pack(n);
+  assert(blocks.size() == 2);
+  Fabric fabric(3, 4);
+  auto placement = Placer::place(fabric, blocks, 1, Packer::cluster(blocks));
+  Assembler::assemble(fabric, blocks, placement);
+  fabric.reset();
+  auto bit = [&](int b) {
+    auto pos = placement.at(blocks[b].id);
+    return fabric.get_output(pos.first, pos.second).is_1() ? 1 : 0;
+  };
+  for (int cycle = 0; cycle < 8; ++cycle) {
+    assert(bit(0) + 2 * bit(1) == cycle % 4);
+    fabric.step();
+  }
+
+  std::cout << "Packed Counter Simulation Passed!" << std::endl;
+}
+
 int main() {
   test_packer();
+  test_lut_decoding();
+  test_packed_counter();
+  test_lut_dff_fusion();
+  test_clustering();
+  test_timing_driven_clustering();
   return 0;
 }
@@ -1,6 +1,8 @@
 #include "../src/cad/Parser.hpp"
+#include "../src/utils/ThreadPool.hpp"
 #include <cassert>
 #include <iostream>
+#include <stdexcept>
 
 using namespace vfpga;
 
@@ -32,27 +34,315 @@ void test_parser() {
   assert(netlist.outputs[0] == "led");
 
   // Check Cells
-  assert(netlist.cells.size() == 2);
-  assert(netlist.cells.count("$lut$top$0"));
-  assert(netlist.cells.count("fd"));
+  assert(netlist.num_cells() == 2);
+  assert(netlist.find_cell("$lut$top$0"));
+  assert(netlist.find_cell("fd"));
+  assert(!netlist.find_cell("$lut")); // Interned, but a type, not a cell
 
-  auto lut = netlist.cells["$lut$top$0"];
-  assert(lut->type == "$lut");
+  CellId lut = *netlist.find_cell("$lut$top$0");
+  assert(netlist.cell_type(lut) == "$lut");
   // Check connections
   // A -> net_2 (clk)
   // Y -> net_3 (led)
-  assert(lut->ports.count("A"));
-  assert(lut->ports.at("A").connected_net->name == "net_2");
+  auto a = netlist.find_pin(lut, "A");
+  assert(a);
+  assert(netlist.nets_of(*a).size() == 2); // Both bits
+  assert(netlist.net_name(netlist.net_of(*a)) == "net_2");
 
-  auto dff = netlist.cells["fd"];
-  assert(dff->type == "DFF");
-  assert(dff->ports.at("C").connected_net->name ==
-         "net_2"); // Connected to same clk net
+  CellId dff = *netlist.find_cell("fd");
+  assert(netlist.cell_type(dff) == "DFF");
+  NetId clk = netlist.net_of(*netlist.find_pin(dff, "C"));
+  assert(clk == netlist.net_of(*a)); // Connected to same clk net
+  assert(netlist.net_bit(clk) == 2);
+
+  // Net -> pin adjacency: clk is a top-level input, so it has no driver
+  // and its sinks are both bits of A and the DFF clock (an inout pin, as
+  // "fd" has no port_directions)
+  assert(netlist.num_nets() == 3);
+  assert(netlist.driver(clk) == -1 && netlist.drivers(clk).empty());
+  assert(netlist.fanout(clk) == 3);
+  for (PinId p : netlist.sinks(clk))
+    assert(netlist.pin(p).cell == lut || netlist.pin_name(p) == "C");
+
+  NetId led = *netlist.find_net(3);
+  assert(netlist.pin(netlist.driver(led)).cell == lut);
+  assert(netlist.fanout_cells(lut) == std::vector<CellId>{dff});
+  assert(netlist.fanin_cells(dff) == std::vector<CellId>{lut});
+  assert(netlist.fanin_cells(lut).empty());
 
   std::cout << "Parser Tests Passed!" << std::endl;
 }
 
+void test_parser_key_order_and_errors() {
+  std::cout << "Testing Parser Key Order and Errors..." << std::endl;
+
+  // Cell keys in an unusual order, an unused second module and
+  // non-string parameters
+  auto netlist = Parser::from_json_text(R"({
+    "modules": {
+      "top": {
+        "cells": {
+          "g": {
+            "connections": { "A": [5, "1"], "Y": [6] },
+            "parameters": { "WIDTH": 2, "INIT": "0110", "SCALE": 1.5 },
+            "port_directions": { "Y": "output", "A": "input" },
+            "attributes": { "nested": { "deep": [1, [2, 3]] } },
+            "type": "$lut"
+          }
+        },
+        "ports": { "o": { "bits": [6], "direction": "output" } }
+      },
+      "other": { "cells": { "h": { "type": "DFF" } } }
+    }
+  })");
+  assert(netlist.has_value());
+  assert(netlist->num_cells() == 1);
+  assert(netlist->outputs.size() == 1 && netlist->outputs[0] == "o");
+  CellId g = *netlist->find_cell("g");
+  assert(netlist->cell_type(g) == "$lut");
+  assert(*netlist->param(g, "WIDTH") == "2");
+  assert(*netlist->param(g, "INIT") == "0110");
+  assert(*netlist->param(g, "SCALE") == "1.5");
+  PinId a = *netlist->find_pin(g, "A");
+  assert(netlist->pin(a).direction == PortDirection::INPUT);
+  assert(netlist->nets_of(a).size() == 2); // Constant bits keep their place
+  assert(netlist->nets_of(a)[1] == CONST1_NET);
+  assert(netlist->net_name(netlist->net_of(a)) == "net_5");
+  assert(netlist->pin(*netlist->find_pin(g, "Y")).direction ==
+         PortDirection::OUTPUT);
+  assert(netlist->num_nets() == 2);
+
+  assert(!Parser::from_json_text(R"({"creator": "x"})"));
+  assert(!Parser::from_json_text(R"({"modules": {}})"));
+  assert(!Parser::from_json_text(R"({"modules": {"top": {"cells": {)"));
+  assert(!Parser::from_json_text(
+      R"({"modules": {"top": {"cells": {"c": {"connections": {}}}}}})"));
+  assert(!Parser::from_json("does/not/exist.json"));
+
+  std::cout << "Parser Key Order and Errors Passed!" << std::endl;
+}
+
+void test_hierarchy() {
+  std::cout << "Testing Hierarchy Flattening..." << std::endl;
+
+  // top (marked, but not first) -> 2x pair -> 2x buf -> one LUT
+  const std::string design = R"({
+    "modules": {
+      "buf": {
+        "ports": { "a": { "direction": "input", "bits": [2] },
+                   "y": { "direction": "output", "bits": [3] } },
+        "cells": { "l": { "type": "$lut",
+                          "port_directions": { "A": "input", "Y": "output" },
+                          "connections": { "A": [2], "Y": [3] } } }
+      },
+      "pair": {
+        "ports": { "i": { "direction": "input", "bits": [2] },
+                   "o": { "direction": "output", "bits": [3] } },
+        "cells": { "u0": { "type": "buf", "connections": { "a": [2], "y": [4] } },
+                   "u1": { "type": "buf", "connections": { "a": [4], "y": [3] } } }
+      },
+      "top": {
+        "attributes": { "top": "00000000000000000000000000000001" },
+        "ports": { "in": { "direction": "input", "bits": [2] },
+                   "out": { "direction": "output", "bits": [3] } },
+        "cells": { "p0": { "type": "pair", "connections": { "i": [2], "o": [5] } },
+                   "p1": { "type": "pair", "connections": { "i": [5], "o": [3] } },
+                   "k": { "type": "$lut", "connections": { "A": ["1"], "Y": [6] } } }
+      }
+    }
+  })";
+
+  ThreadPool pool(2);
+  auto netlist = Parser::from_json_text(design, &pool);
+  assert(netlist.has_value());
+  assert(netlist->inputs == std::vector<std::string>{"in"});
+  assert(netlist->outputs == std::vector<std::string>{"out"});
+  assert(netlist->num_cells() == 5);
+
+  // A chain of four LUTs from "in" (bit 2) through bit 5 to "out" (bit 3)
+  const char *chain[] = {"p0.u0.l", "p0.u1.l", "p1.u0.l", "p1.u1.l"};
+  NetId prev = *netlist->find_net(2);
+  for (const char *name : chain) {
+    auto c = netlist->find_cell(name);
+    assert(c && netlist->cell_type(*c) == "$lut");
+    assert(netlist->net_of(*netlist->find_pin(*c, "A")) == prev);
+    prev = netlist->net_of(*netlist->find_pin(*c, "Y"));
+    assert(netlist->pin(netlist->driver(prev)).cell == *c);
+  }
+  assert(prev == *netlist->find_net(3));
+  assert(netlist->net_bit(netlist->net_of(
+             *netlist->find_pin(*netlist->find_cell("p0.u1.l"), "Y"))) == 5);
+  // Internal nets of different instances are distinct
+  NetId inner0 = netlist->net_of(
+      *netlist->find_pin(*netlist->find_cell("p0.u0.l"), "Y"));
+  NetId inner1 = netlist->net_of(
+      *netlist->find_pin(*netlist->find_cell("p1.u0.l"), "Y"));
+  assert(inner0 != inner1 && netlist->net_bit(inner0) > 6);
+  assert(netlist->find_cell("k"));
+
+  // Without the attribute the module nobody instantiates is the top
+  std::string unmarked = design;
+  unmarked.replace(unmarked.find("\"top\": \"0"), 5, "\"tip\"");
+  auto again = Parser::from_json_text(unmarked);
+  assert(again && again->num_cells() == 5);
+
+  // Recursive instantiation is rejected
+  assert(!Parser::from_json_text(R"({"modules": {"a": {
+      "cells": {"self": {"type": "a", "connections": {}}}}}})"));
+
+  std::cout << "Hierarchy Flattening Passed!" << std::endl;
+}
+
+void test_flat_netlist() {
+  std::cout << "Testing Flat Netlist..." << std::endl;
+
+  Netlist netlist;
+  const int n = 1100; // Enough to grow the interner several times
+  // A port declared before the cells, on a bit far beyond the first nets
+  int port_bit[] = {n + 3};
+  netlist.add_port("y", PortDirection::OUTPUT, port_bit);
+  for (int i = 0; i < n; ++i) {
+    CellId c = netlist.add_cell("c" + std::to_string(i), "$lut");
+    netlist.add_param(c, "LUT", "10");
+    int in[] = {i + 2, i + 3}; // Bits 0 and 1 are the constants
+    int out[] = {i + 4};
+    netlist.add_pin(c, "A", PortDirection::INPUT, in);
+    netlist.add_pin(c, "Y", PortDirection::OUTPUT, out);
+  }
+  assert(netlist.num_cells() == n);
+  assert(netlist.num_pins() == 2 * n);
+  assert(netlist.num_nets() == n + 2);
+  assert(netlist.port_nets(0)[0] == *netlist.find_net(n + 3));
+  assert(netlist.drivers(netlist.port_nets(0)[0]).size() == 1);
+  assert(netlist.outputs == std::vector<std::string>{"y"});
+
+  // Pins can only be added to the last cell
+  bool threw = false;
+  try {
+    netlist.add_pin(0, "B", PortDirection::INPUT);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  assert(threw);
+
+  // Copies are independent values
+  Netlist copy = netlist;
+  netlist.add_cell("late", "DFF");
+  assert(copy.num_cells() == n && !copy.find_cell("late"));
+  CellId c500 = *copy.find_cell("c500");
+  assert(copy.cell_name(c500) == "c500" && *copy.param(c500, "LUT") == "10");
+
+  // Bit 504 is driven by c500 and read by c501 and c502, in that order
+  NetId net = *copy.find_net(504);
+  assert(copy.drivers(net).size() == 1);
+  assert(copy.pin(copy.driver(net)).cell == c500);
+  assert(copy.fanout(net) == 2);
+  std::vector<CellId> readers;
+  for (PinId p : copy.sinks(net))
+    readers.push_back(copy.pin(p).cell);
+  assert(readers == (std::vector<CellId>{c500 + 1, c500 + 2}));
+  assert(copy.fanout_cells(c500) == readers);
+  assert(copy.fanin_cells(c500 + 2) ==
+         (std::vector<CellId>{c500, c500 + 1}));
+
+  std::cout << "Flat Netlist Passed!" << std::endl;
+}
+
+void test_blif() {
+  std::cout << "Testing BLIF Frontend..." << std::endl;
+
+  // Covers, a latch, a subcircuit defined later in the file and a black box
+  const std::string design = R"(# comment line
+.model top
+.inputs a b c clk
+.outputs y q s[0] s[1]
+.names a b c \
+  y   # continued line
+1-1 1
+011 1
+.names b c n1
+11 0
+.names vcc
+1
+.latch n1 q re clk 1
+.subckt half x=a y=b s=s[0] c=cout
+.subckt ram addr[1]=a addr[0]=b q=s[1]
+.cname mem0
+.end
+
+.model half
+.inputs x y
+.outputs s c
+.names x y s
+10 1
+01 1
+.names x y c
+11 1
+.end
+
+.model ram
+.inputs addr[0] addr[1]
+.outputs q
+.blackbox
+.end
+)";
+
+  ThreadPool pool(2);
+  auto netlist = Parser::from_blif_text(design, &pool);
+  assert(netlist.has_value());
+  assert(netlist->inputs == (std::vector<std::string>{"a", "b", "c", "clk"}));
+  assert(netlist->outputs == (std::vector<std::string>{"y", "q", "s"}));
+  assert(netlist->num_cells() == 7);
+
+  // y = a&c | !a&b&c over inputs (a, b, c) = A[0..2]: minterms 5, 7, 6
+  CellId y = *netlist->find_cell("y");
+  assert(netlist->cell_type(y) == "$lut");
+  assert(*netlist->param(y, "WIDTH") == "3");
+  assert(*netlist->param(y, "LUT") == "11100000");
+  assert(netlist->nets_of(*netlist->find_pin(y, "A")).size() == 3);
+  // Off-set cover: n1 = !(b & c); a constant has no inputs
+  assert(*netlist->param(*netlist->find_cell("n1"), "LUT") == "0111");
+  CellId vcc = *netlist->find_cell("vcc");
+  assert(*netlist->param(vcc, "LUT") == "1");
+  assert(!netlist->find_pin(vcc, "A"));
+
+  CellId q = *netlist->find_cell("q");
+  assert(netlist->cell_type(q) == "DFF" && *netlist->param(q, "INIT") == "1");
+  NetId n1 = netlist->net_of(*netlist->find_pin(*netlist->find_cell("n1"), "Y"));
+  assert(netlist->net_of(*netlist->find_pin(q, "D")) == n1);
+
+  // The subcircuit is flattened; its ports bind to the instance's nets
+  CellId hs = *netlist->find_cell("half_0.s");
+  assert(netlist->find_cell("half_0.c"));
+  assert(netlist->nets_of(*netlist->find_pin(y, "A"))[0] ==
+         netlist->nets_of(*netlist->find_pin(hs, "A"))[0]);
+
+  // The black box stays a cell, with bus pins grouped and directed
+  CellId mem = *netlist->find_cell("mem0");
+  assert(netlist->cell_type(mem) == "ram");
+  PinId addr = *netlist->find_pin(mem, "addr");
+  assert(netlist->pin(addr).direction == PortDirection::INPUT);
+  auto addr_nets = netlist->nets_of(addr);
+  assert(addr_nets.size() == 2);
+  assert(addr_nets[1] == netlist->nets_of(*netlist->find_pin(y, "A"))[0]);
+  PinId mem_q = *netlist->find_pin(mem, "q");
+  assert(netlist->driver(netlist->net_of(mem_q)) == mem_q);
+
+  // Errors
+  assert(!Parser::from_blif_text(""));
+  assert(!Parser::from_blif_text(".model m\n.names a y\n1x 1\n.end\n"));
+  assert(!Parser::from_blif_text(".model m\n.names a y\n1 1\n0 0\n.end\n"));
+  assert(!Parser::from_blif_text(".model m\n.subckt m x=y\n.end\n"));
+  assert(!Parser::from_blif("does/not/exist.blif"));
+
+  std::cout << "BLIF Frontend Passed!" << std::endl;
+}
+
 int main() {
   test_parser();
+  test_parser_key_order_and_errors();
+  test_hierarchy();
+  test_flat_netlist();
+  test_blif();
   return 0;
 }
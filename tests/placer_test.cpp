@@ -1,8 +1,18 @@
+#include "../src/cad/GlobalPlacer.hpp"
 #include "../src/cad/LogicBlock.hpp"
 #include "../src/cad/Placer.hpp"
 #include "../src/fabric/Fabric.hpp"
+#include "../src/primitives/DFF.hpp"
+#include "../src/primitives/LUT.hpp"
+#include "../src/utils/Philox.hpp"
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <iostream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
 #include <vector>
 
 using namespace vfpga;
@@ -19,10 +29,10 @@ void test_placer_basic() {
 
   std::vector<LogicBlock> blocks;
   blocks.emplace_back(0, "blk0");
-  blocks.back().output_net = "net_1";
+  blocks.back().output_net = 1;
 
   blocks.emplace_back(1, "blk1");
-  blocks.back().input_nets.push_back("net_1");
+  blocks.back().input_nets.push_back(1);
 
   auto placement = Placer::place(fabric, blocks);
 
@@ -50,7 +60,300 @@ void test_placer_basic() {
   std::cout << "Placer Basic Tests Passed!" << std::endl;
 }
 
+void test_placer_clusters() {
+  std::cout << "Testing Placer Clusters..." << std::endl;
+
+  // Three CLB columns of two sites each
+  Fabric fabric(3, 8);
+
+  // Two chains of four blocks, and one block on its own
+  std::vector<LogicBlock> blocks;
+  for (int i = 0; i < 9; ++i) {
+    blocks.emplace_back(i, "blk" + std::to_string(i));
+    blocks.back().output_net = i;
+    if (i % 4 != 0)
+      blocks.back().input_nets.push_back(i - 1);
+  }
+  std::vector<Cluster> clusters(2);
+  clusters[0].blocks = {0, 1, 2, 3};
+  clusters[1].blocks = {7, 6, 5, 4};
+
+  auto placement = Placer::place(fabric, blocks, 7, clusters);
+  assert(placement.size() == blocks.size());
+  // A cluster's blocks take consecutive tiles of one site, in order
+  for (const Cluster &c : clusters) {
+    auto first = placement[c.blocks[0]];
+    assert(first.second % Fabric::CLB_LES == 0);
+    for (size_t k = 0; k < c.blocks.size(); ++k)
+      assert(placement[c.blocks[k]] ==
+             std::make_pair(first.first, first.second + static_cast<int>(k)));
+  }
+  assert(placement[0] != placement[8] && placement[4] != placement[8]);
+  assert(Placer::calculate_cost(blocks, placement) == 6);
+
+  // Sites of two tiles cannot hold them; every block is placed on its own
+  Fabric low(3, 3);
+  auto fallback = Placer::place(low, blocks, 7, clusters);
+  std::set<std::pair<int, int>> tiles;
+  for (const auto &[id, pos] : fallback)
+    tiles.insert(pos);
+  assert(fallback.size() == blocks.size() && tiles.size() == blocks.size());
+
+  std::cout << "Placer Clusters Passed!" << std::endl;
+}
+
+void test_placer_chain() {
+  std::cout << "Testing Placer Chain..." << std::endl;
+
+  // A 64-block chain on a 12x12 fabric folds into a snake of unit hops
+  const int n = 64;
+  Fabric fabric(12, 12);
+  std::vector<LogicBlock> blocks;
+  for (int i = 0; i < n; ++i) {
+    blocks.emplace_back(i, "blk" + std::to_string(i));
+    blocks.back().output_net = i;
+    if (i > 0)
+      blocks.back().input_nets = {i - 1, i - 1}; // Repeated pins count once
+  }
+
+  auto placement = Placer::place(fabric, blocks, 3);
+  std::set<std::pair<int, int>> tiles;
+  for (const auto &[id, pos] : placement) {
+    assert(fabric.get_tile(pos.first, pos.second).type == TileType::CLB);
+    tiles.insert(pos);
+  }
+  assert(tiles.size() == static_cast<size_t>(n));
+  double hpwl = Placer::calculate_cost(blocks, placement);
+  std::cout << "Chain HPWL: " << hpwl << std::endl;
+  assert(hpwl >= n - 1 && hpwl <= 2 * (n - 1));
+
+  // Exiting before the first temperature leaves only the greedy quench
+  PlacerOptions quench;
+  quench.exit_ratio = 1e9;
+  auto greedy = Placer::place(fabric, blocks, 3, {}, quench);
+  assert(greedy.size() == static_cast<size_t>(n));
+  double greedy_hpwl = Placer::calculate_cost(blocks, greedy);
+  std::cout << "Chain HPWL (quench only): " << greedy_hpwl << std::endl;
+  assert(greedy_hpwl > hpwl);
+
+  std::cout << "Placer Chain Passed!" << std::endl;
+}
+
+void test_placer_regions() {
+  std::cout << "Testing Placer Regions..." << std::endl;
+
+  // The chain again in clusters of four, with a BRAM and a DSP block on
+  // their columns, on a 3x3 grid of regions
+  const int n = 64;
+  Fabric fabric(12, 12);
+  std::vector<LogicBlock> blocks;
+  for (int i = 0; i < n; ++i) {
+    blocks.emplace_back(i, "blk" + std::to_string(i));
+    blocks.back().output_net = i;
+    if (i > 0)
+      blocks.back().input_nets = {i - 1};
+  }
+  blocks[10].type = TileType::BRAM;
+  blocks[50].type = TileType::DSP;
+  std::vector<Cluster> clusters(1);
+  for (int i = 0; i < n; ++i) {
+    if (blocks[i].type != TileType::CLB)
+      continue;
+    if (clusters.back().blocks.size() == Fabric::CLB_LES)
+      clusters.emplace_back();
+    clusters.back().blocks.push_back(i);
+  }
+
+  PlacerOptions options;
+  options.regions = 9;
+  options.threads = 1;
+  auto serial = Placer::place(fabric, blocks, 5, clusters, options);
+  std::set<std::pair<int, int>> tiles;
+  for (const auto &[id, pos] : serial) {
+    TileType type = fabric.get_tile(pos.first, pos.second).type;
+    assert(type == (id == 10   ? TileType::BRAM
+                    : id == 50 ? TileType::DSP
+                               : TileType::CLB));
+    tiles.insert(pos);
+  }
+  assert(tiles.size() == static_cast<size_t>(n));
+  for (const Cluster &c : clusters)
+    for (size_t k = 1; k < c.blocks.size(); ++k)
+      assert(serial[c.blocks[k]] ==
+             std::make_pair(serial[c.blocks[0]].first,
+                            serial[c.blocks[0]].second + static_cast<int>(k)));
+  double hpwl = Placer::calculate_cost(blocks, serial);
+  std::cout << "Chain HPWL (9 regions): " << hpwl << std::endl;
+  assert(hpwl <= 3 * (n - 1));
+
+  // The seed alone decides the placement, whatever the number of threads
+  options.threads = 4;
+  assert(Placer::place(fabric, blocks, 5, clusters, options) == serial);
+
+  std::cout << "Placer Regions Passed!" << std::endl;
+}
+
+void test_global_placement() {
+  std::cout << "Testing Global Placement..." << std::endl;
+
+  // A chain of five cells spread onto five slots of a row ends up in order
+  // from any start
+  std::vector<uint32_t> net_first{0, 2, 4, 6, 8};
+  std::vector<int> net_cells{3, 0, 0, 4, 4, 1, 1, 2};
+  auto slots = [](const std::vector<GlobalPlacer::Point> &solved) {
+    std::vector<int> order(solved.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return solved[a] < solved[b]; });
+    std::vector<GlobalPlacer::Point> spread(solved.size());
+    for (size_t i = 0; i < order.size(); ++i)
+      spread[order[i]] = {static_cast<double>(i), 0.0};
+    return spread;
+  };
+  std::vector<GlobalPlacer::Point> start{
+      {0, 0}, {1, 0}, {2, 0}, {3, 0}, {4, 0}};
+  auto chain = GlobalPlacer::place(start, net_first, net_cells, slots);
+  assert(GlobalPlacer::hpwl(net_first, net_cells, chain) == 4);
+
+  // An 8x8 mesh: after global placement the greedy quench alone beats a
+  // random start with the same quench
+  const int w = 8;
+  std::vector<LogicBlock> blocks;
+  for (int i = 0; i < w * w; ++i) {
+    blocks.emplace_back(i, "blk" + std::to_string(i));
+    blocks.back().output_net = i;
+    if (i % w != 0)
+      blocks.back().input_nets.push_back(i - 1);
+    if (i >= w)
+      blocks.back().input_nets.push_back(i - w);
+  }
+  Fabric fabric(12, 12);
+  PlacerOptions quench;
+  quench.exit_ratio = 1e9;
+  auto global = Placer::place(fabric, blocks, 1, {}, quench);
+  std::set<std::pair<int, int>> tiles;
+  for (const auto &[id, pos] : global) {
+    assert(fabric.get_tile(pos.first, pos.second).type == TileType::CLB);
+    tiles.insert(pos);
+  }
+  assert(tiles.size() == blocks.size());
+  quench.global_placement = false;
+  auto random = Placer::place(fabric, blocks, 1, {}, quench);
+  double global_hpwl = Placer::calculate_cost(blocks, global);
+  double random_hpwl = Placer::calculate_cost(blocks, random);
+  std::cout << "Mesh HPWL (quench only): " << global_hpwl << " global, "
+            << random_hpwl << " random" << std::endl;
+  assert(global_hpwl < random_hpwl);
+
+  std::cout << "Global Placement Passed!" << std::endl;
+}
+
+void test_placer_timing() {
+  std::cout << "Testing Placer Timing..." << std::endl;
+
+  // Register -> LUT -> register over 3 + 2 hops
+  std::vector<LogicBlock> path;
+  for (int i = 0; i < 3; ++i) {
+    path.emplace_back(i, "blk" + std::to_string(i));
+    path.back().output_net = i;
+    if (i > 0)
+      path.back().input_nets = {i - 1};
+  }
+  path[1].use_lut = true;
+  path[0].use_dff = path[2].use_dff = true;
+  std::map<int, std::pair<int, int>> at{{0, {0, 0}}, {1, {2, 1}}, {2, {2, 3}}};
+  assert(Placer::critical_path_ps(path, at) ==
+         DFF::DELAY_CLK_Q_PS + 5 * Fabric::HOP_DELAY_PS + LUT<4>::DELAY_PS +
+             DFF::DELAY_SETUP_PS);
+
+  // A random DAG of LUTs with every fourth one registered: trading some
+  // wirelength for timing shortens the critical path
+  const int n = 256;
+  std::mt19937 rng(1);
+  std::vector<LogicBlock> blocks;
+  for (int i = 0; i < n; ++i) {
+    blocks.emplace_back(i, "blk" + std::to_string(i));
+    blocks.back().use_lut = true;
+    blocks.back().use_dff = i % 4 == 0;
+    blocks.back().output_net = i;
+    for (int k = 0; k < 3 && i > 0; ++k)
+      blocks.back().input_nets.push_back(static_cast<NetId>(rng() % i));
+  }
+  Fabric fabric(21, 21);
+  auto timed = Placer::place(fabric, blocks, 1);
+  PlacerOptions wirelength;
+  wirelength.timing_tradeoff = 0;
+  wirelength.congestion_weight = 0;
+  auto untimed = Placer::place(fabric, blocks, 1, {}, wirelength);
+  double timed_ps = Placer::critical_path_ps(blocks, timed);
+  double untimed_ps = Placer::critical_path_ps(blocks, untimed);
+  std::cout << "Critical path: " << timed_ps << " ps timing-driven, "
+            << untimed_ps << " ps for wirelength" << std::endl;
+  assert(timed_ps < 0.8 * untimed_ps);
+
+  std::cout << "Placer Timing Passed!" << std::endl;
+}
+
+void test_placer_seeds() {
+  std::cout << "Testing Placer Seeds..." << std::endl;
+
+  // Philox4x32-10 known answers (Random123)
+  using Block = std::array<uint32_t, 4>;
+  assert((Philox::generate({0, 0, 0, 0}, {0, 0}) ==
+          Block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+  assert((Philox::generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                           {0xa4093822, 0x299f31d0}) ==
+          Block{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+  // Streams of one key differ, and a stream replays
+  Philox a(7, 0), b(7, 1), again(7, 0);
+  std::vector<uint32_t> first, second, replay;
+  for (int i = 0; i < 8; ++i) {
+    first.push_back(a());
+    second.push_back(b());
+    replay.push_back(again());
+  }
+  assert(first != second && first == replay);
+
+  // Without a seed the placement is still the same every time
+  const int n = 64;
+  Fabric fabric(12, 12);
+  std::vector<LogicBlock> blocks;
+  for (int i = 0; i < n; ++i) {
+    blocks.emplace_back(i, "blk" + std::to_string(i));
+    blocks.back().output_net = i;
+    if (i > 0)
+      blocks.back().input_nets = {i - 1, (i * 7) % i};
+  }
+  auto single = Placer::place(fabric, blocks);
+  assert(Placer::place(fabric, blocks, Placer::DEFAULT_SEED) == single);
+
+  // A sweep keeps the best of its runs, the first of which is the single
+  // run, and does not depend on the number of threads either
+  PlacerOptions sweep;
+  sweep.timing_tradeoff = 0;
+  sweep.seeds = 4;
+  sweep.threads = 1;
+  auto serial = Placer::place(fabric, blocks, 3, {}, sweep);
+  sweep.threads = 4;
+  assert(Placer::place(fabric, blocks, 3, {}, sweep) == serial);
+  sweep.seeds = 1;
+  auto first_run = Placer::place(fabric, blocks, 3, {}, sweep);
+  double swept = Placer::calculate_cost(blocks, serial);
+  std::cout << "HPWL: " << swept << " best of 4 seeds, "
+            << Placer::calculate_cost(blocks, first_run) << " one seed"
+            << std::endl;
+  assert(swept <= Placer::calculate_cost(blocks, first_run));
+
+  std::cout << "Placer Seeds Passed!" << std::endl;
+}
+
 int main() {
   test_placer_basic();
+  test_placer_clusters();
+  test_placer_chain();
+  test_placer_regions();
+  test_global_placement();
+  test_placer_timing();
+  test_placer_seeds();
   return 0;
 }
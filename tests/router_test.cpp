@@ -20,10 +20,10 @@ void test_router_basic() {
 
   std::vector<LogicBlock> blocks;
   blocks.emplace_back(0, "blk0");
-  blocks.back().output_net = "net_1";
+  blocks.back().output_net = 1;
 
   blocks.emplace_back(1, "blk1");
-  blocks.back().input_nets.push_back("net_1");
+  blocks.back().input_nets.push_back(1);
 
   std::map<int, std::pair<int, int>> placement;
   placement[0] = {0, 0};